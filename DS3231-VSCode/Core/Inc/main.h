@@ -59,6 +59,9 @@ void Error_Handler(void);
 /* Private defines -----------------------------------------------------------*/
 #define MCO_Pin GPIO_PIN_0
 #define MCO_GPIO_Port GPIOF
+#define DS3231_SQW_Pin GPIO_PIN_1
+#define DS3231_SQW_GPIO_Port GPIOA
+#define DS3231_SQW_EXTI_IRQn EXTI0_1_IRQn
 #define USART2_TX_Pin GPIO_PIN_2
 #define USART2_TX_GPIO_Port GPIOA
 #define USART2_RX_Pin GPIO_PIN_3
@@ -23,6 +23,7 @@
 /* USER CODE BEGIN Includes */
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 
 #include "ds3231.h"
 /* USER CODE END Includes */
@@ -34,6 +35,12 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define DS3231_SNAPSHOT_PERIOD_MS   (100U)  // period of the register map snapshots
+#define DS3231_PRINT_PERIOD_MS      (5000U) // period of printing the register map
+#define DS3231_TEMP_SAMPLE_PERIOD_MS (1000U) // period of the temperature samples
+#define DS3231_HEARTBEAT_PERIOD_S   (60U)   // period of the heartbeat timer on Alarm 1
+#define DS3231_CLOCK_USE_32KHZ      (1)     // interpolate the time with the 32 kHz output counted by TIM2, with HAL_GetTick otherwise
+#define DS3231_CLOCK_32KHZ_HZ       (32768U)
 #define DS3231_I2C_DEV_ADDR 0x68
 /* USER CODE END PD */
 
@@ -44,31 +51,63 @@ DS3231_I2C_DEVICE_DEFINE(clock_chip, "DS3231")
 
 /* Private variables ---------------------------------------------------------*/
 I2C_HandleTypeDef hi2c1;
+DMA_HandleTypeDef hdma_i2c1_rx;
 
 UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN PV */
 uint8_t debug_buf[100];
+static ds3231_snapshot_t clock_snapshot;
+static ds3231_clock_t clock_time;
+static ds3231_sqw_t clock_sqw;
+static ds3231_temp_t clock_temp;
+static ds3231_temp_stream_t clock_temp_stream;
+static ds3231_timer_service_t clock_timers;
+static ds3231_timer_t heartbeat_timer;
+static uint32_t snapshot_updates = 0;
+static uint32_t alarm_matches[2] = {0};
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_I2C1_Init(void);
 static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
 static EMBEDD_RESULT ds3231_bus_write(const struct embedd_device_t* dev, const uint8_t* data_ptr, uint32_t data_size);
 static EMBEDD_RESULT ds3231_bus_read(const struct embedd_device_t* dev, uint8_t* data_ptr, uint32_t data_size);
+static EMBEDD_RESULT ds3231_bus_writev(const struct embedd_device_t* dev, const embedd_bus_iovec_t* iov, uint32_t iov_count);
+static EMBEDD_RESULT ds3231_bus_write_read(const struct embedd_device_t* dev, const uint8_t* wr_ptr, uint32_t wr_size, uint8_t* rd_ptr, uint32_t rd_size);
+static EMBEDD_RESULT ds3231_bus_write_async(const struct embedd_device_t* dev, const uint8_t* data_ptr, uint32_t data_size, embedd_bus_done_t done);
+static EMBEDD_RESULT ds3231_bus_write_read_async(const struct embedd_device_t* dev, const uint8_t* wr_ptr, uint32_t wr_size, uint8_t* rd_ptr, uint32_t rd_size, embedd_bus_done_t done);
+#if DS3231_CLOCK_USE_32KHZ
+static void ds3231_clock_timer_init(void);
+static uint32_t ds3231_clock_timer_ticks(void);
+#endif
 
 static void debug(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+static void debug_temperature(const char *name, int16_t quarters);
+static void heartbeat(ds3231_timer_t *timer);
+static void on_snapshot_updated(struct EventSource *ev);
+static void on_temperature_ready(struct EventSource *ev);
+static void on_alarm_match(struct EventSource *ev);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 static embedd_bus_t ds3231_bus = {
     .write = ds3231_bus_write,
-    .read = ds3231_bus_read
+    .read = ds3231_bus_read,
+    .writev = ds3231_bus_writev,
+    .write_read = ds3231_bus_write_read,
+    .write_async = ds3231_bus_write_async,
+    .write_read_async = ds3231_bus_write_read_async
 };
+
+//Device and completion callback of the asynchronous transfer in flight on I2C1
+static const struct embedd_device_t* ds3231_bus_async_dev = NULL;
+static embedd_bus_done_t ds3231_bus_async_done = NULL;
 /* USER CODE END 0 */
 
 /**
@@ -100,9 +139,20 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_I2C1_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
+  /* Completions of the driver are reported by events, handled in the main loop */
+  embedd_event_manager_init();
+  if ((embedd_event_manager_register_callback(DS3231_SNAPSHOT_UPDATED_EVENT_ID, on_snapshot_updated) != EMBEDD_RESULT_OK) ||
+      (embedd_event_manager_register_callback(DS3231_TEMPERATURE_READY_EVENT_ID, on_temperature_ready) != EMBEDD_RESULT_OK) ||
+      (embedd_event_manager_register_callback(DS3231_ALARM_1_MATCH_EVENT_ID, on_alarm_match) != EMBEDD_RESULT_OK) ||
+      (embedd_event_manager_register_callback(DS3231_ALARM_2_MATCH_EVENT_ID, on_alarm_match) != EMBEDD_RESULT_OK))
+    {
+        debug("Event callbacks registering error!\r\n");
+    }
+
   /* Assign the I2C bus object to the device object */
   clock_chip.bus = &ds3231_bus;
 
@@ -110,86 +160,163 @@ int main(void)
   embedd_i2c_dev_cfg_t clock_chip_cfg = {.addr = DS3231_I2C_DEV_ADDR};
   embedd_i2c_set_dev_config(&clock_chip, &clock_chip_cfg);
 
-  /* Clear the time keeping registers */
-  uint8_t reg_value = 0;
-   if (DS3231_WRITE_REG( clock_chip, ds3231_seconds,      reg_value ) == EMBEDD_RESULT_OK &&
-       DS3231_WRITE_REG( clock_chip, ds3231_minutes,      reg_value ) == EMBEDD_RESULT_OK &&
-       DS3231_WRITE_REG( clock_chip, ds3231_hour,         reg_value ) == EMBEDD_RESULT_OK &&
-       DS3231_WRITE_REG( clock_chip, ds3231_day,          reg_value ) == EMBEDD_RESULT_OK &&
-       DS3231_WRITE_REG( clock_chip, ds3231_date,         reg_value ) == EMBEDD_RESULT_OK &&
-       DS3231_WRITE_REG( clock_chip, ds3231_monthcentury, reg_value ) == EMBEDD_RESULT_OK &&
-       DS3231_WRITE_REG( clock_chip, ds3231_year,         reg_value ) == EMBEDD_RESULT_OK)
+  /* Reset the clock to 2000-01-01 00:00:00 */
+  ds3231_datetime_t datetime = {.year = DS3231_DATETIME_YEAR_MIN, .month = 1, .date = 1, .day = 1};
+  if (ds3231_set_datetime(&clock_chip, &datetime) == EMBEDD_RESULT_OK)
     {
         debug("Clock has been successfully reset\r\n");
     }
 
+  /* Latch the time once, timestamps are interpolated without bus traffic afterwards */
+#if DS3231_CLOCK_USE_32KHZ
+  DS3231_SET_FIELD(clock_chip, ds3231_status, en32khz, DS3231_CONTROLSTATUS_EN32KHZ_ENABLED);
+  ds3231_clock_timer_init();
+  ds3231_clock_init(&clock_time, &clock_chip, ds3231_clock_timer_ticks, DS3231_CLOCK_32KHZ_HZ);
+#else
+  ds3231_clock_init(&clock_time, &clock_chip, HAL_GetTick, 1000U);
+#endif
+  if (ds3231_clock_latch(&clock_time) != EMBEDD_RESULT_OK)
+    {
+        debug("Clock latching error!\r\n");
+    }
+
+  /* Capture the second boundaries of the device on the 1 Hz square wave */
+#if DS3231_CLOCK_USE_32KHZ
+  ds3231_sqw_init(&clock_sqw, &clock_chip, ds3231_clock_timer_ticks);
+#else
+  ds3231_sqw_init(&clock_sqw, &clock_chip, HAL_GetTick);
+#endif
+  if (ds3231_sqw_enable(&clock_sqw) != EMBEDD_RESULT_OK)
+    {
+        debug("Square wave enabling error!\r\n");
+    }
+
+  /* Keep a snapshot of the register map updated in the background */
+  ds3231_snapshot_init(&clock_snapshot, &clock_chip, DS3231_SNAPSHOT_PERIOD_MS);
+
+  /* Sample the temperature into a stream reduced to statistics on the device */
+  ds3231_temp_init(&clock_temp, &clock_chip, DS3231_TEMP_POLL_MS);
+  ds3231_temp_stream_init(&clock_temp_stream, NULL, 0);
+  uint32_t temp_tick = HAL_GetTick();
+  ds3231_temp_start(&clock_temp, temp_tick);
+  uint32_t print_tick = HAL_GetTick();
+
+  /* Schedule the timers on Alarm 1, a heartbeat once a minute */
+  int64_t epoch;
+  ds3231_timer_service_init(&clock_timers, &clock_chip);
+  ds3231_timer_init(&heartbeat_timer, heartbeat, NULL);
+  if ((ds3231_clock_get_epoch(&clock_time, &epoch) != EMBEDD_RESULT_OK) ||
+      (ds3231_timer_start(&clock_timers, &heartbeat_timer, epoch + DS3231_HEARTBEAT_PERIOD_S, DS3231_HEARTBEAT_PERIOD_S) != EMBEDD_RESULT_OK))
+    {
+        debug("Timer starting error!\r\n");
+    }
+
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-    uint8_t seconds_reg         = 0;
-    uint8_t minutes_reg         = 0;
-    uint8_t hour_reg            = 0;
-    uint8_t day_reg             = 0;
-    uint8_t date_reg            = 0;
-    uint8_t monthcentury_reg    = 0;
-    uint8_t year_reg            = 0;
-    uint8_t alarm_1_seconds_reg = 0;
-    uint8_t alarm_1_minutes_reg = 0;
-    uint8_t alarm_1_hour_reg    = 0;
-    uint8_t alarm_1_daydate_reg = 0;
-    uint8_t alarm_2_minutes_reg = 0;
-    uint8_t alarm_2_hour_reg    = 0;
-    uint8_t alarm_2_daydate_reg = 0;
-    uint8_t control_reg         = 0;
-    uint8_t status_reg          = 0;
-    uint8_t aging_offset_reg    = 0;
-    uint8_t msb_of_temp_reg     = 0;
-    uint8_t lsb_of_temp_reg     = 0;
-
-    // Read all registers
-    if (DS3231_READ_REG( clock_chip, ds3231_seconds,         seconds_reg )         == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_minutes,         minutes_reg )         == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_hour,            hour_reg )            == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_day,             day_reg )             == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_date,            date_reg )            == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_monthcentury,    monthcentury_reg )    == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_year,            year_reg )            == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_alarm_1_seconds, alarm_1_seconds_reg ) == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_alarm_1_minutes, alarm_1_minutes_reg ) == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_alarm_1_hour,    alarm_1_hour_reg )    == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_alarm_1_daydate, alarm_1_daydate_reg ) == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_alarm_2_minutes, alarm_2_minutes_reg ) == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_alarm_2_hour,    alarm_2_hour_reg )    == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_alarm_2_daydate, alarm_2_daydate_reg ) == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_control,         control_reg )         == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_status,          status_reg )          == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_aging_offset,    aging_offset_reg )    == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_msb_of_temp,     msb_of_temp_reg )     == EMBEDD_RESULT_OK &&
-        DS3231_READ_REG( clock_chip, ds3231_lsb_of_temp,     lsb_of_temp_reg )     == EMBEDD_RESULT_OK)
+    ds3231_snapshot_process(&clock_snapshot, HAL_GetTick());
+    ds3231_clock_process(&clock_time);
+
+    // Completed conversions are fed to the stream by on_temperature_ready, one is started per sample period
+    ds3231_temp_process(&clock_temp, HAL_GetTick());
+    if (!ds3231_temp_busy(&clock_temp) && ((uint32_t)(HAL_GetTick() - temp_tick) >= DS3231_TEMP_SAMPLE_PERIOD_MS))
+    {
+      temp_tick += DS3231_TEMP_SAMPLE_PERIOD_MS;
+      ds3231_temp_start(&clock_temp, HAL_GetTick());
+    }
+
+    ds3231_timer_process(&clock_timers);
+
+    // Assign the time to the captured seconds once the first edge is there
+    if (!clock_sqw.synced)
+    {
+      ds3231_sqw_sync(&clock_sqw);
+    }
+
+    // Trigger the event of a transfer completed by the I2C interrupt, then call the handlers of the events triggered by the driver
+    ds3231_async_process(&clock_chip);
+    embedd_event_manager_process();
+
+    if ((uint32_t)(HAL_GetTick() - print_tick) < DS3231_PRINT_PERIOD_MS)
+    {
+      continue;
+    }
+    print_tick += DS3231_PRINT_PERIOD_MS;
+
+    debug("Events: %lu snapshots, %lu alarm 1 and %lu alarm 2 matches\r\n", (unsigned long)snapshot_updates,
+          (unsigned long)alarm_matches[0], (unsigned long)alarm_matches[1]);
+
+    uint64_t now_us = ds3231_clock_now_us(&clock_time);
+    debug("Interpolated time: %lu.%06lu\r\n", (unsigned long)(now_us / 1000000U), (unsigned long)(now_us % 1000000U));
+
+    ds3231_clock_stats_t clock_stats;
+    if (ds3231_clock_get_stats(&clock_time, &clock_stats) == EMBEDD_RESULT_OK)
+    {
+      debug("Clock: %lu reads avoided, %lu resyncs, max divergence %lu us, drift %ld ppb\r\n",
+            (unsigned long)clock_stats.reads_avoided, (unsigned long)clock_stats.resyncs,
+            (unsigned long)clock_stats.max_divergence_us, (long)clock_stats.drift_ppb);
+    }
+
+    int16_t quarters;
+    if (ds3231_temp_get(&clock_temp, &quarters) == EMBEDD_RESULT_OK)
+    {
+      debug_temperature("Temperature", quarters);
+    }
+
+    // Only the statistics of the window are sent instead of every sample
+    const ds3231_temp_stream_stats_t *temp_stats = ds3231_temp_stream_stats(&clock_temp_stream);
+    if (temp_stats != NULL)
+    {
+      debug("Temperature window %lu, variance %lu mC^2\r\n", (unsigned long)temp_stats->window,
+            (unsigned long)ds3231_temp_stream_var_to_mdeg2(temp_stats->var));
+      debug_temperature("  mean", ds3231_temp_stream_to_quarters(temp_stats->mean));
+      debug_temperature("  max", ds3231_temp_stream_to_quarters(temp_stats->max));
+    }
+
+    ds3231_sqw_edge_t edges[DS3231_SQW_EDGE_COUNT];
+    uint32_t edge_count = 0;
+    if ((ds3231_sqw_get_edges(&clock_sqw, edges, DS3231_SQW_EDGE_COUNT, &edge_count) == EMBEDD_RESULT_OK) && (edge_count > 1))
+    {
+      // Ticks per second of the device over the captured edges
+      uint32_t seconds = edges[edge_count - 1].second - edges[0].second;
+      uint32_t ticks = edges[edge_count - 1].tick - edges[0].tick;
+      debug("Second boundary at tick %lu, %lu ticks in %lu s\r\n", (unsigned long)edges[edge_count - 1].tick,
+            (unsigned long)ticks, (unsigned long)seconds);
+    }
+
+    uint8_t regs[DS3231_REGISTER_MAP_SIZE] = {0};
+
+    // Copy the latest register map, the bus is not touched
+    if (ds3231_snapshot_read(&clock_snapshot, regs, NULL) == EMBEDD_RESULT_OK)
     {
       /* USER CODE BEGIN IN CASE OF SUCCESS */
+      if (ds3231_datetime_from_regs((const ds3231_time_regs_t*)regs, &datetime) == EMBEDD_RESULT_OK)
+      {
+        debug("Date and time: %04u-%02u-%02u %02u:%02u:%02u\r\n", datetime.year, datetime.month, datetime.date,
+              datetime.hour, datetime.minutes, datetime.seconds);
+      }
       debug("Register map:\r\n");
-      debug("  SECONDS           - 0x%02X\r\n", seconds_reg);
-      debug("  MINUTES           - 0x%02X\r\n", minutes_reg);
-      debug("  HOUR              - 0x%02X\r\n", hour_reg);
-      debug("  DAY               - 0x%02X\r\n", day_reg);
-      debug("  DATE              - 0x%02X\r\n", date_reg);
-      debug("  MONTH_CENTURY     - 0x%02X\r\n", monthcentury_reg);
-      debug("  YEAR              - 0x%02X\r\n", year_reg);
-      debug("  ALARM_1_SECONDS   - 0x%02X\r\n", alarm_1_seconds_reg);
-      debug("  ALARM_1_MINUTES   - 0x%02X\r\n", alarm_1_minutes_reg);
-      debug("  ALARM_1_HOUR      - 0x%02X\r\n", alarm_1_hour_reg);
-      debug("  ALARM_2_MINUTES   - 0x%02X\r\n", alarm_2_minutes_reg);
-      debug("  ALARM_2_HOUR      - 0x%02X\r\n", alarm_2_hour_reg);
-      debug("  ALARM_2_DAY_DATE  - 0x%02X\r\n", alarm_2_daydate_reg);
-      debug("  CONTROL           - 0x%02X\r\n", control_reg);
-      debug("  STATUS            - 0x%02X\r\n", status_reg);
-      debug("  AGING_OFFSET      - 0x%02X\r\n", aging_offset_reg);
-      debug("  TEMPERATURE_MSB   - 0x%02X\r\n", msb_of_temp_reg);
-      debug("  TEMPERATURE_LSB   - 0x%02X\r\n", lsb_of_temp_reg);
+      debug("  SECONDS           - 0x%02X\r\n", regs[ds3231_seconds_read_reg_addr]);
+      debug("  MINUTES           - 0x%02X\r\n", regs[ds3231_minutes_read_reg_addr]);
+      debug("  HOUR              - 0x%02X\r\n", regs[ds3231_hour_read_reg_addr]);
+      debug("  DAY               - 0x%02X\r\n", regs[ds3231_day_read_reg_addr]);
+      debug("  DATE              - 0x%02X\r\n", regs[ds3231_date_read_reg_addr]);
+      debug("  MONTH_CENTURY     - 0x%02X\r\n", regs[ds3231_monthcentury_read_reg_addr]);
+      debug("  YEAR              - 0x%02X\r\n", regs[ds3231_year_read_reg_addr]);
+      debug("  ALARM_1_SECONDS   - 0x%02X\r\n", regs[ds3231_alarm_1_seconds_read_reg_addr]);
+      debug("  ALARM_1_MINUTES   - 0x%02X\r\n", regs[ds3231_alarm_1_minutes_read_reg_addr]);
+      debug("  ALARM_1_HOUR      - 0x%02X\r\n", regs[ds3231_alarm_1_hour_read_reg_addr]);
+      debug("  ALARM_2_MINUTES   - 0x%02X\r\n", regs[ds3231_alarm_2_minutes_read_reg_addr]);
+      debug("  ALARM_2_HOUR      - 0x%02X\r\n", regs[ds3231_alarm_2_hour_read_reg_addr]);
+      debug("  ALARM_2_DAY_DATE  - 0x%02X\r\n", regs[ds3231_alarm_2_daydate_read_reg_addr]);
+      debug("  CONTROL           - 0x%02X\r\n", regs[ds3231_control_read_reg_addr]);
+      debug("  STATUS            - 0x%02X\r\n", regs[ds3231_status_read_reg_addr]);
+      debug("  AGING_OFFSET      - 0x%02X\r\n", regs[ds3231_aging_offset_read_reg_addr]);
+      debug("  TEMPERATURE_MSB   - 0x%02X\r\n", regs[ds3231_msb_of_temp_read_reg_addr]);
+      debug("  TEMPERATURE_LSB   - 0x%02X\r\n", regs[ds3231_lsb_of_temp_read_reg_addr]);
       /* USER CODE END IN CASE OF SUCCESS */
     }
     else
@@ -198,7 +325,6 @@ int main(void)
       debug("Registers reading error!\r\n");
       /* USER CODE END IN CASE OF ERROR */
     }
-    HAL_Delay(5000); // Wait 5 seconds before reading again
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -342,6 +468,22 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel1_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -362,6 +504,12 @@ static void MX_GPIO_Init(void)
   /*Configure GPIO pin Output Level */
   HAL_GPIO_WritePin(LED_GREEN_GPIO_Port, LED_GREEN_Pin, GPIO_PIN_RESET);
 
+  /*Configure GPIO pin : DS3231_SQW_Pin */
+  GPIO_InitStruct.Pin = DS3231_SQW_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
+  HAL_GPIO_Init(DS3231_SQW_GPIO_Port, &GPIO_InitStruct);
+
   /*Configure GPIO pin : LED_GREEN_Pin */
   GPIO_InitStruct.Pin = LED_GREEN_Pin;
   GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
@@ -369,6 +517,10 @@ static void MX_GPIO_Init(void)
   GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
   HAL_GPIO_Init(LED_GREEN_GPIO_Port, &GPIO_InitStruct);
 
+  /* EXTI interrupt init*/
+  HAL_NVIC_SetPriority(EXTI0_1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(EXTI0_1_IRQn);
+
 /* USER CODE BEGIN MX_GPIO_Init_2 */
 /* USER CODE END MX_GPIO_Init_2 */
 }
@@ -421,11 +573,235 @@ EMBEDD_RESULT ds3231_bus_read(const struct embedd_device_t* dev, uint8_t* data_p
   return EMBEDD_RESULT_OK;
 }
 
+EMBEDD_RESULT ds3231_bus_writev(const struct embedd_device_t* dev, const embedd_bus_iovec_t* iov, uint32_t iov_count)
+{
+  if( ( dev == NULL ) || ( iov == NULL ) || ( iov_count == 0 ) )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //A single segment is an ordinary write
+  if( iov_count == 1 )
+  {
+      return ds3231_bus_write( dev, iov[0].data_ptr, iov[0].data_size );
+  }
+
+  //Two segments are sent as memory address and data, the peripheral sends them back to back
+  if( ( iov_count != 2 ) || ( iov[0].data_size == 0 ) || ( iov[0].data_size > 2 ) )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //Extracting I2C configurations from the device object
+  embedd_i2c_dev_cfg_t* dev_cfg = embedd_i2c_get_dev_config( dev );
+  if( dev_cfg == NULL )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  const uint8_t* mem_addr_ptr = iov[0].data_ptr;
+  uint16_t mem_addr = mem_addr_ptr[0];
+  uint16_t mem_addr_size = I2C_MEMADD_SIZE_8BIT;
+  if( iov[0].data_size == 2 )
+  {
+      mem_addr = ( mem_addr << 8 ) | mem_addr_ptr[1];
+      mem_addr_size = I2C_MEMADD_SIZE_16BIT;
+  }
+
+  //Writing data to the bus
+  HAL_StatusTypeDef status = HAL_I2C_Mem_Write(&hi2c1, (dev_cfg->addr << 1), mem_addr, mem_addr_size, iov[1].data_ptr, iov[1].data_size, 100);
+  if( status != HAL_OK)
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_bus_write_read(const struct embedd_device_t* dev, const uint8_t* wr_ptr, uint32_t wr_size, uint8_t* rd_ptr, uint32_t rd_size)
+{
+  if( ( dev == NULL ) || ( wr_ptr == NULL ) || ( rd_ptr == NULL ) )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //The written part is sent as memory address, so it is limited to 1 or 2 bytes
+  if( ( wr_size == 0 ) || ( wr_size > 2 ) )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //Extracting I2C configurations from the device object
+  embedd_i2c_dev_cfg_t* dev_cfg = embedd_i2c_get_dev_config( dev );
+  if( dev_cfg == NULL )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  uint16_t mem_addr = wr_ptr[0];
+  uint16_t mem_addr_size = I2C_MEMADD_SIZE_8BIT;
+  if( wr_size == 2 )
+  {
+      mem_addr = ( mem_addr << 8 ) | wr_ptr[1];
+      mem_addr_size = I2C_MEMADD_SIZE_16BIT;
+  }
+
+  //Writing the address and reading data back after a repeated start
+  HAL_StatusTypeDef status = HAL_I2C_Mem_Read(&hi2c1, (dev_cfg->addr << 1), mem_addr, mem_addr_size, rd_ptr, rd_size, 100);
+  if( status != HAL_OK)
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_bus_write_async(const struct embedd_device_t* dev, const uint8_t* data_ptr, uint32_t data_size, embedd_bus_done_t done)
+{
+  if( ( dev == NULL ) || ( data_ptr == NULL ) || ( done == NULL ) )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //Extracting I2C configurations from the device object
+  embedd_i2c_dev_cfg_t* dev_cfg = embedd_i2c_get_dev_config( dev );
+  if( dev_cfg == NULL )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //Starting the transfer, completion is reported by HAL_I2C_MasterTxCpltCallback or HAL_I2C_ErrorCallback
+  ds3231_bus_async_dev = dev;
+  ds3231_bus_async_done = done;
+  HAL_StatusTypeDef status = HAL_I2C_Master_Transmit_IT(&hi2c1, (dev_cfg->addr << 1), (uint8_t*)data_ptr, data_size);
+  if( status != HAL_OK)
+  {
+      ds3231_bus_async_done = NULL;
+      return EMBEDD_RESULT_ERR;
+  }
+
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_bus_write_read_async(const struct embedd_device_t* dev, const uint8_t* wr_ptr, uint32_t wr_size, uint8_t* rd_ptr, uint32_t rd_size, embedd_bus_done_t done)
+{
+  if( ( dev == NULL ) || ( wr_ptr == NULL ) || ( rd_ptr == NULL ) || ( done == NULL ) )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //The written part is sent as memory address, so it is limited to 1 or 2 bytes
+  if( ( wr_size == 0 ) || ( wr_size > 2 ) )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  //Extracting I2C configurations from the device object
+  embedd_i2c_dev_cfg_t* dev_cfg = embedd_i2c_get_dev_config( dev );
+  if( dev_cfg == NULL )
+  {
+      return EMBEDD_RESULT_ERR;
+  }
+
+  uint16_t mem_addr = wr_ptr[0];
+  uint16_t mem_addr_size = I2C_MEMADD_SIZE_8BIT;
+  if( wr_size == 2 )
+  {
+      mem_addr = ( mem_addr << 8 ) | wr_ptr[1];
+      mem_addr_size = I2C_MEMADD_SIZE_16BIT;
+  }
+
+  //Starting the transfer, the data is moved by DMA, completion is reported by HAL_I2C_MemRxCpltCallback or HAL_I2C_ErrorCallback
+  ds3231_bus_async_dev = dev;
+  ds3231_bus_async_done = done;
+  HAL_StatusTypeDef status = HAL_I2C_Mem_Read_DMA(&hi2c1, (dev_cfg->addr << 1), mem_addr, mem_addr_size, rd_ptr, rd_size);
+  if( status != HAL_OK)
+  {
+      ds3231_bus_async_done = NULL;
+      return EMBEDD_RESULT_ERR;
+  }
+
+  return EMBEDD_RESULT_OK;
+}
+
+static void ds3231_bus_async_complete(I2C_HandleTypeDef *hi2c, EMBEDD_RESULT result)
+{
+  if( ( hi2c != &hi2c1 ) || ( ds3231_bus_async_done == NULL ) )
+  {
+      return;
+  }
+
+  embedd_bus_done_t done = ds3231_bus_async_done;
+  ds3231_bus_async_done = NULL;
+  done( ds3231_bus_async_dev, result );
+}
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  ds3231_bus_async_complete( hi2c, EMBEDD_RESULT_OK );
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  ds3231_bus_async_complete( hi2c, EMBEDD_RESULT_OK );
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+  ds3231_bus_async_complete( hi2c, EMBEDD_RESULT_ERR );
+}
+
+#if DS3231_CLOCK_USE_32KHZ
+void ds3231_clock_timer_init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  //The 32kHz output of the DS3231 is open drain, wired to PA0 which is TIM2_ETR
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+  GPIO_InitStruct.Pin = GPIO_PIN_0;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  GPIO_InitStruct.Alternate = GPIO_AF2_TIM2;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+  //TIM2 is 32 bits wide, counting rising edges on ETR in external clock mode 2
+  __HAL_RCC_TIM2_CLK_ENABLE();
+  TIM2->CR1 = 0;
+  TIM2->SMCR = TIM_SMCR_ECE;
+  TIM2->PSC = 0;
+  TIM2->ARR = 0xFFFFFFFFU;
+  TIM2->EGR = TIM_EGR_UG;
+  TIM2->CR1 = TIM_CR1_CEN;
+}
+
+uint32_t ds3231_clock_timer_ticks(void)
+{
+  return TIM2->CNT;
+}
+#endif
+
+void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin)
+{
+  //The seconds register of the DS3231 is incremented on the falling edge of its 1 Hz square wave
+  if( GPIO_Pin == DS3231_SQW_Pin )
+  {
+      ds3231_sqw_capture( &clock_sqw );
+      // INTCN is cleared for the square wave, so the alarm flag is checked once per second
+      ds3231_timer_signal( &clock_timers );
+  }
+}
+
 void embedd_hal_sleep( uint32_t mseconds )
 {
     HAL_Delay(mseconds);
 }
 
+uint32_t embedd_hal_get_ticks( void )
+{
+    return HAL_GetTick();
+}
+
 void debug(const char *format, ...)
 {
     va_list args;
@@ -436,6 +812,36 @@ void debug(const char *format, ...)
 
     HAL_UART_Transmit(&huart2, debug_buf, debug_msg_size, 100);
 }
+
+static void heartbeat(ds3231_timer_t *timer)
+{
+    debug("Heartbeat, next at %ld\r\n", (long)timer->deadline);
+}
+
+static void on_snapshot_updated(struct EventSource *ev)
+{
+    ++snapshot_updates;
+}
+
+static void on_temperature_ready(struct EventSource *ev)
+{
+    int16_t quarters;
+    if (ds3231_temp_get(&clock_temp, &quarters) == EMBEDD_RESULT_OK)
+    {
+        ds3231_temp_stream_add(&clock_temp_stream, quarters);
+    }
+}
+
+static void on_alarm_match(struct EventSource *ev)
+{
+    ++alarm_matches[(ev->event_id == DS3231_ALARM_1_MATCH_EVENT_ID) ? 0 : 1];
+}
+
+static void debug_temperature(const char *name, int16_t quarters)
+{
+    // Quarters of a degree printed with two decimals, the sign kept for -0.75 - -0.25
+    debug("%s: %s%d.%02d C\r\n", name, (quarters < 0) ? "-" : "", abs(quarters) / 4, (abs(quarters) % 4) * 25);
+}
 /* USER CODE END 4 */
 
 /**
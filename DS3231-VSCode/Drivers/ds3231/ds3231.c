@@ -25,4 +25,9 @@
 const ds3231_api_t ds3231_api = {
   .ds3231_write_reg = &ds3231_write_reg,
   .ds3231_read_reg = &ds3231_read_reg,
+  .ds3231_read_regs = &ds3231_read_regs,
+  .ds3231_write_regs = &ds3231_write_regs,
+  .ds3231_write_reg_async = &ds3231_write_reg_async,
+  .ds3231_read_reg_async = &ds3231_read_reg_async,
+  .ds3231_read_regs_async = &ds3231_read_regs_async,
 };
@@ -34,9 +34,20 @@
 #include "embedd_event_types.h"
 #include "event_manager_cfg.h"
 #include "embedd_misc.h"
+#include "ds3231_cfg.h"
 #include "ds3231_data_types.h"
 #include "ds3231_events.h"
 #include "ds3231_registers.h"
+#include "ds3231_fields.h"
+#include "ds3231_snapshot.h"
+#include "ds3231_datetime.h"
+#include "ds3231_clock.h"
+#include "ds3231_sqw.h"
+#include "ds3231_aging.h"
+#include "ds3231_temp.h"
+#include "ds3231_temp_stream.h"
+#include "ds3231_alarm.h"
+#include "ds3231_timer.h"
 
 /*!
  * \var ds3231_api
@@ -70,6 +81,101 @@ extern const ds3231_api_t ds3231_api;
   _typename##_read_reg_addr, &(var), \
   sizeof(_typename), _typename##_delay)
 
+/*!
+ * \macro DS3231_WRITE_REG_ASYNC
+ * \brief start writing a register, \a event_id is triggered when it is completed
+ *
+ * \param dev device object,
+ * \param _typename typename for register
+ * \param var variable for writing data
+ * \param event_id event triggered on completion
+ */
+#define DS3231_WRITE_REG_ASYNC(dev, _typename, var, event_id) \
+  ((ds3231_api_t*)(dev).api)->ds3231_write_reg_async(&(dev), \
+  _typename##_write_reg_addr, &(var), \
+  sizeof(_typename), (event_id))
+
+/*!
+ * \macro DS3231_READ_REG_ASYNC
+ * \brief start reading a register, \a event_id is triggered when \a var holds the data
+ *
+ * \param dev device object
+ * \param _typename typename for register
+ * \param var variable for read data, must stay valid until the transfer is completed
+ * \param event_id event triggered on completion
+ */
+#define DS3231_READ_REG_ASYNC(dev, _typename, var, event_id) \
+  ((ds3231_api_t*)(dev).api)->ds3231_read_reg_async(&(dev), \
+  _typename##_read_reg_addr, &(var), \
+  sizeof(_typename), (event_id))
+
+/*!
+ * \macro DS3231_READ_REGS_ASYNC
+ * \brief start reading a contiguous range of registers in one transaction,
+ * \a event_id is triggered when \a var holds the data
+ *
+ * \param dev device object
+ * \param _first_typename typename for the first register of the range
+ * \param count count of registers to read
+ * \param var variable for read data, at least \a count bytes long, must stay valid until the transfer is completed
+ * \param event_id event triggered on completion
+ */
+#define DS3231_READ_REGS_ASYNC(dev, _first_typename, count, var, event_id) \
+  ((ds3231_api_t*)(dev).api)->ds3231_read_regs_async(&(dev), \
+  _first_typename##_read_reg_addr, (count), &(var), (event_id))
+
+/*!
+ * \macro DS3231_READ_REGS
+ * \brief read a contiguous range of registers in one transaction
+ *
+ * \param dev device object
+ * \param _first_typename typename for the first register of the range
+ * \param count count of registers to read
+ * \param var variable for read data, at least \a count bytes long
+ */
+#define DS3231_READ_REGS(dev, _first_typename, count, var) \
+  ((ds3231_api_t*)(dev).api)->ds3231_read_regs(&(dev), \
+  _first_typename##_read_reg_addr, (count), &(var))
+
+/*!
+ * \macro DS3231_WRITE_REGS
+ * \brief write a contiguous range of registers in one transaction
+ *
+ * \param dev device object
+ * \param _first_typename typename for the first register of the range
+ * \param count count of registers to write
+ * \param var variable containing data to be written, at least \a count bytes long
+ */
+#define DS3231_WRITE_REGS(dev, _first_typename, count, var) \
+  ((ds3231_api_t*)(dev).api)->ds3231_write_regs(&(dev), \
+  _first_typename##_write_reg_addr, (count), &(var))
+
+/*!
+ * \macro DS3231_SET_FIELD
+ * \brief write a single field of a register, keeping the other fields intact
+ *
+ * \param dev device object
+ * \param _typename typename for register
+ * \param _field name of the field in the register's data type
+ * \param val new value of the field
+ */
+#define DS3231_SET_FIELD(dev, _typename, _field, val) \
+  ds3231_update_bits(&(dev), _typename##_write_reg_addr, \
+  DS3231_FIELD_MASK(_typename, _field), DS3231_FIELD_VALUE(_typename, _field, val))
+
+/*!
+ * \macro DS3231_GET_FIELD
+ * \brief read a single field of a register
+ *
+ * \param dev device object
+ * \param _typename typename for register
+ * \param _field name of the field in the register's data type
+ * \param var uint8_t variable for the field value
+ */
+#define DS3231_GET_FIELD(dev, _typename, _field, var) \
+  ds3231_read_field(&(dev), _typename##_read_reg_addr, \
+  DS3231_FIELD_MASK(_typename, _field), _typename##_##_field##_shift, &(var))
+
 /*!
 * \macro DS3231_I2C_DEVICE_DEFINE
 * \brief Macro to create the device's objects
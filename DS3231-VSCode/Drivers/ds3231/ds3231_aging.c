@@ -0,0 +1,155 @@
+/*!
+ * \file ds3231_aging.c
+ * \brief Ds3231 aging offset calibration
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "ds3231_aging.h"
+#include "ds3231_registers.h"
+#include "ds3231_fields.h"
+
+#define DS3231_AGING_PPB            (1000000000LL)
+// keeps the drift in 24.8 fixed point within 32 bits
+#define DS3231_AGING_MAX_DRIFT_PPB  (4000000LL)
+#define DS3231_AGING_CODE_MIN       (-128)
+#define DS3231_AGING_CODE_MAX       (127)
+
+/*!
+ * \brief Advances the application of a new aging offset, returns whether it is still in progress.
+ *
+ * Sets CONV once the device is not busy, then waits for it to be cleared.
+ */
+static EMBEDD_RESULT ds3231_aging_settle(ds3231_aging_t *aging, bool *settling)
+{
+  uint8_t regs[2];
+  *settling = ( aging->settle != DS3231_AGING_SETTLE_NONE );
+  if( !*settling ) {
+    return EMBEDD_RESULT_OK;
+  }
+  // control and status in one transfer, the range is volatile so it is never served from the cache
+  if( ds3231_read_regs( aging->dev, ds3231_control_read_reg_addr, sizeof(regs), regs ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( aging->settle == DS3231_AGING_SETTLE_CONVERTING ) {
+    if( !( regs[0] & DS3231_FIELD_MASK(ds3231_control, conv) ) ) {
+      aging->settle = DS3231_AGING_SETTLE_NONE;
+    }
+    return EMBEDD_RESULT_OK;
+  }
+  // a conversion must not be forced while the device runs its own one
+  if( regs[1] & DS3231_FIELD_MASK(ds3231_status, bsy) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  if( ds3231_update_bits( aging->dev, ds3231_control_write_reg_addr, DS3231_FIELD_MASK(ds3231_control, conv),
+                          DS3231_FIELD_MASK(ds3231_control, conv) ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  aging->settle = DS3231_AGING_SETTLE_CONVERTING;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_aging_init(ds3231_aging_t *aging, embedd_device_t *dev)
+{
+  uint8_t reg;
+  if( aging == NULL || dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( aging, 0, sizeof(ds3231_aging_t) );
+  aging->dev = dev;
+  // the register is named sign and magnitude, but the device takes two's complement
+  if( ds3231_read_reg( dev, ds3231_aging_offset_read_reg_addr, &reg, sizeof(ds3231_aging_offset_t), ds3231_aging_offset_delay ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  aging->code = (int8_t)reg;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_aging_set_code(ds3231_aging_t *aging, int8_t code)
+{
+  uint8_t reg = (uint8_t)code;
+  if( aging == NULL || aging->dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( ds3231_write_reg( aging->dev, ds3231_aging_offset_write_reg_addr, &reg, sizeof(ds3231_aging_offset_t), ds3231_aging_offset_delay ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  aging->code = code;
+  aging->drift_q8 = 0;
+  aging->samples = 0;
+  aging->settle = DS3231_AGING_SETTLE_PENDING;
+  // the offset is written, a failure to force the conversion is retried by the next sample
+  bool settling;
+  ds3231_aging_settle( aging, &settling );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_aging_add_sample(ds3231_aging_t *aging, uint32_t rtc_seconds, uint32_t ref_ticks, uint32_t ref_hz)
+{
+  if( aging == NULL || aging->dev == NULL || rtc_seconds == 0 || ref_ticks == 0 || ref_hz == 0 ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  // the sample during which the new offset was applied is discarded as well
+  bool settling;
+  if( ds3231_aging_settle( aging, &settling ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( settling ) {
+    ++ aging->discarded;
+    return EMBEDD_RESULT_OK;
+  }
+  // the device runs fast when its seconds take fewer ticks of the reference than expected
+  int64_t expected = (int64_t)rtc_seconds * ref_hz;
+  int64_t drift = ( expected - (int64_t)ref_ticks ) * DS3231_AGING_PPB / (int64_t)ref_ticks;
+  if( drift > DS3231_AGING_MAX_DRIFT_PPB || drift < -DS3231_AGING_MAX_DRIFT_PPB ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  int32_t sample_q8 = (int32_t)drift * 256;
+  if( aging->samples == 0 ) {
+    aging->drift_q8 = sample_q8;
+  } else {
+    // exponential moving average with a weight of 1 / 2^DS3231_AGING_FILTER_SHIFT
+    aging->drift_q8 += ( sample_q8 - aging->drift_q8 ) / ( 1 << DS3231_AGING_FILTER_SHIFT );
+  }
+  ++ aging->samples;
+  if( aging->samples < DS3231_AGING_MIN_SAMPLES ) {
+    return EMBEDD_RESULT_OK;
+  }
+  int32_t drift_ppb = ds3231_aging_get_drift_ppb( aging );
+  if( drift_ppb < DS3231_AGING_DEADBAND_PPB && drift_ppb > -DS3231_AGING_DEADBAND_PPB ) {
+    return EMBEDD_RESULT_OK;
+  }
+  // a positive offset slows the oscillator down, rounded to the nearest LSB
+  int32_t step = ( drift_ppb + ( drift_ppb < 0 ? -DS3231_AGING_PPB_PER_LSB : DS3231_AGING_PPB_PER_LSB ) / 2 ) / DS3231_AGING_PPB_PER_LSB;
+  int32_t code = aging->code + step;
+  if( code > DS3231_AGING_CODE_MAX ) {
+    code = DS3231_AGING_CODE_MAX;
+  } else if( code < DS3231_AGING_CODE_MIN ) {
+    code = DS3231_AGING_CODE_MIN;
+  }
+  if( code == aging->code ) {
+    return EMBEDD_RESULT_OK;
+  }
+  if( ds3231_aging_set_code( aging, (int8_t)code ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  ++ aging->corrections;
+  return EMBEDD_RESULT_OK;
+}
@@ -0,0 +1,140 @@
+/*!
+ * \file ds3231_aging.h
+ * \brief Ds3231 aging offset calibration
+ *
+ * Closed loop trimming of the oscillator with the aging offset register. The
+ * drift of the device is measured against a reference time source, filtered,
+ * and once it is known well enough outside a deadband the aging offset is
+ * corrected. One LSB of the aging offset changes the frequency by about
+ * 0.1 ppm, a positive offset slows the oscillator down. A new offset takes
+ * effect with the next temperature conversion of the device, at most 64 s
+ * later, samples are restarted after every correction.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_AGING_H
+#define _SRC_DS3231_AGING_H
+
+#include <stdint.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+
+/*!
+ * \def DS3231_AGING_PPB_PER_LSB
+ * \brief Frequency change of one LSB of the aging offset at 25 °C in ppb
+ */
+#define DS3231_AGING_PPB_PER_LSB (100)
+
+/*!
+ * \enum ds3231_aging_settle_t
+ * \brief States of applying a new aging offset
+ *
+ * The device adds the offset to its capacitance array only at a temperature
+ * conversion, up to 64 s after it is written, so samples are discarded until
+ * a forced conversion has completed.
+ */
+typedef enum {
+  DS3231_AGING_SETTLE_NONE = 0,   // the offset in use is the one written
+  DS3231_AGING_SETTLE_PENDING,    // written, waiting for the device not to be busy to set CONV
+  DS3231_AGING_SETTLE_CONVERTING, // CONV set, waiting for it to be cleared
+} ds3231_aging_settle_t;
+
+/*!
+ * \struct ds3231_aging_t
+ * \brief State of the aging offset calibration
+ *
+ * \var dev           device being calibrated
+ * \var code          aging offset of the device, two's complement as held by the register
+ * \var drift_q8      filtered drift of the device against the reference in ppb, 24.8 fixed point,
+ *                    positive when the device runs fast
+ * \var samples       count of samples since the last correction
+ * \var corrections   count of corrections written to the device
+ * \var settle        state of applying the aging offset written last
+ * \var discarded     count of samples discarded while an aging offset was being applied
+ */
+typedef struct {
+  embedd_device_t *dev;
+  int8_t code;
+  int32_t drift_q8;
+  uint32_t samples;
+  uint32_t corrections;
+  ds3231_aging_settle_t settle;
+  uint32_t discarded;
+} ds3231_aging_t;
+
+/*!
+ * \brief Initializes the calibration with the aging offset read from the device.
+ *
+ * \param aging Pointer to the calibration.
+ * \param dev Pointer to the device.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_aging_init(ds3231_aging_t *aging, embedd_device_t *dev);
+
+/*!
+ * \brief Adds a drift sample and corrects the aging offset when due.
+ *
+ * A sample is a number of whole seconds of the device, e.g. counted on its
+ * 1 Hz square wave, timed by the reference. The offset is corrected once
+ * DS3231_AGING_MIN_SAMPLES samples have been filtered and the drift is
+ * outside DS3231_AGING_DEADBAND_PPB. After a new offset is written, samples
+ * are discarded until the conversion applying it has completed, including
+ * the sample during which it completed.
+ *
+ * \param aging Pointer to the calibration.
+ * \param rtc_seconds Seconds of the device in the sample.
+ * \param ref_ticks Ticks of the reference in the same interval.
+ * \param ref_hz Frequency of the reference in Hz.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_aging_add_sample(ds3231_aging_t *aging, uint32_t rtc_seconds, uint32_t ref_ticks, uint32_t ref_hz);
+
+/*!
+ * \brief Writes an aging offset to the device and restarts the samples.
+ *
+ * A temperature conversion is forced by setting CONV so the offset takes
+ * effect at once. While the device runs its own conversion, or when forcing
+ * it fails, CONV is set on a later call of ds3231_aging_add_sample().
+ *
+ * \param aging Pointer to the calibration.
+ * \param code Aging offset, -128 - 127.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_aging_set_code(ds3231_aging_t *aging, int8_t code);
+
+/*!
+ * \brief Returns the filtered drift of the device against the reference.
+ *
+ * \param aging Pointer to the calibration.
+ *
+ * \return Drift in ppb, positive when the device runs fast.
+ *
+ */
+static inline int32_t ds3231_aging_get_drift_ppb(const ds3231_aging_t *aging)
+{
+  return aging->drift_q8 / 256;
+}
+
+#endif//_SRC_DS3231_AGING_H
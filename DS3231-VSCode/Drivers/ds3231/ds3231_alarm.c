@@ -0,0 +1,251 @@
+/*!
+ * \file ds3231_alarm.c
+ * \brief Ds3231 alarms
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+
+#include <string.h>
+
+#include "ds3231_alarm.h"
+#include "ds3231_datetime.h"
+#include "ds3231_registers.h"
+#include "ds3231_fields.h"
+
+// The alarms share the layout of the seconds, minutes, hour and day/date
+// registers, Alarm 2 lacks the seconds one. Both are handled in the layout of
+// Alarm 1 and the image of Alarm 2 is taken from its minutes register on.
+#define DS3231_ALARM_SECONDS  (0U)
+#define DS3231_ALARM_MINUTES  (1U)
+#define DS3231_ALARM_HOUR     (2U)
+#define DS3231_ALARM_DAYDATE  (3U)
+
+#define DS3231_ALARM_MASK     DS3231_FIELD_MASK(ds3231_alarm_1_seconds, a1m1)
+#define DS3231_ALARM_DYDT     DS3231_FIELD_MASK(ds3231_alarm_1_daydate, dydt)
+#define DS3231_ALARM_12HOUR   DS3231_FIELD_MASK(ds3231_alarm_1_hour, _1224)
+#define DS3231_ALARM_PM       DS3231_FIELD_MASK(ds3231_alarm_1_hour, ampm20hour)
+
+#define DS3231_ALARM_1_ONLY   (1U << DS3231_ALARM_1)
+#define DS3231_ALARM_2_ONLY   (1U << DS3231_ALARM_2)
+#define DS3231_ALARM_BOTH     ( DS3231_ALARM_1_ONLY | DS3231_ALARM_2_ONLY )
+
+/*!
+ * \struct ds3231_alarm_mode_bits_t
+ * \brief Register bits of a mode
+ *
+ * \var masks    mask bits, bit N set for the mask bit of register N in the layout of Alarm 1
+ * \var dydt     DY/DT bit, matching the day of the week when set
+ * \var alarms   alarms supporting the mode
+ */
+typedef struct {
+  uint8_t masks;
+  uint8_t dydt;
+  uint8_t alarms;
+} ds3231_alarm_mode_bits_t;
+
+static const ds3231_alarm_mode_bits_t ds3231_alarm_modes[] = {
+  [DS3231_ALARM_MODE_EVERY_SECOND] = { 0x0f, 0, DS3231_ALARM_1_ONLY },
+  [DS3231_ALARM_MODE_EVERY_MINUTE] = { 0x0e, 0, DS3231_ALARM_2_ONLY },
+  [DS3231_ALARM_MODE_AT_SECONDS]   = { 0x0e, 0, DS3231_ALARM_1_ONLY },
+  [DS3231_ALARM_MODE_AT_MINUTES]   = { 0x0c, 0, DS3231_ALARM_BOTH },
+  [DS3231_ALARM_MODE_DAILY]        = { 0x08, 0, DS3231_ALARM_BOTH },
+  [DS3231_ALARM_MODE_WEEKDAY]      = { 0x00, 1, DS3231_ALARM_BOTH },
+  [DS3231_ALARM_MODE_DATE]         = { 0x00, 0, DS3231_ALARM_BOTH },
+};
+
+#define DS3231_ALARM_MODE_COUNT (sizeof(ds3231_alarm_modes) / sizeof(ds3231_alarm_modes[0]))
+
+/*!
+ * \brief Returns the index of the first register of the alarm in the layout of Alarm 1.
+ */
+static inline uint32_t ds3231_alarm_first(ds3231_alarm_t alarm)
+{
+  return ( alarm == DS3231_ALARM_1 ) ? DS3231_ALARM_SECONDS : DS3231_ALARM_MINUTES;
+}
+
+/*!
+ * \brief Returns the address of the first register of the alarm.
+ */
+static inline uint32_t ds3231_alarm_addr(ds3231_alarm_t alarm)
+{
+  return ( alarm == DS3231_ALARM_1 ) ? ds3231_alarm_1_seconds_write_reg_addr : ds3231_alarm_2_minutes_write_reg_addr;
+}
+
+/*!
+ * \brief Decodes a BCD value of a matched field.
+ */
+static EMBEDD_RESULT ds3231_alarm_from_bcd(uint8_t bcd, uint8_t min, uint8_t max, uint8_t *bin)
+{
+  if( ( bcd & 0x0f ) > 9 ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  *bin = ds3231_bcd2bin( bcd );
+  return ( *bin < min || *bin > max ) ? EMBEDD_RESULT_ERR : EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_alarm_compile(ds3231_alarm_t alarm, const ds3231_alarm_spec_t *spec, ds3231_alarm_image_t *image)
+{
+  uint8_t regs[DS3231_ALARM_IMAGE_SIZE] = {0};
+  if( spec == NULL || image == NULL || alarm > DS3231_ALARM_2 || (uint32_t)spec->mode >= DS3231_ALARM_MODE_COUNT ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  const ds3231_alarm_mode_bits_t *bits = &ds3231_alarm_modes[spec->mode];
+  uint32_t first = ds3231_alarm_first( alarm );
+  if( !( bits->alarms & ( 1U << alarm ) ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( !( bits->masks & ( 1U << DS3231_ALARM_SECONDS ) ) && ( alarm == DS3231_ALARM_1 ) ) {
+    if( spec->seconds > 59 ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    regs[DS3231_ALARM_SECONDS] = ds3231_bin2bcd( spec->seconds );
+  }
+  if( !( bits->masks & ( 1U << DS3231_ALARM_MINUTES ) ) ) {
+    if( spec->minutes > 59 ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    regs[DS3231_ALARM_MINUTES] = ds3231_bin2bcd( spec->minutes );
+  }
+  if( !( bits->masks & ( 1U << DS3231_ALARM_HOUR ) ) ) {
+    if( spec->hour > 23 ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    regs[DS3231_ALARM_HOUR] = ds3231_bin2bcd( spec->hour );
+  }
+  if( !( bits->masks & ( 1U << DS3231_ALARM_DAYDATE ) ) ) {
+    if( ( spec->day_date < 1 ) || ( spec->day_date > ( bits->dydt ? 7 : 31 ) ) ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    regs[DS3231_ALARM_DAYDATE] = ds3231_bin2bcd( spec->day_date ) | ( bits->dydt ? DS3231_ALARM_DYDT : 0 );
+  }
+  for( uint32_t i = 0; i < DS3231_ALARM_IMAGE_SIZE; ++i ) {
+    if( bits->masks & ( 1U << i ) ) {
+      regs[i] |= DS3231_ALARM_MASK;
+    }
+  }
+  image->alarm = alarm;
+  image->size = DS3231_ALARM_IMAGE_SIZE - first;
+  memset( image->regs, 0, sizeof(image->regs) );
+  memcpy( image->regs, &regs[first], image->size );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_alarm_decode(const ds3231_alarm_image_t *image, ds3231_alarm_spec_t *spec)
+{
+  uint8_t regs[DS3231_ALARM_IMAGE_SIZE] = {0};
+  uint8_t masks = 0;
+  uint32_t mode;
+  if( image == NULL || spec == NULL || image->alarm > DS3231_ALARM_2 ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint32_t first = ds3231_alarm_first( image->alarm );
+  if( image->size != DS3231_ALARM_IMAGE_SIZE - first ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memcpy( &regs[first], image->regs, image->size );
+  for( uint32_t i = first; i < DS3231_ALARM_IMAGE_SIZE; ++i ) {
+    if( regs[i] & DS3231_ALARM_MASK ) {
+      masks |= 1U << i;
+    }
+  }
+  // Alarm 2 has no seconds to match, so its modes are compared without the mask bit of the seconds
+  uint8_t ignored = ( image->alarm == DS3231_ALARM_1 ) ? 0 : ( 1U << DS3231_ALARM_SECONDS );
+  for( mode = 0; mode < DS3231_ALARM_MODE_COUNT; ++mode ) {
+    const ds3231_alarm_mode_bits_t *bits = &ds3231_alarm_modes[mode];
+    if( !( bits->alarms & ( 1U << image->alarm ) ) || ( ( bits->masks & (uint8_t)~ignored ) != masks ) ) {
+      continue;
+    }
+    // DY/DT is not looked at while the day/date is masked
+    if( ( masks & ( 1U << DS3231_ALARM_DAYDATE ) ) || ( bits->dydt == !!( regs[DS3231_ALARM_DAYDATE] & DS3231_ALARM_DYDT ) ) ) {
+      break;
+    }
+  }
+  if( mode == DS3231_ALARM_MODE_COUNT ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( spec, 0, sizeof(ds3231_alarm_spec_t) );
+  spec->mode = (ds3231_alarm_mode_t)mode;
+  masks |= ignored;
+  if( !( masks & ( 1U << DS3231_ALARM_SECONDS ) ) &&
+      ( ds3231_alarm_from_bcd( regs[DS3231_ALARM_SECONDS] & 0x7f, 0, 59, &spec->seconds ) != EMBEDD_RESULT_OK ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( !( masks & ( 1U << DS3231_ALARM_MINUTES ) ) &&
+      ( ds3231_alarm_from_bcd( regs[DS3231_ALARM_MINUTES] & 0x7f, 0, 59, &spec->minutes ) != EMBEDD_RESULT_OK ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( !( masks & ( 1U << DS3231_ALARM_HOUR ) ) ) {
+    uint8_t hour = regs[DS3231_ALARM_HOUR];
+    if( hour & DS3231_ALARM_12HOUR ) {
+      if( ds3231_alarm_from_bcd( hour & 0x1f, 1, 12, &spec->hour ) != EMBEDD_RESULT_OK ) {
+        return EMBEDD_RESULT_ERR;
+      }
+      // 12 AM is 0 and 12 PM is 12 in 24-hour format
+      spec->hour = ( spec->hour % 12 ) + ( ( hour & DS3231_ALARM_PM ) ? 12 : 0 );
+    } else if( ds3231_alarm_from_bcd( hour & 0x3f, 0, 23, &spec->hour ) != EMBEDD_RESULT_OK ) {
+      return EMBEDD_RESULT_ERR;
+    }
+  }
+  if( !( masks & ( 1U << DS3231_ALARM_DAYDATE ) ) &&
+      ( ds3231_alarm_from_bcd( regs[DS3231_ALARM_DAYDATE] & 0x3f, 1, ( mode == DS3231_ALARM_MODE_WEEKDAY ) ? 7 : 31,
+                               &spec->day_date ) != EMBEDD_RESULT_OK ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_alarm_write(embedd_device_t *dev, const ds3231_alarm_image_t *image)
+{
+  if( image == NULL || image->alarm > DS3231_ALARM_2 ||
+      image->size != DS3231_ALARM_IMAGE_SIZE - ds3231_alarm_first( image->alarm ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  return ds3231_write_regs( dev, ds3231_alarm_addr( image->alarm ), image->size, image->regs );
+}
+
+EMBEDD_RESULT ds3231_alarm_read(embedd_device_t *dev, ds3231_alarm_t alarm, ds3231_alarm_image_t *image)
+{
+  if( image == NULL || alarm > DS3231_ALARM_2 ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( image, 0, sizeof(ds3231_alarm_image_t) );
+  image->alarm = alarm;
+  image->size = DS3231_ALARM_IMAGE_SIZE - ds3231_alarm_first( alarm );
+  return ds3231_read_regs( dev, ds3231_alarm_addr( alarm ), image->size, image->regs );
+}
+
+EMBEDD_RESULT ds3231_alarm_set(embedd_device_t *dev, ds3231_alarm_t alarm, const ds3231_alarm_spec_t *spec)
+{
+  ds3231_alarm_image_t image;
+  EMBEDD_RESULT result = ds3231_alarm_compile( alarm, spec, &image );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  return ds3231_alarm_write( dev, &image );
+}
+
+EMBEDD_RESULT ds3231_alarm_get(embedd_device_t *dev, ds3231_alarm_t alarm, ds3231_alarm_spec_t *spec)
+{
+  ds3231_alarm_image_t image;
+  EMBEDD_RESULT result = ds3231_alarm_read( dev, alarm, &image );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  return ds3231_alarm_decode( &image, spec );
+}
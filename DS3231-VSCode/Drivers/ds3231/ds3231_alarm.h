@@ -0,0 +1,178 @@
+/*!
+ * \file ds3231_alarm.h
+ * \brief Ds3231 alarms
+ *
+ * Alarms described by what they match instead of by their mask bits. A spec
+ * is compiled once to the image of the alarm registers, 4 bytes for Alarm 1
+ * and 3 bytes for Alarm 2, with A1M1 - A1M4, A2M2 - A2M4 and DY/DT set for its
+ * mode, and the image is written with a single burst write. The decoder
+ * recovers the spec from the registers and rejects mask bit combinations the
+ * datasheet does not define.
+ *
+ * Alarm 2 has no seconds register and matches at 00 seconds, the seconds of
+ * its spec are ignored.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_ALARM_H
+#define _SRC_DS3231_ALARM_H
+
+#include <stdint.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+
+/*!
+ * \def DS3231_ALARM_IMAGE_SIZE
+ * \brief Largest size of an alarm image, the size of Alarm 1
+ */
+#define DS3231_ALARM_IMAGE_SIZE (4U)
+
+/*!
+ * \enum ds3231_alarm_t
+ * \brief Alarms of the device
+ */
+typedef enum {
+  DS3231_ALARM_1 = 0,   // registers 0x07 - 0x0A
+  DS3231_ALARM_2,       // registers 0x0B - 0x0D
+} ds3231_alarm_t;
+
+/*!
+ * \enum ds3231_alarm_mode_t
+ * \brief What an alarm matches
+ */
+typedef enum {
+  DS3231_ALARM_MODE_EVERY_SECOND = 0, // every second, Alarm 1 only
+  DS3231_ALARM_MODE_EVERY_MINUTE,     // every minute at 00 seconds, Alarm 2 only
+  DS3231_ALARM_MODE_AT_SECONDS,       // seconds, Alarm 1 only
+  DS3231_ALARM_MODE_AT_MINUTES,       // minutes and seconds
+  DS3231_ALARM_MODE_DAILY,            // hours, minutes and seconds
+  DS3231_ALARM_MODE_WEEKDAY,          // day of the week, hours, minutes and seconds
+  DS3231_ALARM_MODE_DATE,             // date, hours, minutes and seconds
+} ds3231_alarm_mode_t;
+
+/*!
+ * \struct ds3231_alarm_spec_t
+ * \brief Alarm described by what it matches, fields not matched by the mode are ignored
+ *
+ * \var mode      what the alarm matches
+ * \var day_date  day of the week 1 - 7 in DS3231_ALARM_MODE_WEEKDAY, date 1 - 31 in DS3231_ALARM_MODE_DATE
+ * \var hour      hour in 24-hour format, 0 - 23
+ * \var minutes   minutes, 0 - 59
+ * \var seconds   seconds, 0 - 59
+ */
+typedef struct {
+  ds3231_alarm_mode_t mode;
+  uint8_t day_date;
+  uint8_t hour;
+  uint8_t minutes;
+  uint8_t seconds;
+} ds3231_alarm_spec_t;
+
+/*!
+ * \struct ds3231_alarm_image_t
+ * \brief Image of the registers of an alarm, ready to be written
+ *
+ * \var alarm  alarm the image belongs to
+ * \var size   count of the registers, 4 for Alarm 1 and 3 for Alarm 2
+ * \var regs   registers starting at the first register of the alarm
+ */
+typedef struct {
+  ds3231_alarm_t alarm;
+  uint8_t size;
+  uint8_t regs[DS3231_ALARM_IMAGE_SIZE];
+} ds3231_alarm_image_t;
+
+/*!
+ * \brief Compiles an alarm spec to the image of the alarm registers.
+ *
+ * Fields not matched by the mode are encoded as 0.
+ *
+ * \param alarm Alarm the image is for.
+ * \param spec Pointer to the alarm spec.
+ * \param image Pointer to the image.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if the
+ *         mode is not supported by the alarm or a matched field is out of its range.
+ *
+ */
+EMBEDD_RESULT ds3231_alarm_compile(ds3231_alarm_t alarm, const ds3231_alarm_spec_t *spec, ds3231_alarm_image_t *image);
+
+/*!
+ * \brief Decodes the image of the alarm registers to an alarm spec.
+ *
+ * Hours in 12-hour format are converted to 24-hour format, fields not matched
+ * by the mode are set to 0.
+ *
+ * \param image Pointer to the image.
+ * \param spec Pointer to the alarm spec.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if the
+ *         mask bits do not form a mode or a matched field is not valid.
+ *
+ */
+EMBEDD_RESULT ds3231_alarm_decode(const ds3231_alarm_image_t *image, ds3231_alarm_spec_t *spec);
+
+/*!
+ * \brief Writes a compiled image to the alarm registers with a single burst write.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param image Pointer to the image.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_alarm_write(embedd_device_t *dev, const ds3231_alarm_image_t *image);
+
+/*!
+ * \brief Reads the image of the alarm registers with a single burst read.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param alarm Alarm to read.
+ * \param image Pointer to the image.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_alarm_read(embedd_device_t *dev, ds3231_alarm_t alarm, ds3231_alarm_image_t *image);
+
+/*!
+ * \brief Compiles an alarm spec and writes it to the alarm registers.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param alarm Alarm to set.
+ * \param spec Pointer to the alarm spec.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_alarm_set(embedd_device_t *dev, ds3231_alarm_t alarm, const ds3231_alarm_spec_t *spec);
+
+/*!
+ * \brief Reads the alarm registers and decodes them to an alarm spec.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param alarm Alarm to read.
+ * \param spec Pointer to the alarm spec.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_alarm_get(embedd_device_t *dev, ds3231_alarm_t alarm, ds3231_alarm_spec_t *spec);
+
+#endif//_SRC_DS3231_ALARM_H
@@ -0,0 +1,117 @@
+/*!
+ * \file ds3231_cfg.h
+ * \brief Ds3231 configuration
+ *
+ * This file contains compile-time configuration of the Ds3231 driver.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_CFG_H
+#define _SRC_DS3231_CFG_H
+
+/*!
+ *          Maximum count of registers transferred through the device
+ *          buffers by a single burst write. Sizes the per-device buffers,
+ *          buses providing writev are not limited by it. The default
+ *          covers the whole register map (0x00 - 0x12).
+ */
+#define     DS3231_MAX_BURST_REG_COUNT      (19U)
+
+/*!
+ *          Count of attempts to copy a consistent snapshot of the register
+ *          map before giving up, see ds3231_snapshot_read().
+ */
+#define     DS3231_SNAPSHOT_READ_RETRIES    (3U)
+
+/*!
+ *          Time in ms ds3231_clock_latch() waits for the seconds register
+ *          of the device to change before giving up.
+ */
+#define     DS3231_CLOCK_LATCH_TIMEOUT_MS   (1100U)
+
+/*!
+ *          Default longest time in s between two resyncs of the
+ *          interpolated clock with the device.
+ */
+#define     DS3231_CLOCK_RESYNC_PERIOD_S    (3600U)
+
+/*!
+ *          Default largest error in us of the interpolated clock,
+ *          estimated from the measured drift, before a resync.
+ */
+#define     DS3231_CLOCK_MAX_ERROR_US       (1000U)
+
+/*!
+ *          Count of the last square-wave edges kept by the edge capture,
+ *          see ds3231_sqw_get_edges(). A power of two keeps the ring
+ *          indexing free of divisions.
+ */
+#define     DS3231_SQW_EDGE_COUNT           (8U)
+
+/*!
+ *          Weight of a new drift sample in the filter of the aging offset
+ *          calibration, as a power of two: 1 / 2^N.
+ */
+#define     DS3231_AGING_FILTER_SHIFT       (3U)
+
+/*!
+ *          Count of drift samples filtered after a correction of the aging
+ *          offset before the next one.
+ */
+#define     DS3231_AGING_MIN_SAMPLES        (16U)
+
+/*!
+ *          Filtered drift in ppb the aging offset is left alone within,
+ *          half an LSB of the aging offset by default.
+ */
+#define     DS3231_AGING_DEADBAND_PPB       (50)
+
+/*!
+ *          Default period in ms of polling the device for the end of
+ *          a temperature conversion.
+ */
+#define     DS3231_TEMP_POLL_MS             (10U)
+
+/*!
+ *          Longest time in ms a temperature conversion may take, a
+ *          conversion takes up to 200 ms and may wait for one started
+ *          by the device itself.
+ */
+#define     DS3231_TEMP_TIMEOUT_MS          (500U)
+
+/*!
+ *          Count of the temperature samples reduced together by the
+ *          temperature stream, see ds3231_temp_stream_add().
+ */
+#define     DS3231_TEMP_STREAM_WINDOW       (32U)
+
+/*!
+ *          Shift of the deviations from the window mean before their
+ *          variance is computed by the temperature stream. The full scale
+ *          of the deviations is +-128 / 2^shift °C, larger ones saturate.
+ */
+#define     DS3231_TEMP_STREAM_VAR_SHIFT    (5U)
+
+/*!
+ *          Count of the software timers the timer service can keep
+ *          started at once, see ds3231_timer_start().
+ */
+#define     DS3231_TIMER_COUNT              (32U)
+
+#endif//_SRC_DS3231_CFG_H
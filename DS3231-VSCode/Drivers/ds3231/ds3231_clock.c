@@ -0,0 +1,349 @@
+/*!
+ * \file ds3231_clock.c
+ * \brief Ds3231 interpolated clock
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "ds3231_clock.h"
+#include "ds3231_registers.h"
+
+#define DS3231_CLOCK_US_PER_SECOND      (1000000U)
+#define DS3231_CLOCK_PPB                (1000000000LL)
+// half the range of the tick counter, so it never wraps between resyncs
+#define DS3231_CLOCK_MAX_RESYNC_TICKS   (0x80000000U)
+// keeps the conversion of the resync interval to ticks within 64 bits
+#define DS3231_CLOCK_MAX_RESYNC_US      (1ULL << 47)
+#define DS3231_CLOCK_MAX_DIVERGENCE_US  (0xFFFFFFFFLL)
+
+enum {
+  DS3231_CLOCK_RESYNC_IDLE = 0,
+  DS3231_CLOCK_RESYNC_WAIT,
+};
+
+/*!
+ * \brief Returns the time in us interpolated from the latch for the tick counter value.
+ */
+static inline uint64_t ds3231_clock_interpolate(const ds3231_clock_t *clock, const ds3231_clock_latch_t *latch, uint32_t tick)
+{
+  uint32_t elapsed = tick - latch->tick;
+  return latch->us + ( ( (uint64_t)elapsed * clock->us_per_tick_q16 ) >> 16 );
+}
+
+/*!
+ * \brief Returns the whole seconds in \a ticks, exact for any 32-bit value.
+ *
+ * The reciprocal is 2^32 + tick_hz_recip, the product with its 2^32 part is
+ * \a ticks itself, so only the remainder needs a 32 x 32 multiplication.
+ */
+static inline uint32_t ds3231_clock_ticks_to_s(const ds3231_clock_t *clock, uint32_t ticks)
+{
+  uint32_t high = (uint32_t)( ( (uint64_t)ticks * clock->tick_hz_recip ) >> 32 );
+  return (uint32_t)( ( (uint64_t)ticks + high ) >> clock->tick_hz_shift );
+}
+
+/*!
+ * \brief Converts a time in us, below DS3231_CLOCK_MAX_RESYNC_US, to ticks.
+ */
+static inline uint64_t ds3231_clock_us_to_ticks(const ds3231_clock_t *clock, uint64_t us)
+{
+  uint64_t high = ( us >> 32 ) * clock->ticks_per_us_q32;
+  uint64_t low = ( ( us & 0xFFFFFFFFU ) * ( clock->ticks_per_us_q32 & 0xFFFFFFFFU ) ) >> 32;
+  return high + low + ( us & 0xFFFFFFFFU ) * ( clock->ticks_per_us_q32 >> 32 );
+}
+
+/*!
+ * \brief Computes the ticks after the latch a resync is due at from the period and the measured drift.
+ */
+static void ds3231_clock_update_resync_ticks(ds3231_clock_t *clock)
+{
+  uint64_t limit_us = (uint64_t)clock->resync_period_s * DS3231_CLOCK_US_PER_SECOND;
+  int32_t drift = clock->stats.drift_ppb;
+  uint32_t abs_drift = ( drift < 0 ) ? -(uint32_t)drift : (uint32_t)drift;
+  if( clock->max_error_us != 0 && abs_drift != 0 ) {
+    // time it takes the drift to accumulate the tolerated error, the division is done once per resync
+    uint64_t error_us = (uint64_t)clock->max_error_us * DS3231_CLOCK_PPB / abs_drift;
+    if( error_us < limit_us ) {
+      limit_us = error_us;
+    }
+  }
+  if( limit_us > DS3231_CLOCK_MAX_RESYNC_US ) {
+    limit_us = DS3231_CLOCK_MAX_RESYNC_US;
+  }
+  uint64_t ticks = ds3231_clock_us_to_ticks( clock, limit_us );
+  clock->resync_ticks = ( ticks > DS3231_CLOCK_MAX_RESYNC_TICKS ) ? DS3231_CLOCK_MAX_RESYNC_TICKS : (uint32_t)ticks;
+}
+
+/*!
+ * \brief Reads the time of the device, returns its Unix time and the seconds register.
+ */
+static EMBEDD_RESULT ds3231_clock_read_time(ds3231_clock_t *clock, int64_t *epoch, uint8_t *seconds)
+{
+  ds3231_time_regs_t regs;
+  ds3231_datetime_t datetime;
+  ++ clock->stats.bus_reads;
+  if( ds3231_get_datetime_regs( clock->dev, &regs ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( ds3231_datetime_from_regs( &regs, &datetime ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memcpy( seconds, &regs.seconds, sizeof(ds3231_seconds_t) );
+  return ds3231_datetime_to_epoch( &datetime, epoch );
+}
+
+/*!
+ * \brief Reads the seconds register of the device.
+ */
+static EMBEDD_RESULT ds3231_clock_read_seconds(ds3231_clock_t *clock, uint8_t *seconds)
+{
+  ++ clock->stats.bus_reads;
+  return ds3231_read_reg( clock->dev, ds3231_seconds_read_reg_addr, seconds, sizeof(ds3231_seconds_t), ds3231_seconds_delay );
+}
+
+/*!
+ * \brief Starts a resync, the seconds register is polled from the boundary predicted by the interpolation.
+ */
+static EMBEDD_RESULT ds3231_clock_resync_start(ds3231_clock_t *clock, uint32_t tick)
+{
+  if( ds3231_clock_read_time( clock, &clock->resync_epoch, &clock->resync_seconds ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  clock->resync_epoch += 1;
+  clock->resync_start = tick;
+  clock->resync_poll_tick = tick;
+  clock->resync_polled = 0;
+  clock->resync_state = DS3231_CLOCK_RESYNC_WAIT;
+  if( clock->resync_wide || !clock->drift_valid || clock->max_error_us == 0 ) {
+    return EMBEDD_RESULT_OK;
+  }
+  // the interpolated time is off by about max_error_us at most, twice that is the guard
+  const ds3231_clock_latch_t *latch = &clock->latch[clock->front];
+  uint64_t poll_us = (uint64_t)clock->resync_epoch * DS3231_CLOCK_US_PER_SECOND - 2ULL * clock->max_error_us;
+  if( poll_us <= ds3231_clock_interpolate( clock, latch, tick ) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  clock->resync_poll_tick = latch->tick + (uint32_t)ds3231_clock_us_to_ticks( clock, poll_us - latch->us );
+  return EMBEDD_RESULT_OK;
+}
+
+/*!
+ * \brief Ends a failed resync, it is started again on the next call of ds3231_clock_process().
+ */
+static EMBEDD_RESULT ds3231_clock_resync_failed(ds3231_clock_t *clock)
+{
+  clock->resync_state = DS3231_CLOCK_RESYNC_IDLE;
+  ++ clock->stats.errors;
+  return EMBEDD_RESULT_ERR;
+}
+
+EMBEDD_RESULT ds3231_clock_init(ds3231_clock_t *clock, embedd_device_t *dev, ds3231_clock_ticks_t get_ticks, uint32_t tick_hz)
+{
+  if( clock == NULL || dev == NULL || get_ticks == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( tick_hz < DS3231_CLOCK_TICK_HZ_MIN || tick_hz > DS3231_CLOCK_TICK_HZ_MAX ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( clock, 0, sizeof(ds3231_clock_t) );
+  clock->dev = dev;
+  clock->get_ticks = get_ticks;
+  clock->tick_hz = tick_hz;
+  // the divisions by the tick frequency are done here once, the conversions after use these factors
+  // exact for 32.768 kHz and for any divisor of 1 MHz
+  clock->us_per_tick_q16 = (uint32_t)( ( (uint64_t)DS3231_CLOCK_US_PER_SECOND << 16 ) / tick_hz );
+  clock->ticks_per_us_q32 = ( (uint64_t)tick_hz << 32 ) / DS3231_CLOCK_US_PER_SECOND;
+  // round up reciprocal with one more bit than tick_hz, exact over 32-bit dividends
+  clock->tick_hz_shift = 32 - __builtin_clz( tick_hz - 1 );
+  clock->tick_hz_recip = (uint32_t)( ( 1ULL << ( 32 + clock->tick_hz_shift ) ) / tick_hz + 1 - ( 1ULL << 32 ) );
+  clock->timeout_ticks = (uint32_t)( ( (uint64_t)tick_hz * DS3231_CLOCK_LATCH_TIMEOUT_MS ) / 1000U );
+  return ds3231_clock_set_resync( clock, DS3231_CLOCK_RESYNC_PERIOD_S, DS3231_CLOCK_MAX_ERROR_US );
+}
+
+EMBEDD_RESULT ds3231_clock_set_resync(ds3231_clock_t *clock, uint32_t period_s, uint32_t max_error_us)
+{
+  if( clock == NULL || clock->us_per_tick_q16 == 0 ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  clock->resync_period_s = period_s;
+  clock->max_error_us = max_error_us;
+  ds3231_clock_update_resync_ticks( clock );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_clock_latch(ds3231_clock_t *clock)
+{
+  uint8_t first, seconds;
+  int64_t epoch;
+  if( clock == NULL || clock->dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  clock->resync_state = DS3231_CLOCK_RESYNC_IDLE;
+  if( ds3231_clock_read_time( clock, &epoch, &first ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint32_t start = clock->get_ticks();
+  for( ;; ) {
+    if( ds3231_clock_read_seconds( clock, &seconds ) != EMBEDD_RESULT_OK ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    uint32_t tick = clock->get_ticks();
+    if( seconds != first ) {
+      return ds3231_clock_set( clock, epoch + 1, tick );
+    }
+    if( (uint32_t)( tick - start ) > clock->timeout_ticks ) {
+      return EMBEDD_RESULT_ERR;
+    }
+  }
+}
+
+EMBEDD_RESULT ds3231_clock_set(ds3231_clock_t *clock, int64_t epoch, uint32_t tick)
+{
+  if( clock == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( epoch < DS3231_EPOCH_MIN || epoch > DS3231_EPOCH_MAX ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint64_t us = (uint64_t)epoch * DS3231_CLOCK_US_PER_SECOND;
+  if( clock->latched ) {
+    const ds3231_clock_latch_t *prev = &clock->latch[clock->front];
+    uint64_t predicted = ds3231_clock_interpolate( clock, prev, tick );
+    int64_t divergence = (int64_t)( predicted - us );
+    if( divergence > DS3231_CLOCK_MAX_DIVERGENCE_US ) {
+      divergence = DS3231_CLOCK_MAX_DIVERGENCE_US;
+    } else if( divergence < -DS3231_CLOCK_MAX_DIVERGENCE_US ) {
+      divergence = -DS3231_CLOCK_MAX_DIVERGENCE_US;
+    }
+    uint32_t abs_divergence = (uint32_t)( ( divergence < 0 ) ? -divergence : divergence );
+    if( abs_divergence > clock->stats.max_divergence_us ) {
+      clock->stats.max_divergence_us = abs_divergence;
+    }
+    // positive when the tick counter runs fast against the device, the division is done once per resync
+    uint64_t elapsed_us = predicted - prev->us;
+    if( elapsed_us != 0 ) {
+      int64_t drift = divergence * DS3231_CLOCK_PPB / (int64_t)elapsed_us;
+      clock->stats.drift_ppb = ( drift > INT32_MAX ) ? INT32_MAX : ( drift < -INT32_MAX ) ? -INT32_MAX : (int32_t)drift;
+      clock->drift_valid = 1;
+    }
+  }
+  // the latch in use stays intact for interrupts reading the time meanwhile
+  ds3231_clock_latch_t *next = &clock->latch[clock->front ^ 1];
+  next->tick = tick;
+  next->epoch = epoch;
+  next->us = us;
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  clock->front ^= 1;
+  clock->latched = 1;
+  ds3231_clock_update_resync_ticks( clock );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_clock_process(ds3231_clock_t *clock)
+{
+  uint8_t seconds;
+  if( clock == NULL || clock->dev == NULL || !clock->latched ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint32_t tick = clock->get_ticks();
+  if( clock->resync_state == DS3231_CLOCK_RESYNC_IDLE ) {
+    if( (uint32_t)( tick - clock->latch[clock->front].tick ) < clock->resync_ticks ) {
+      return EMBEDD_RESULT_OK;
+    }
+    if( ds3231_async_busy( clock->dev ) ) {
+      return EMBEDD_RESULT_OK;
+    }
+    if( ds3231_clock_resync_start( clock, tick ) != EMBEDD_RESULT_OK ) {
+      return ds3231_clock_resync_failed( clock );
+    }
+    return EMBEDD_RESULT_OK;
+  }
+  if( (int32_t)( tick - clock->resync_poll_tick ) < 0 || ds3231_async_busy( clock->dev ) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  if( ds3231_clock_read_seconds( clock, &seconds ) != EMBEDD_RESULT_OK ) {
+    return ds3231_clock_resync_failed( clock );
+  }
+  tick = clock->get_ticks();
+  uint8_t first_poll = !clock->resync_polled;
+  clock->resync_polled = 1;
+  if( seconds == clock->resync_seconds ) {
+    if( (uint32_t)( tick - clock->resync_start ) > clock->timeout_ticks ) {
+      return ds3231_clock_resync_failed( clock );
+    }
+    return EMBEDD_RESULT_OK;
+  }
+  // the boundary came before polling started, the next resync polls from its start
+  if( first_poll && clock->resync_poll_tick != clock->resync_start ) {
+    clock->resync_wide = 1;
+    return ds3231_clock_resync_failed( clock );
+  }
+  // more than one second passed if the calls are too rare, the boundary is unknown then
+  if( ds3231_bcd2bin( seconds ) != ( ds3231_bcd2bin( clock->resync_seconds ) + 1 ) % 60 ) {
+    return ds3231_clock_resync_failed( clock );
+  }
+  clock->resync_state = DS3231_CLOCK_RESYNC_IDLE;
+  clock->resync_wide = 0;
+  ++ clock->stats.resyncs;
+  return ds3231_clock_set( clock, clock->resync_epoch, tick );
+}
+
+uint64_t ds3231_clock_now_us(ds3231_clock_t *clock)
+{
+  if( clock == NULL || !clock->latched ) {
+    return 0;
+  }
+  const ds3231_clock_latch_t *latch = &clock->latch[clock->front];
+  ++ clock->stats.reads_avoided;
+  return ds3231_clock_interpolate( clock, latch, clock->get_ticks() );
+}
+
+EMBEDD_RESULT ds3231_clock_get_epoch(ds3231_clock_t *clock, int64_t *epoch)
+{
+  if( clock == NULL || epoch == NULL || !clock->latched ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  const ds3231_clock_latch_t *latch = &clock->latch[clock->front];
+  uint32_t elapsed = clock->get_ticks() - latch->tick;
+  ++ clock->stats.reads_avoided;
+  *epoch = latch->epoch + ds3231_clock_ticks_to_s( clock, elapsed );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_clock_get_time(ds3231_clock_t *clock, ds3231_datetime_t *datetime)
+{
+  int64_t epoch;
+  if( datetime == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( ds3231_clock_get_epoch( clock, &epoch ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  return ds3231_epoch_to_datetime( epoch, datetime );
+}
+
+EMBEDD_RESULT ds3231_clock_get_stats(const ds3231_clock_t *clock, ds3231_clock_stats_t *stats)
+{
+  if( clock == NULL || stats == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  *stats = clock->stats;
+  return EMBEDD_RESULT_OK;
+}
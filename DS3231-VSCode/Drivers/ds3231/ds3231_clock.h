@@ -0,0 +1,263 @@
+/*!
+ * \file ds3231_clock.h
+ * \brief Ds3231 interpolated clock
+ *
+ * Sub-second clock built on the DS3231. The time of the device is latched once
+ * at a second boundary, then timestamps are interpolated from a free-running
+ * tick counter, e.g. a timer counting the 32.768 kHz output of the device, so
+ * taking a timestamp costs no bus traffic. The latch is renewed from the
+ * device after a fixed period, or earlier when the error estimated from the
+ * drift measured between the latches exceeds a bound.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_CLOCK_H
+#define _SRC_DS3231_CLOCK_H
+
+#include <stdint.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+#include "ds3231_datetime.h"
+
+/*!
+ * \def DS3231_CLOCK_TICK_HZ_MIN
+ * \brief Lowest supported frequency of the tick counter
+ */
+#define DS3231_CLOCK_TICK_HZ_MIN (16U)
+
+/*!
+ * \def DS3231_CLOCK_TICK_HZ_MAX
+ * \brief Highest supported frequency of the tick counter
+ */
+#define DS3231_CLOCK_TICK_HZ_MAX (0x80000000U)
+
+/*!
+ * \typedef ds3231_clock_ticks_t
+ * \brief Returns the current value of a free-running 32-bit tick counter
+ */
+typedef uint32_t (*ds3231_clock_ticks_t)(void);
+
+/*!
+ * \struct ds3231_clock_latch_t
+ * \brief Second boundary the time is interpolated from
+ *
+ * \var tick   tick counter value at the second boundary
+ * \var epoch  Unix time of the second boundary
+ * \var us     epoch in us
+ */
+typedef struct {
+  uint32_t tick;
+  int64_t epoch;
+  uint64_t us;
+} ds3231_clock_latch_t;
+
+/*!
+ * \struct ds3231_clock_stats_t
+ * \brief Counters of the interpolated clock
+ *
+ * \var reads_avoided      count of times answered from the latch instead of the bus
+ * \var bus_reads          count of register reads done to latch the time
+ * \var resyncs            count of latches renewed from the device
+ * \var errors             count of failed resyncs
+ * \var max_divergence_us  largest difference between the interpolated time and the device seen at a resync
+ * \var drift_ppb          drift of the tick counter against the device measured at the last resync, in ppb
+ */
+typedef struct {
+  uint32_t reads_avoided;
+  uint32_t bus_reads;
+  uint32_t resyncs;
+  uint32_t errors;
+  uint32_t max_divergence_us;
+  int32_t drift_ppb;
+} ds3231_clock_stats_t;
+
+/*!
+ * \struct ds3231_clock_t
+ * \brief State of the interpolated clock
+ *
+ * \var dev              device the time is latched from
+ * \var get_ticks        tick counter the time is interpolated with
+ * \var tick_hz          frequency of the tick counter in Hz
+ * \var us_per_tick_q16  length of a tick in us, 16.16 fixed point
+ * \var ticks_per_us_q32 ticks per us, 32.32 fixed point
+ * \var tick_hz_recip    reciprocal of tick_hz less 2^32, scaled by 2^(32 + tick_hz_shift)
+ * \var tick_hz_shift    ceil(log2(tick_hz)), the ticks divided by tick_hz are their product with the reciprocal shifted right by it
+ * \var timeout_ticks    DS3231_CLOCK_LATCH_TIMEOUT_MS in ticks
+ * \var latch            double buffer of the latch, one in use and one being renewed
+ * \var front            index of the latch in use
+ * \var latched          non-zero once the time has been latched
+ * \var resync_period_s  longest time between resyncs in s
+ * \var max_error_us     largest estimated error tolerated before a resync in us
+ * \var resync_ticks     ticks after the latch a resync is due at
+ * \var resync_state     non-zero while waiting for the second boundary of a resync
+ * \var resync_start     tick counter value the resync was started at
+ * \var resync_poll_tick tick counter value the seconds register is polled from
+ * \var resync_polled    non-zero once the seconds register has been polled in the resync
+ * \var resync_wide      non-zero to poll from the start of the next resync, the boundary was missed
+ * \var drift_valid      non-zero once the drift has been measured
+ * \var resync_seconds   seconds read at the start of the resync, BCD
+ * \var resync_epoch     Unix time of the second boundary the resync waits for
+ * \var stats            counters
+ */
+typedef struct {
+  embedd_device_t *dev;
+  ds3231_clock_ticks_t get_ticks;
+  uint32_t tick_hz;
+  uint32_t us_per_tick_q16;
+  uint64_t ticks_per_us_q32;
+  uint32_t tick_hz_recip;
+  uint8_t tick_hz_shift;
+  uint32_t timeout_ticks;
+  ds3231_clock_latch_t latch[2];
+  volatile uint8_t front;
+  volatile uint8_t latched;
+  uint32_t resync_period_s;
+  uint32_t max_error_us;
+  uint32_t resync_ticks;
+  uint8_t resync_state;
+  uint32_t resync_start;
+  uint32_t resync_poll_tick;
+  uint8_t resync_polled;
+  uint8_t resync_wide;
+  uint8_t drift_valid;
+  uint8_t resync_seconds;
+  int64_t resync_epoch;
+  ds3231_clock_stats_t stats;
+} ds3231_clock_t;
+
+/*!
+ * \brief Initializes the interpolated clock.
+ *
+ * The tick counter must be 32 bits wide and free running. Resyncs are done
+ * every DS3231_CLOCK_RESYNC_PERIOD_S or when the estimated error exceeds
+ * DS3231_CLOCK_MAX_ERROR_US, see ds3231_clock_set_resync().
+ *
+ * \param clock Pointer to the clock.
+ * \param dev Pointer to the device.
+ * \param get_ticks Tick counter, e.g. a timer counting the 32.768 kHz output or HAL_GetTick.
+ * \param tick_hz Frequency of the tick counter in Hz, DS3231_CLOCK_TICK_HZ_MIN - DS3231_CLOCK_TICK_HZ_MAX.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_init(ds3231_clock_t *clock, embedd_device_t *dev, ds3231_clock_ticks_t get_ticks, uint32_t tick_hz);
+
+/*!
+ * \brief Sets when the latch is renewed from the device.
+ *
+ * \param clock Pointer to the clock.
+ * \param period_s Longest time between resyncs in s.
+ * \param max_error_us Largest error estimated from the measured drift tolerated before a resync in us, 0 to disable.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_set_resync(ds3231_clock_t *clock, uint32_t period_s, uint32_t max_error_us);
+
+/*!
+ * \brief Latches the time of the device at its next second boundary.
+ *
+ * Reads the time, then polls the seconds register until it changes and takes
+ * the tick counter at that moment, so the latch is off by no more than a
+ * single register read. Blocks for up to DS3231_CLOCK_LATCH_TIMEOUT_MS.
+ *
+ * \param clock Pointer to the clock.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_latch(ds3231_clock_t *clock);
+
+/*!
+ * \brief Latches a second boundary known by other means, the bus is not touched.
+ *
+ * When the time is already latched, the difference between the interpolated
+ * time and \a epoch at \a tick updates the drift and the divergence counters.
+ *
+ * \param clock Pointer to the clock.
+ * \param epoch Unix time of the second boundary.
+ * \param tick Tick counter value at the second boundary.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_set(ds3231_clock_t *clock, int64_t epoch, uint32_t tick);
+
+/*!
+ * \brief Renews the latch when due, to be called periodically from the main loop.
+ *
+ * Never blocks, a due resync reads the time once, then the seconds register
+ * once per call until the next second boundary, so the latch is off by no
+ * more than the period of the calls. Once the drift is known, polling starts
+ * only shortly before the boundary predicted by the interpolation. Calls
+ * are skipped while an asynchronous transfer of the device is in flight.
+ *
+ * \param clock Pointer to the clock, its time must be latched.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if a resync failed.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_process(ds3231_clock_t *clock);
+
+/*!
+ * \brief Returns the current time interpolated from the latch, the bus is not touched.
+ *
+ * May be called from interrupts, the latch is renewed in the other buffer.
+ *
+ * \param clock Pointer to the clock.
+ *
+ * \return Microseconds since 1970-01-01 00:00:00, 0 if the time is not latched yet.
+ *
+ */
+uint64_t ds3231_clock_now_us(ds3231_clock_t *clock);
+
+/*!
+ * \brief Returns the current Unix time interpolated from the latch, the bus is not touched.
+ *
+ * \param clock Pointer to the clock.
+ * \param epoch Pointer where the seconds since 1970-01-01 00:00:00 will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if the time is not latched yet.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_get_epoch(ds3231_clock_t *clock, int64_t *epoch);
+
+/*!
+ * \brief Returns the current date and time interpolated from the latch, the bus is not touched.
+ *
+ * \param clock Pointer to the clock.
+ * \param datetime Pointer to the date and time, the day of the week is set as by ds3231_epoch_to_datetime().
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if the time is not latched yet.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_get_time(ds3231_clock_t *clock, ds3231_datetime_t *datetime);
+
+/*!
+ * \brief Returns the counters of the interpolated clock.
+ *
+ * \param clock Pointer to the clock.
+ * \param stats Pointer where the counters will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_clock_get_stats(const ds3231_clock_t *clock, ds3231_clock_stats_t *stats);
+
+#endif//_SRC_DS3231_CLOCK_H
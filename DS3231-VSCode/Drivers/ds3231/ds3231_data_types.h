@@ -28,6 +28,8 @@
 #include <stdint.h>
 #include "embedd_driver.h"
 #include "embedd_hal.h"
+#include "ds3231_cfg.h"
+#include "ds3231_fields.h"
 
 /* -------------------------------------------------------------------------- 
  * DATA types
@@ -45,11 +47,11 @@
  */
 typedef struct {
   // Represents the seconds value in BCD format.
-  uint8_t seconds:4;
+  uint8_t seconds:ds3231_seconds_seconds_width;
   // Stores the tens place of the seconds value.
-  uint8_t _10_seconds:3;
+  uint8_t _10_seconds:ds3231_seconds__10_seconds_width;
   // Reserved bit, should be set to 0.
-  uint8_t reserved:1;
+  uint8_t reserved:ds3231_seconds_reserved_width;
 } ds3231_seconds_t;
 
 /*!
@@ -98,11 +100,11 @@ typedef struct {
  */
 typedef struct {
   // Stores the units place of the minutes value.
-  uint8_t minutes:4;
+  uint8_t minutes:ds3231_minutes_minutes_width;
   // Stores the tens place of the minutes value.
-  uint8_t _10_minutes:3;
+  uint8_t _10_minutes:ds3231_minutes__10_minutes_width;
   // Reserved field as space was unfilled
-  uint8_t reserved:1;
+  uint8_t reserved:ds3231_minutes_reserved_width;
 } ds3231_minutes_t;
 
 /*!
@@ -251,15 +253,15 @@ typedef struct {
  */
 typedef struct {
   // Hour digit of the hour
-  uint8_t hour:4;
+  uint8_t hour:ds3231_hour_hour_width;
   // 10-hour digit of the hour
-  uint8_t _10_hour:1;
+  uint8_t _10_hour:ds3231_hour__10_hour_width;
   // AM/PM bit in 12-hour mode or the 2nd bit of 10s of hours in 24-hour mode
-  uint8_t ampm20hour:1;
+  uint8_t ampm20hour:ds3231_hour_ampm20hour_width;
   // 12-hour or 24-hour mode select bit
-  uint8_t _1224:1;
+  uint8_t _1224:ds3231_hour__1224_width;
   // Reserved field as space was unfilled
-  uint8_t reserved:1;
+  uint8_t reserved:ds3231_hour_reserved_width;
 } ds3231_hour_t;
 
 /*!
@@ -427,9 +429,9 @@ typedef struct {
  */
 typedef struct {
   // Day of the week
-  uint8_t day:3;
+  uint8_t day:ds3231_day_day_width;
   // Reserved bits
-  uint8_t reserved:5;
+  uint8_t reserved:ds3231_day_reserved_width;
 } ds3231_day_t;
 
 /*!
@@ -496,40 +498,19 @@ typedef struct {
  * \struct ds3231_date_t
  * \brief Holds the date of the month
  *
- * \var rsv_0 Reserved bit
  * \var date Units place of the date
  * \var 10_date Tens place of the date
  * \var rsv_1 Reserved bits
  */
 typedef struct {
-  // Reserved bit
-  uint8_t rsv_0:1;
   // Units place of the date
-  uint8_t date:4;
+  uint8_t date:ds3231_date_date_width;
   // Tens place of the date
-  uint8_t _10_date:1;
+  uint8_t _10_date:ds3231_date__10_date_width;
   // Reserved bits
-  uint8_t rsv_1:2;
+  uint8_t rsv_1:ds3231_date_rsv_1_width;
 } ds3231_date_t;
 
-/*!
- * \def DS3231_DATE_RSV_0_RESERVED
- * \brief Reserved bit
-*/
-#define DS3231_DATE_RSV_0_RESERVED 0
-
-
-/*!
- * \macro DS3231_DATE_RSV_0_VALID(val)
- * \brief Validates if a value matches any of the predefined valid values for ds3231_date_t_rsv_0 type.
- *
- * \param val The value to be validated.
- * \return True if the value matches any of the predefined valid values, false otherwise.
- */
- #define DS3231_DATE_RSV_0_VALID(val) (\
-  (val) == DS3231_DATE_RSV_0_RESERVED ||\
-  0)
-
 /*!
  * \def DS3231_DATE_DATE_0
  * \brief Units place of the date
@@ -679,13 +660,13 @@ typedef struct {
  */
 typedef struct {
   // Month value
-  uint8_t month:4;
+  uint8_t month:ds3231_monthcentury_month_width;
   // Tens place of the month
-  uint8_t _10_month:1;
+  uint8_t _10_month:ds3231_monthcentury__10_month_width;
   // Reserved bits
-  uint8_t rsv:2;
+  uint8_t rsv:ds3231_monthcentury_rsv_width;
   // Century bit
-  uint8_t century:1;
+  uint8_t century:ds3231_monthcentury_century_width;
 } ds3231_monthcentury_t;
 
 /*!
@@ -846,9 +827,9 @@ typedef struct {
  */
 typedef struct {
   // Stores ones of the year BCD value
-  uint8_t year:4;
+  uint8_t year:ds3231_year_year_width;
   // Stores 10s of the year BCD value
-  uint8_t _10_year:4;
+  uint8_t _10_year:ds3231_year__10_year_width;
 } ds3231_year_t;
 
 /*!
@@ -861,11 +842,11 @@ typedef struct {
  */
 typedef struct {
   // Seconds value
-  uint8_t seconds:4;
+  uint8_t seconds:ds3231_alarm_1_seconds_seconds_width;
   // 10 seconds value
-  uint8_t _10_seconds:3;
+  uint8_t _10_seconds:ds3231_alarm_1_seconds__10_seconds_width;
   // Alarm 1 mask bit 1
-  uint8_t a1m1:1;
+  uint8_t a1m1:ds3231_alarm_1_seconds_a1m1_width;
 } ds3231_alarm_1_seconds_t;
 
 /*!
@@ -1037,11 +1018,11 @@ typedef struct {
  */
 typedef struct {
   // Units place of the minutes value for Alarm 1.
-  uint8_t minutes:4;
+  uint8_t minutes:ds3231_alarm_1_minutes_minutes_width;
   // Tens place of the minutes value for Alarm 1.
-  uint8_t _10_minutes:3;
+  uint8_t _10_minutes:ds3231_alarm_1_minutes__10_minutes_width;
   // Alarm 1 mask bit for minutes. Controls whether the minutes value is used in the alarm match.
-  uint8_t a1m2:1;
+  uint8_t a1m2:ds3231_alarm_1_minutes_a1m2_width;
 } ds3231_alarm_1_minutes_t;
 
 /*!
@@ -1215,15 +1196,15 @@ typedef struct {
  */
 typedef struct {
   // Hour digit of the alarm time
-  uint8_t hour:4;
+  uint8_t hour:ds3231_alarm_1_hour_hour_width;
   // 10-hour digit of the alarm time
-  uint8_t _10_hour:1;
+  uint8_t _10_hour:ds3231_alarm_1_hour__10_hour_width;
   // AM/PM bit in 12-hour mode or the 2nd bit of 10s of hours in 24-hour mode
-  uint8_t ampm20hour:1;
+  uint8_t ampm20hour:ds3231_alarm_1_hour_ampm20hour_width;
   // 12-hour or 24-hour mode select bit
-  uint8_t _1224:1;
+  uint8_t _1224:ds3231_alarm_1_hour__1224_width;
   // Alarm 1 mask bit 3
-  uint8_t a1m3:1;
+  uint8_t a1m3:ds3231_alarm_1_hour_a1m3_width;
 } ds3231_alarm_1_hour_t;
 
 /*!
@@ -1421,17 +1402,17 @@ typedef struct {
  * \var daydate  Stores the day of the week or the date of the month depending on DY/DT bit.
  * \var 10_date Stores tens of the day value for Alarm 1.
  * \var dydt Controls whether the alarm value stored in bits 0 to 5 of the register reflects the day of the week or the date of the month.
- * \var reserved Reserved field as space was unfilled
+ * \var a1m4 Alarm 1 Mask bit 4
  */
 typedef struct {
   //  Stores the day of the week or the date of the month depending on DY/DT bit.
-  uint8_t daydate:4;
+  uint8_t daydate:ds3231_alarm_1_daydate_daydate_width;
   // Stores tens of the day value for Alarm 1.
-  uint8_t _10_date:2;
+  uint8_t _10_date:ds3231_alarm_1_daydate__10_date_width;
   // Controls whether the alarm value stored in bits 0 to 5 of the register reflects the day of the week or the date of the month.
-  uint8_t dydt:1;
-  // Reserved field as space was unfilled
-  uint8_t reserved:1;
+  uint8_t dydt:ds3231_alarm_1_daydate_dydt_width;
+  // Alarm 1 Mask bit 4
+  uint8_t a1m4:ds3231_alarm_1_daydate_a1m4_width;
 } ds3231_alarm_1_daydate_t;
 
 /*!
@@ -1683,11 +1664,11 @@ typedef struct {
  */
 typedef struct {
   // Minutes value for Alarm 2.
-  uint8_t minutes:4;
+  uint8_t minutes:ds3231_alarm_2_minutes_minutes_width;
   // Tens place of the minutes value for Alarm 1.
-  uint8_t _10_minutes:3;
+  uint8_t _10_minutes:ds3231_alarm_2_minutes__10_minutes_width;
   // Alarm 2 mask bit for minutes. When set to logic 1, the minutes value is ignored in the alarm comparison.
-  uint8_t a2m2:1;
+  uint8_t a2m2:ds3231_alarm_2_minutes_a2m2_width;
 } ds3231_alarm_2_minutes_t;
 
 /*!
@@ -1741,19 +1722,19 @@ typedef struct {
  * \var 10_hour 10 Hour bit
  * \var ampm20hour AM/PM bit in 12-hour mode or the 2nd bit of 10s of hours in 24-hour mode
  * \var 1224 12-hour or 24-hour mode select bit
- * \var a2m2 Alarm 2 Mask bit 2
+ * \var a2m3 Alarm 2 Mask bit 3
  */
 typedef struct {
   // Hour bits
-  uint8_t hour:4;
+  uint8_t hour:ds3231_alarm_2_hour_hour_width;
   // 10 Hour bit
-  uint8_t _10_hour:1;
+  uint8_t _10_hour:ds3231_alarm_2_hour__10_hour_width;
   // AM/PM bit in 12-hour mode or the 2nd bit of 10s of hours in 24-hour mode
-  uint8_t ampm20hour:1;
+  uint8_t ampm20hour:ds3231_alarm_2_hour_ampm20hour_width;
   // 12-hour or 24-hour mode select bit
-  uint8_t _1224:1;
-  // Alarm 2 Mask bit 2
-  uint8_t a2m2:1;
+  uint8_t _1224:ds3231_alarm_2_hour__1224_width;
+  // Alarm 2 Mask bit 3
+  uint8_t a2m3:ds3231_alarm_2_hour_a2m3_width;
 } ds3231_alarm_2_hour_t;
 
 /*!
@@ -1913,28 +1894,28 @@ typedef struct {
   0)
 
 /*!
- * \def DS3231_ALARM_2_HOUR_A2M2_ALARM_WHEN_HOURS_MATCH
- * \brief Alarm 2 Mask bit 2
+ * \def DS3231_ALARM_2_HOUR_A2M3_ALARM_WHEN_HOURS_MATCH
+ * \brief Alarm 2 Mask bit 3
 */
-#define DS3231_ALARM_2_HOUR_A2M2_ALARM_WHEN_HOURS_MATCH 0
+#define DS3231_ALARM_2_HOUR_A2M3_ALARM_WHEN_HOURS_MATCH 0
 
 /*!
- * \def DS3231_ALARM_2_HOUR_A2M2_ALARM_WHEN_HOURS_AND_MINUTES_MATCH
- * \brief Alarm 2 Mask bit 2
+ * \def DS3231_ALARM_2_HOUR_A2M3_ALARM_WHEN_HOURS_AND_MINUTES_MATCH
+ * \brief Alarm 2 Mask bit 3
 */
-#define DS3231_ALARM_2_HOUR_A2M2_ALARM_WHEN_HOURS_AND_MINUTES_MATCH 1
+#define DS3231_ALARM_2_HOUR_A2M3_ALARM_WHEN_HOURS_AND_MINUTES_MATCH 1
 
 
 /*!
- * \macro DS3231_ALARM_2_HOUR_A2M2_VALID(val)
- * \brief Validates if a value matches any of the predefined valid values for ds3231_alarm_2_hour_t_a2m2 type.
+ * \macro DS3231_ALARM_2_HOUR_A2M3_VALID(val)
+ * \brief Validates if a value matches any of the predefined valid values for ds3231_alarm_2_hour_t_a2m3 type.
  *
  * \param val The value to be validated.
  * \return True if the value matches any of the predefined valid values, false otherwise.
  */
- #define DS3231_ALARM_2_HOUR_A2M2_VALID(val) (\
-  (val) == DS3231_ALARM_2_HOUR_A2M2_ALARM_WHEN_HOURS_MATCH ||\
-  (val) == DS3231_ALARM_2_HOUR_A2M2_ALARM_WHEN_HOURS_AND_MINUTES_MATCH ||\
+ #define DS3231_ALARM_2_HOUR_A2M3_VALID(val) (\
+  (val) == DS3231_ALARM_2_HOUR_A2M3_ALARM_WHEN_HOURS_MATCH ||\
+  (val) == DS3231_ALARM_2_HOUR_A2M3_ALARM_WHEN_HOURS_AND_MINUTES_MATCH ||\
   0)
 
 /*!
@@ -1948,13 +1929,13 @@ typedef struct {
  */
 typedef struct {
   // Day or Date value
-  uint8_t daydate:4;
+  uint8_t daydate:ds3231_alarm_2_daydate_daydate_width;
   // Stores tens of the day value for Alarm 1.
-  uint8_t _10_date:2;
+  uint8_t _10_date:ds3231_alarm_2_daydate__10_date_width;
   // Day/Date select
-  uint8_t dydt:1;
+  uint8_t dydt:ds3231_alarm_2_daydate_dydt_width;
   // Alarm 2 Mask bit 4
-  uint8_t a2m4:1;
+  uint8_t a2m4:ds3231_alarm_2_daydate_a2m4_width;
 } ds3231_alarm_2_daydate_t;
 
 /*!
@@ -2236,21 +2217,21 @@ typedef struct {
  */
 typedef struct {
   // Alarm 1 Interrupt Enable. When set to logic 1, this bit permits the alarm 1 flag (A1F) bit in the status register to assert INT/SQW (when INTCN = 1).
-  uint8_t a1ie:1;
+  uint8_t a1ie:ds3231_control_a1ie_width;
   // Alarm 2 Interrupt Enable. When set to logic 1, this bit permits the alarm 2 flag (A2F) bit in the status register to assert INT/SQW (when INTCN = 1).
-  uint8_t a2ie:1;
+  uint8_t a2ie:ds3231_control_a2ie_width;
   // Interrupt Control. This bit controls the INT/SQW signal.
-  uint8_t intcn:1;
+  uint8_t intcn:ds3231_control_intcn_width;
   // Rate Select. These bits control the frequency of the square-wave output when the square wave has been enabled.
-  uint8_t rs1:1;
+  uint8_t rs1:ds3231_control_rs1_width;
   // Rate Select. These bits control the frequency of the square-wave output when the square wave has been enabled.
-  uint8_t rs2:1;
+  uint8_t rs2:ds3231_control_rs2_width;
   // Convert Temperature. Setting this bit to 1 forces the temperature sensor to convert the temperature into digital code and execute the TCXO algorithm to update the capacitance array for the oscillator.
-  uint8_t conv:1;
+  uint8_t conv:ds3231_control_conv_width;
   // Battery-Backed Square-Wave Enable. When set to logic 1 with INTCN = 0 and VCC < VPF, this bit enables the square wave.
-  uint8_t bbsqw:1;
+  uint8_t bbsqw:ds3231_control_bbsqw_width;
   // Enable Oscillator. When set to logic 0, the oscillator is started. When set to logic 1, the oscillator is stopped when the DS3231 switches to VBAT.
-  uint8_t eosc:1;
+  uint8_t eosc:ds3231_control_eosc_width;
 } ds3231_control_t;
 
 /*!
@@ -2466,17 +2447,17 @@ typedef struct {
  */
 typedef struct {
   // A logic 1 in the alarm 1 flag bit indicates that the time matched the alarm 1 registers.
-  uint8_t a1f:1;
+  uint8_t a1f:ds3231_status_a1f_width;
   // A logic 1 in the alarm 2 flag bit indicates that the time matched the alarm 2 registers.
-  uint8_t a2f:1;
+  uint8_t a2f:ds3231_status_a2f_width;
   // This bit indicates the device is busy executing TCXO functions
-  uint8_t bsy:1;
+  uint8_t bsy:ds3231_status_bsy_width;
   // This bit controls the status of the 32kHz pin. When set to logic 1, the 32kHz pin is enabled and outputs a 32.768kHz square- wave signal.
-  uint8_t en32khz:1;
+  uint8_t en32khz:ds3231_status_en32khz_width;
   // Reserved bits
-  uint8_t reserved:3;
+  uint8_t reserved:ds3231_status_reserved_width;
   // A logic 1 in this bit indi- cates that the oscillator either is stopped or was stopped for some period and may be used to judge the validity of the timekeeping data
-  uint8_t ocf:1;
+  uint8_t ocf:ds3231_status_ocf_width;
 } ds3231_controlstatus_t;
 
 /*!
@@ -2563,9 +2544,9 @@ typedef struct {
  */
 typedef struct {
   // These bits represent the magnitude of the aging offset value.
-  uint8_t data:7;
+  uint8_t data:ds3231_aging_offset_data_width;
   // This bit represents the sign of the offset value.
-  uint8_t sign:1;
+  uint8_t sign:ds3231_aging_offset_sign_width;
 } ds3231_aging_offset_t;
 
 /*!
@@ -2602,9 +2583,9 @@ typedef struct {
  */
 typedef struct {
   // Integer part of the temperature value
-  uint8_t data:7;
+  uint8_t data:ds3231_msb_of_temp_data_width;
   // Sign bit of the temperature value
-  uint8_t sign:1;
+  uint8_t sign:ds3231_msb_of_temp_sign_width;
 } ds3231_msb_of_temp_t;
 
 /*!
@@ -2641,23 +2622,107 @@ typedef struct {
  */
 typedef struct {
   // Reserved bits
-  uint8_t rsvd:6;
+  uint8_t rsvd:ds3231_lsb_of_temp_rsvd_width;
   // The 2 least significant bits of the temperature value
-  uint8_t tmplsb:2;
+  uint8_t tmplsb:ds3231_lsb_of_temp_tmplsb_width;
 } ds3231_lsb_of_temp_t;
 
+/*!
+ * \struct ds3231_time_regs_t
+ * \brief Image of the timekeeping registers (0x00 - 0x06) in address order
+ *
+ * \var seconds Seconds register
+ * \var minutes Minutes register
+ * \var hour Hour register
+ * \var day Day register
+ * \var date Date register
+ * \var monthcentury Month/Century register
+ * \var year Year register
+ */
+typedef struct {
+  ds3231_seconds_t seconds;
+  ds3231_minutes_t minutes;
+  ds3231_hour_t hour;
+  ds3231_day_t day;
+  ds3231_date_t date;
+  ds3231_monthcentury_t monthcentury;
+  ds3231_year_t year;
+} ds3231_time_regs_t;
+
 #pragma pack(pop)
+/*!
+ * \def DS3231_REGISTER_MAP_SIZE
+ * \brief Count of registers in the device's register map (0x00 - 0x12)
+ */
+#define DS3231_REGISTER_MAP_SIZE 0x13
+
 /*!
  * \def ds3231_write_message_max_size
- * \brief Max buffer size required for write operations
+ * \brief Max buffer size required for write operations, register address plus DS3231_MAX_BURST_REG_COUNT
  */
- #define ds3231_write_message_max_size 2
+ #define ds3231_write_message_max_size (1 + DS3231_MAX_BURST_REG_COUNT)
 
 /*!
  * \def ds3231_read_message_max_size
- * \brief Max buffer size required for read operations
+ * \brief Max buffer size required for read operations, see DS3231_MAX_BURST_REG_COUNT
+ */
+#define ds3231_read_message_max_size DS3231_MAX_BURST_REG_COUNT
+
+/*!
+ * \struct ds3231_cache_stats_t
+ * \brief Counters of the shadow register cache
+ *
+ * \var hits    count of reads served from the shadow registers
+ * \var misses  count of reads of cached registers which had to access the bus
  */
-#define ds3231_read_message_max_size 2
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+} ds3231_cache_stats_t;
+
+/*!
+ * \struct ds3231_shadow_t
+ * \brief RAM copy of the device's registers
+ *
+ * \var regs    last known value of each register, indexed by register address
+ * \var valid   bitmap of registers whose value in \a regs is up to date
+ * \var dirty   bitmap of registers written in staged mode and not flushed yet
+ * \var staging non-zero if writes are staged in \a regs instead of being sent to the bus
+ * \var stats   cache counters
+ */
+typedef struct {
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+  uint32_t valid;
+  uint32_t dirty;
+  uint8_t staging;
+  ds3231_cache_stats_t stats;
+} ds3231_shadow_t;
+
+/*!
+ * \struct ds3231_async_t
+ * \brief State of the asynchronous register transfer
+ *
+ * \var busy      non-zero while a transfer is in flight, until its event is triggered
+ * \var done      set by the completion callback, the event is then triggered from the main context
+ * \var is_read   non-zero for a read transfer, zero for a write
+ * \var result    result of the last completed transfer
+ * \var event_id  event triggered when the transfer is completed
+ * \var reg_addr  address of the first transferred register
+ * \var reg       caller buffer receiving the data of a read transfer
+ * \var reg_size  size of the transfer
+ * \var data      buffer the bus transfers the register data from or to
+ */
+typedef struct {
+  volatile uint8_t busy;
+  volatile uint8_t done;
+  uint8_t is_read;
+  volatile EMBEDD_RESULT result;
+  int event_id;
+  uint32_t reg_addr;
+  void *reg;
+  uint32_t reg_size;
+  uint8_t *data;
+} ds3231_async_t;
 
 /*!
  * \struct ds3231_data_t
@@ -2665,10 +2730,14 @@ typedef struct {
  *
  * \var in_buf    staticaly allocated buffer for input data
  * \var out_buf   staticaly allocated buffer for out data
+ * \var shadow    shadow copy of the registers which are not changed by the device itself
+ * \var async     state of the asynchronous transfer
  */
 typedef struct {
   uint8_t out_buf[ds3231_write_message_max_size];
   uint8_t in_buf[ds3231_read_message_max_size];
+  ds3231_shadow_t shadow;
+  ds3231_async_t async;
 } ds3231_data_t;
 
 /*!
@@ -2677,11 +2746,21 @@ typedef struct {
  *
  * \var ds3231_write_reg contains pointer to ds3231_write_reg API's function
  * \var ds3231_read_reg contains pointer to ds3231_read_reg API's function
+ * \var ds3231_read_regs contains pointer to ds3231_read_regs API's function
+ * \var ds3231_write_regs contains pointer to ds3231_write_regs API's function
+ * \var ds3231_write_reg_async contains pointer to ds3231_write_reg_async API's function
+ * \var ds3231_read_reg_async contains pointer to ds3231_read_reg_async API's function
+ * \var ds3231_read_regs_async contains pointer to ds3231_read_regs_async API's function
 
  */
 typedef struct {
   EMBEDD_RESULT (*ds3231_write_reg)(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, uint32_t delay);
   EMBEDD_RESULT (*ds3231_read_reg)(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, uint32_t delay);
+  EMBEDD_RESULT (*ds3231_read_regs)(embedd_device_t *dev, uint32_t first_addr, uint32_t count, void *regs);
+  EMBEDD_RESULT (*ds3231_write_regs)(embedd_device_t *dev, uint32_t first_addr, uint32_t count, const void *regs);
+  EMBEDD_RESULT (*ds3231_write_reg_async)(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, int event_id);
+  EMBEDD_RESULT (*ds3231_read_reg_async)(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, int event_id);
+  EMBEDD_RESULT (*ds3231_read_regs_async)(embedd_device_t *dev, uint32_t first_addr, uint32_t count, void *regs, int event_id);
 } const ds3231_api_t;
 
 #endif//_SRC_DS3231_DATA_TYPES_H
@@ -0,0 +1,274 @@
+/*!
+ * \file ds3231_datetime.c
+ * \brief Ds3231 date and time
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "ds3231_datetime.h"
+#include "ds3231_registers.h"
+#include "ds3231_fields.h"
+
+/* --------------------------------------------------------------------------
+ * BCD conversion tables
+ * -------------------------------------------------------------------------- */
+
+// one row per high nibble, digits above 9 are not valid BCD and convert as their weight
+#define DS3231_BCD2BIN_ROW(h) \
+  (h)*10+0,  (h)*10+1,  (h)*10+2,  (h)*10+3,  (h)*10+4,  (h)*10+5,  (h)*10+6,  (h)*10+7, \
+  (h)*10+8,  (h)*10+9,  (h)*10+10, (h)*10+11, (h)*10+12, (h)*10+13, (h)*10+14, (h)*10+15
+
+const uint8_t ds3231_bcd2bin_table[256] = {
+  DS3231_BCD2BIN_ROW(0),  DS3231_BCD2BIN_ROW(1),  DS3231_BCD2BIN_ROW(2),  DS3231_BCD2BIN_ROW(3),
+  DS3231_BCD2BIN_ROW(4),  DS3231_BCD2BIN_ROW(5),  DS3231_BCD2BIN_ROW(6),  DS3231_BCD2BIN_ROW(7),
+  DS3231_BCD2BIN_ROW(8),  DS3231_BCD2BIN_ROW(9),  DS3231_BCD2BIN_ROW(10), DS3231_BCD2BIN_ROW(11),
+  DS3231_BCD2BIN_ROW(12), DS3231_BCD2BIN_ROW(13), DS3231_BCD2BIN_ROW(14), DS3231_BCD2BIN_ROW(15),
+};
+
+// one row per tens digit
+#define DS3231_BIN2BCD_ROW(t) \
+  ((t)<<4)|0, ((t)<<4)|1, ((t)<<4)|2, ((t)<<4)|3, ((t)<<4)|4, \
+  ((t)<<4)|5, ((t)<<4)|6, ((t)<<4)|7, ((t)<<4)|8, ((t)<<4)|9
+
+const uint8_t ds3231_bin2bcd_table[100] = {
+  DS3231_BIN2BCD_ROW(0), DS3231_BIN2BCD_ROW(1), DS3231_BIN2BCD_ROW(2), DS3231_BIN2BCD_ROW(3),
+  DS3231_BIN2BCD_ROW(4), DS3231_BIN2BCD_ROW(5), DS3231_BIN2BCD_ROW(6), DS3231_BIN2BCD_ROW(7),
+  DS3231_BIN2BCD_ROW(8), DS3231_BIN2BCD_ROW(9),
+};
+
+/* --------------------------------------------------------------------------
+ * Timekeeping registers masks
+ * -------------------------------------------------------------------------- */
+
+#define DS3231_SECONDS_BCD_MASK   ( DS3231_FIELD_MASK(ds3231_seconds, seconds) | DS3231_FIELD_MASK(ds3231_seconds, _10_seconds) )
+#define DS3231_MINUTES_BCD_MASK   ( DS3231_FIELD_MASK(ds3231_minutes, minutes) | DS3231_FIELD_MASK(ds3231_minutes, _10_minutes) )
+#define DS3231_HOUR12_BCD_MASK    ( DS3231_FIELD_MASK(ds3231_hour, hour) | DS3231_FIELD_MASK(ds3231_hour, _10_hour) )
+#define DS3231_HOUR24_BCD_MASK    ( DS3231_HOUR12_BCD_MASK | DS3231_FIELD_MASK(ds3231_hour, ampm20hour) )
+#define DS3231_DAY_MASK           ( DS3231_FIELD_MASK(ds3231_day, day) )
+#define DS3231_DATE_BCD_MASK      ( DS3231_FIELD_MASK(ds3231_date, date) | DS3231_FIELD_MASK(ds3231_date, _10_date) )
+#define DS3231_MONTH_BCD_MASK     ( DS3231_FIELD_MASK(ds3231_monthcentury, month) | DS3231_FIELD_MASK(ds3231_monthcentury, _10_month) )
+
+/* --------------------------------------------------------------------------
+ * Unix time conversion
+ *
+ * Days are counted from 1600-03-01, the start of a 400-year cycle, with the
+ * years starting in March so the leap day is the last day of a year. Divisions
+ * by constants are done as multiplication and shift, exact over the range of
+ * the dividend noted for each of them.
+ * -------------------------------------------------------------------------- */
+
+#define DS3231_EPOCH_BASE_YEAR        (1600U)
+#define DS3231_EPOCH_DAYS_PER_ERA     (146097U)
+#define DS3231_EPOCH_UNIX_DAYS        (135080U) // days from 1600-03-01 to 1970-01-01
+#define DS3231_EPOCH_SECONDS_PER_DAY  (86400U)
+
+#define DS3231_UDIV32(x, m, s)  ( (uint32_t)( ( (uint32_t)(x) * (m) ) >> (s) ) )
+#define DS3231_UDIV64(x, m, s)  ( (uint32_t)( ( (uint64_t)(x) * (m) ) >> (s) ) )
+
+#define DS3231_DIV5(x)          DS3231_UDIV32( x, 1639U, 13 )       // x < 1700
+#define DS3231_DIV60(x)         DS3231_UDIV32( x, 2185U, 17 )       // x < 3600
+#define DS3231_DIV100(x)        DS3231_UDIV32( x, 41U, 12 )         // x < 600
+#define DS3231_DIV153(x)        DS3231_UDIV32( x, 857U, 17 )        // x < 2000
+#define DS3231_DIV365(x)        DS3231_UDIV32( x, 22983U, 23 )      // x < 36525
+#define DS3231_DIV3600(x)       DS3231_UDIV32( x, 37283U, 27 )      // x < 86400
+#define DS3231_DIV9131(x)       DS3231_UDIV32( x, 29399U, 28 )      // x < 36525
+#define DS3231_DIV7_L(x)        DS3231_UDIV64( x, 149797U, 20 )     // x < 2^17
+#define DS3231_DIV365_L(x)      DS3231_UDIV64( x, 45965U, 24 )      // x < 146097
+#define DS3231_DIV675_L(x)      DS3231_UDIV64( x, 101806633U, 36 )  // x < 2^26
+
+/*!
+ * \brief Returns the days from 1600-03-01 to the date, years 1600 - 2399.
+ */
+static uint32_t ds3231_days_from_civil(uint32_t year, uint32_t month, uint32_t date)
+{
+  uint32_t before_march = ( month <= 2 );
+  uint32_t y = year - DS3231_EPOCH_BASE_YEAR - before_march;
+  uint32_t mp = before_march ? month + 9 : month - 3;
+  uint32_t doy = DS3231_DIV5( 153 * mp + 2 ) + date - 1;
+  uint32_t centuries = DS3231_DIV100( y );
+  return y * 365 + ( y >> 2 ) - centuries + ( centuries >> 2 ) + doy;
+}
+
+/*!
+ * \brief Converts the days from 1600-03-01 to the date, years 1600 - 2399.
+ */
+static void ds3231_civil_from_days(uint32_t days, ds3231_datetime_t *datetime)
+{
+  uint32_t era = ( days >= DS3231_EPOCH_DAYS_PER_ERA );
+  uint32_t doe = days - era * DS3231_EPOCH_DAYS_PER_ERA;
+  // doe / 1460 and doe / 36524 are taken as ( doe / 4 ) / 365 and ( doe / 4 ) / 9131
+  uint32_t yoe = DS3231_DIV365_L( doe - DS3231_DIV365( doe >> 2 ) + DS3231_DIV9131( doe >> 2 ) - ( doe == DS3231_EPOCH_DAYS_PER_ERA - 1 ) );
+  uint32_t doy = doe - ( yoe * 365 + ( yoe >> 2 ) - DS3231_DIV100( yoe ) );
+  uint32_t mp = DS3231_DIV153( 5 * doy + 2 );
+  uint32_t month = ( mp < 10 ) ? mp + 3 : mp - 9;
+  datetime->date = doy - DS3231_DIV5( 153 * mp + 2 ) + 1;
+  datetime->month = month;
+  datetime->year = DS3231_EPOCH_BASE_YEAR + era * 400 + yoe + ( month <= 2 );
+}
+
+// days of each month of a common year, indexed by month - 1
+static const uint8_t ds3231_days_in_month[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+/*!
+ * \brief Returns the days of the month, years DS3231_DATETIME_YEAR_MIN - DS3231_DATETIME_YEAR_MAX.
+ *
+ * Within these years a year is leap when divisible by 4, except 2100.
+ */
+static uint8_t ds3231_month_days(uint32_t year, uint32_t month)
+{
+  bool leap = ( ( year & 3U ) == 0 ) && ( year != 2100U );
+  return ds3231_days_in_month[month - 1] + ( ( month == 2 ) && leap );
+}
+
+/*!
+ * \brief Checks the ranges of the date and time values.
+ */
+static bool ds3231_datetime_valid(const ds3231_datetime_t *datetime)
+{
+  if( datetime->year < DS3231_DATETIME_YEAR_MIN || datetime->year > DS3231_DATETIME_YEAR_MAX ) {
+    return false;
+  }
+  if( datetime->month < 1 || datetime->month > 12 ) {
+    return false;
+  }
+  if( datetime->date < 1 || datetime->date > ds3231_month_days( datetime->year, datetime->month ) ) {
+    return false;
+  }
+  if( datetime->day < 1 || datetime->day > 7 ) {
+    return false;
+  }
+  if( datetime->hour > 23 || datetime->minutes > 59 || datetime->seconds > 59 ) {
+    return false;
+  }
+  return true;
+}
+
+EMBEDD_RESULT ds3231_datetime_to_epoch(const ds3231_datetime_t *datetime, int64_t *epoch)
+{
+  if( datetime == NULL || epoch == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( !ds3231_datetime_valid( datetime ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint32_t days = ds3231_days_from_civil( datetime->year, datetime->month, datetime->date ) - DS3231_EPOCH_UNIX_DAYS;
+  uint32_t seconds = datetime->hour * 3600U + datetime->minutes * 60U + datetime->seconds;
+  *epoch = (int64_t)days * DS3231_EPOCH_SECONDS_PER_DAY + seconds;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_epoch_to_datetime(int64_t epoch, ds3231_datetime_t *datetime)
+{
+  if( datetime == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( epoch < DS3231_EPOCH_MIN || epoch > DS3231_EPOCH_MAX ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  // 86400 = 128 * 675
+  uint32_t days = DS3231_DIV675_L( (uint32_t)( (uint64_t)epoch >> 7 ) );
+  uint32_t seconds = (uint32_t)( (uint64_t)epoch - (uint64_t)days * DS3231_EPOCH_SECONDS_PER_DAY );
+  ds3231_civil_from_days( days + DS3231_EPOCH_UNIX_DAYS, datetime );
+  // 1970-01-01 was Thursday
+  uint32_t weekday = days + 3;
+  datetime->day = weekday - DS3231_DIV7_L( weekday ) * 7 + 1;
+  datetime->hour = DS3231_DIV3600( seconds );
+  seconds -= datetime->hour * 3600U;
+  datetime->minutes = DS3231_DIV60( seconds );
+  datetime->seconds = seconds - datetime->minutes * 60U;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_datetime_from_regs(const ds3231_time_regs_t *regs, ds3231_datetime_t *datetime)
+{
+  if( regs == NULL || datetime == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint8_t raw[sizeof(ds3231_time_regs_t)];
+  memcpy( raw, regs, sizeof(raw) );
+
+  uint8_t hour = raw[ds3231_hour_read_reg_addr];
+  if( hour & DS3231_FIELD_MASK(ds3231_hour, _1224) ) {
+    uint8_t hour12 = ds3231_bcd2bin( hour & DS3231_HOUR12_BCD_MASK );
+    hour12 = ( hour12 == 12 ) ? 0 : hour12;
+    datetime->hour = ( hour & DS3231_FIELD_MASK(ds3231_hour, ampm20hour) ) ? hour12 + 12 : hour12;
+  } else {
+    datetime->hour = ds3231_bcd2bin( hour & DS3231_HOUR24_BCD_MASK );
+  }
+
+  uint8_t monthcentury = raw[ds3231_monthcentury_read_reg_addr];
+  datetime->year = DS3231_DATETIME_YEAR_MIN + ds3231_bcd2bin( raw[ds3231_year_read_reg_addr] )
+                 + ( ( monthcentury & DS3231_FIELD_MASK(ds3231_monthcentury, century) ) ? 100 : 0 );
+  datetime->month = ds3231_bcd2bin( monthcentury & DS3231_MONTH_BCD_MASK );
+  datetime->date = ds3231_bcd2bin( raw[ds3231_date_read_reg_addr] & DS3231_DATE_BCD_MASK );
+  datetime->day = raw[ds3231_day_read_reg_addr] & DS3231_DAY_MASK;
+  datetime->minutes = ds3231_bcd2bin( raw[ds3231_minutes_read_reg_addr] & DS3231_MINUTES_BCD_MASK );
+  datetime->seconds = ds3231_bcd2bin( raw[ds3231_seconds_read_reg_addr] & DS3231_SECONDS_BCD_MASK );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_datetime_to_regs(const ds3231_datetime_t *datetime, ds3231_time_regs_t *regs)
+{
+  if( regs == NULL || datetime == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( !ds3231_datetime_valid( datetime ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+
+  uint8_t year = datetime->year - DS3231_DATETIME_YEAR_MIN;
+  uint8_t century = 0;
+  if( year >= 100 ) {
+    year -= 100;
+    century = DS3231_FIELD_MASK(ds3231_monthcentury, century);
+  }
+
+  uint8_t raw[sizeof(ds3231_time_regs_t)];
+  raw[ds3231_seconds_write_reg_addr] = ds3231_bin2bcd( datetime->seconds );
+  raw[ds3231_minutes_write_reg_addr] = ds3231_bin2bcd( datetime->minutes );
+  raw[ds3231_hour_write_reg_addr] = ds3231_bin2bcd( datetime->hour );
+  raw[ds3231_day_write_reg_addr] = datetime->day;
+  raw[ds3231_date_write_reg_addr] = ds3231_bin2bcd( datetime->date );
+  raw[ds3231_monthcentury_write_reg_addr] = ds3231_bin2bcd( datetime->month ) | century;
+  raw[ds3231_year_write_reg_addr] = ds3231_bin2bcd( year );
+  memcpy( regs, raw, sizeof(raw) );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_get_datetime(embedd_device_t *dev, ds3231_datetime_t *datetime)
+{
+  ds3231_time_regs_t regs;
+  EMBEDD_RESULT result = ds3231_get_datetime_regs( dev, &regs );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  return ds3231_datetime_from_regs( &regs, datetime );
+}
+
+EMBEDD_RESULT ds3231_set_datetime(embedd_device_t *dev, const ds3231_datetime_t *datetime)
+{
+  ds3231_time_regs_t regs;
+  EMBEDD_RESULT result = ds3231_datetime_to_regs( datetime, &regs );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  return ds3231_set_datetime_regs( dev, &regs );
+}
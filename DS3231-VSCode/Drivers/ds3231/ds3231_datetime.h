@@ -0,0 +1,180 @@
+/*!
+ * \file ds3231_datetime.h
+ * \brief Ds3231 date and time
+ *
+ * Conversion of the timekeeping registers to and from a binary date and time.
+ * BCD values are converted by lookup tables, so no division is needed on
+ * cores without a hardware divider.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_DATETIME_H
+#define _SRC_DS3231_DATETIME_H
+
+#include <stdint.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+
+/*!
+ * \def DS3231_DATETIME_YEAR_MIN
+ * \brief First year representable by the device, the century bit extends the range by 100 years
+ */
+#define DS3231_DATETIME_YEAR_MIN (2000U)
+
+/*!
+ * \def DS3231_DATETIME_YEAR_MAX
+ * \brief Last year representable by the device
+ */
+#define DS3231_DATETIME_YEAR_MAX (2199U)
+
+/*!
+ * \def DS3231_EPOCH_MIN
+ * \brief Unix time of 2000-01-01 00:00:00, the first second representable by the device
+ */
+#define DS3231_EPOCH_MIN (946684800LL)
+
+/*!
+ * \def DS3231_EPOCH_MAX
+ * \brief Unix time of 2199-12-31 23:59:59, the last second representable by the device
+ */
+#define DS3231_EPOCH_MAX (7258118399LL)
+
+/*!
+ * \struct ds3231_datetime_t
+ * \brief Binary date and time
+ *
+ * \var year     year, DS3231_DATETIME_YEAR_MIN - DS3231_DATETIME_YEAR_MAX
+ * \var month    month, 1 - 12
+ * \var date     day of the month, 1 - the days of the month
+ * \var day      day of the week, 1 - 7, its meaning is defined by the user
+ * \var hour     hour in 24-hour format, 0 - 23
+ * \var minutes  minutes, 0 - 59
+ * \var seconds  seconds, 0 - 59
+ */
+typedef struct {
+  uint16_t year;
+  uint8_t month;
+  uint8_t date;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minutes;
+  uint8_t seconds;
+} ds3231_datetime_t;
+
+/*!
+ * \var ds3231_bcd2bin_table
+ * \brief Binary value of every BCD byte, indexed by the BCD byte
+ */
+extern const uint8_t ds3231_bcd2bin_table[256];
+
+/*!
+ * \var ds3231_bin2bcd_table
+ * \brief BCD byte of every binary value 0 - 99, indexed by the value
+ */
+extern const uint8_t ds3231_bin2bcd_table[100];
+
+/*!
+ * \brief Converts a BCD byte to its binary value.
+ */
+static inline uint8_t ds3231_bcd2bin(uint8_t bcd)
+{
+  return ds3231_bcd2bin_table[bcd];
+}
+
+/*!
+ * \brief Converts a binary value 0 - 99 to its BCD byte.
+ */
+static inline uint8_t ds3231_bin2bcd(uint8_t bin)
+{
+  return ds3231_bin2bcd_table[bin];
+}
+
+/*!
+ * \brief Decodes the image of the timekeeping registers.
+ *
+ * Hours in 12-hour format are converted to 24-hour format.
+ *
+ * \param regs Pointer to the image of the timekeeping registers.
+ * \param datetime Pointer to the decoded date and time.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_datetime_from_regs(const ds3231_time_regs_t *regs, ds3231_datetime_t *datetime);
+
+/*!
+ * \brief Encodes the date and time to the image of the timekeeping registers.
+ *
+ * Hours are encoded in 24-hour format.
+ *
+ * \param datetime Pointer to the date and time.
+ * \param regs Pointer to the image of the timekeeping registers.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if a value is out of its range.
+ *
+ */
+EMBEDD_RESULT ds3231_datetime_to_regs(const ds3231_datetime_t *datetime, ds3231_time_regs_t *regs);
+
+/*!
+ * \brief Converts the date and time, taken as UTC, to Unix time.
+ *
+ * \param datetime Pointer to the date and time.
+ * \param epoch Pointer to the seconds since 1970-01-01 00:00:00.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if a value is out of its range.
+ *
+ */
+EMBEDD_RESULT ds3231_datetime_to_epoch(const ds3231_datetime_t *datetime, int64_t *epoch);
+
+/*!
+ * \brief Converts Unix time to date and time in UTC.
+ *
+ * The day of the week is set as in ISO 8601, 1 for Monday to 7 for Sunday.
+ *
+ * \param epoch Seconds since 1970-01-01 00:00:00, DS3231_EPOCH_MIN - DS3231_EPOCH_MAX.
+ * \param datetime Pointer to the date and time.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if \a epoch is out of its range.
+ *
+ */
+EMBEDD_RESULT ds3231_epoch_to_datetime(int64_t epoch, ds3231_datetime_t *datetime);
+
+/*!
+ * \brief Reads date and time of the DS3231 device with a single burst read.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param datetime Pointer to the date and time.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_get_datetime(embedd_device_t *dev, ds3231_datetime_t *datetime);
+
+/*!
+ * \brief Sets date and time of the DS3231 device with a single burst write.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param datetime Pointer to the date and time.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_set_datetime(embedd_device_t *dev, const ds3231_datetime_t *datetime);
+
+#endif//_SRC_DS3231_DATETIME_H
@@ -40,6 +40,16 @@ enum {
  * Event description: Triggered by a match between the timekeeping registers and Alarm 2 registers.
  * -------------------------------------------------------------------------- */
   DS3231_ALARM_2_MATCH_EVENT_ID = 0xb110889c,
+/* -------------------------------------------------------------------------- 
+ * Event name: Snapshot Updated
+ * Event description: Triggered when a new snapshot of the register map is published.
+ * -------------------------------------------------------------------------- */
+  DS3231_SNAPSHOT_UPDATED_EVENT_ID = 0xbe37f3b8,
+/* -------------------------------------------------------------------------- 
+ * Event name: Temperature Ready
+ * Event description: Triggered when a requested temperature conversion is completed and its result is read.
+ * -------------------------------------------------------------------------- */
+  DS3231_TEMPERATURE_READY_EVENT_ID = 0xba6fb41c,
 };
 
 #endif//_SRC_DS3231_EVENTS_H
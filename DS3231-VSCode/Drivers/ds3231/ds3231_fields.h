@@ -0,0 +1,407 @@
+/*!
+ * \file ds3231_fields.h
+ * \brief Ds3231 register fields
+ *
+ * This file contains position and width of every field of the Ds3231
+ * registers. The bitfield structures declared in ds3231_data_types.h take
+ * their widths from here and allocate their fields starting from the least
+ * significant bit, so the fields of each register are checked to follow one
+ * another in declaration order and to fill the byte.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+#ifndef _SRC_DS3231_FIELDS_H
+#define _SRC_DS3231_FIELDS_H
+
+#include <stdint.h>
+
+/*!
+ * \macro DS3231_FIELD_MASK
+ * \brief Mask of a register field
+ *
+ * \param _typename typename for register
+ * \param _field name of the field in the register's data type
+ */
+#define DS3231_FIELD_MASK(_typename, _field) \
+  ((uint8_t)(((1U << _typename##_##_field##_width) - 1U) << _typename##_##_field##_shift))
+
+/*!
+ * \macro DS3231_FIELD_VALUE
+ * \brief Value of a register field shifted to its position in the register
+ *
+ * \param _typename typename for register
+ * \param _field name of the field in the register's data type
+ * \param val value of the field
+ */
+#define DS3231_FIELD_VALUE(_typename, _field, val) \
+  ((uint8_t)(((uint32_t)(val) << _typename##_##_field##_shift) & DS3231_FIELD_MASK(_typename, _field)))
+
+/*!
+ * \macro DS3231_FIELD_FIRST
+ * \brief Checks that the first field of a register starts at bit 0
+ *
+ * \param _typename typename for register
+ * \param _field name of the first field in the register's data type
+ */
+#define DS3231_FIELD_FIRST(_typename, _field) \
+  _Static_assert(_typename##_##_field##_shift == 0, #_typename "." #_field " does not start at bit 0")
+
+/*!
+ * \macro DS3231_FIELD_NEXT
+ * \brief Checks that a field starts right after the field declared before it
+ *
+ * \param _typename typename for register
+ * \param _field name of the field declared before
+ * \param _next name of the field declared after it
+ */
+#define DS3231_FIELD_NEXT(_typename, _field, _next) \
+  _Static_assert(_typename##_##_field##_shift + _typename##_##_field##_width == _typename##_##_next##_shift, \
+                 #_typename "." #_next " does not follow " #_field)
+
+/*!
+ * \macro DS3231_FIELD_LAST
+ * \brief Checks that the last field of a register ends at bit 7
+ *
+ * \param _typename typename for register
+ * \param _field name of the last field in the register's data type
+ */
+#define DS3231_FIELD_LAST(_typename, _field) \
+  _Static_assert(_typename##_##_field##_shift + _typename##_##_field##_width == 8, #_typename "." #_field " does not end at bit 7")
+
+/* --------------------------------------------------------------------------
+ * Register name: Seconds
+ * -------------------------------------------------------------------------- */
+#define ds3231_seconds_seconds_shift 0
+#define ds3231_seconds_seconds_width 4
+#define ds3231_seconds__10_seconds_shift 4
+#define ds3231_seconds__10_seconds_width 3
+#define ds3231_seconds_reserved_shift 7
+#define ds3231_seconds_reserved_width 1
+
+DS3231_FIELD_FIRST(ds3231_seconds, seconds);
+DS3231_FIELD_NEXT(ds3231_seconds, seconds, _10_seconds);
+DS3231_FIELD_NEXT(ds3231_seconds, _10_seconds, reserved);
+DS3231_FIELD_LAST(ds3231_seconds, reserved);
+
+/* --------------------------------------------------------------------------
+ * Register name: Minutes
+ * -------------------------------------------------------------------------- */
+#define ds3231_minutes_minutes_shift 0
+#define ds3231_minutes_minutes_width 4
+#define ds3231_minutes__10_minutes_shift 4
+#define ds3231_minutes__10_minutes_width 3
+#define ds3231_minutes_reserved_shift 7
+#define ds3231_minutes_reserved_width 1
+
+DS3231_FIELD_FIRST(ds3231_minutes, minutes);
+DS3231_FIELD_NEXT(ds3231_minutes, minutes, _10_minutes);
+DS3231_FIELD_NEXT(ds3231_minutes, _10_minutes, reserved);
+DS3231_FIELD_LAST(ds3231_minutes, reserved);
+
+/* --------------------------------------------------------------------------
+ * Register name: Hour
+ * -------------------------------------------------------------------------- */
+#define ds3231_hour_hour_shift 0
+#define ds3231_hour_hour_width 4
+#define ds3231_hour__10_hour_shift 4
+#define ds3231_hour__10_hour_width 1
+#define ds3231_hour_ampm20hour_shift 5
+#define ds3231_hour_ampm20hour_width 1
+#define ds3231_hour__1224_shift 6
+#define ds3231_hour__1224_width 1
+#define ds3231_hour_reserved_shift 7
+#define ds3231_hour_reserved_width 1
+
+DS3231_FIELD_FIRST(ds3231_hour, hour);
+DS3231_FIELD_NEXT(ds3231_hour, hour, _10_hour);
+DS3231_FIELD_NEXT(ds3231_hour, _10_hour, ampm20hour);
+DS3231_FIELD_NEXT(ds3231_hour, ampm20hour, _1224);
+DS3231_FIELD_NEXT(ds3231_hour, _1224, reserved);
+DS3231_FIELD_LAST(ds3231_hour, reserved);
+
+/* --------------------------------------------------------------------------
+ * Register name: Day
+ * -------------------------------------------------------------------------- */
+#define ds3231_day_day_shift 0
+#define ds3231_day_day_width 3
+#define ds3231_day_reserved_shift 3
+#define ds3231_day_reserved_width 5
+
+DS3231_FIELD_FIRST(ds3231_day, day);
+DS3231_FIELD_NEXT(ds3231_day, day, reserved);
+DS3231_FIELD_LAST(ds3231_day, reserved);
+
+/* --------------------------------------------------------------------------
+ * Register name: Date
+ * -------------------------------------------------------------------------- */
+#define ds3231_date_date_shift 0
+#define ds3231_date_date_width 4
+#define ds3231_date__10_date_shift 4
+#define ds3231_date__10_date_width 2
+#define ds3231_date_rsv_1_shift 6
+#define ds3231_date_rsv_1_width 2
+
+DS3231_FIELD_FIRST(ds3231_date, date);
+DS3231_FIELD_NEXT(ds3231_date, date, _10_date);
+DS3231_FIELD_NEXT(ds3231_date, _10_date, rsv_1);
+DS3231_FIELD_LAST(ds3231_date, rsv_1);
+
+/* --------------------------------------------------------------------------
+ * Register name: Month/Century
+ * -------------------------------------------------------------------------- */
+#define ds3231_monthcentury_month_shift 0
+#define ds3231_monthcentury_month_width 4
+#define ds3231_monthcentury__10_month_shift 4
+#define ds3231_monthcentury__10_month_width 1
+#define ds3231_monthcentury_rsv_shift 5
+#define ds3231_monthcentury_rsv_width 2
+#define ds3231_monthcentury_century_shift 7
+#define ds3231_monthcentury_century_width 1
+
+DS3231_FIELD_FIRST(ds3231_monthcentury, month);
+DS3231_FIELD_NEXT(ds3231_monthcentury, month, _10_month);
+DS3231_FIELD_NEXT(ds3231_monthcentury, _10_month, rsv);
+DS3231_FIELD_NEXT(ds3231_monthcentury, rsv, century);
+DS3231_FIELD_LAST(ds3231_monthcentury, century);
+
+/* --------------------------------------------------------------------------
+ * Register name: Year
+ * -------------------------------------------------------------------------- */
+#define ds3231_year_year_shift 0
+#define ds3231_year_year_width 4
+#define ds3231_year__10_year_shift 4
+#define ds3231_year__10_year_width 4
+
+DS3231_FIELD_FIRST(ds3231_year, year);
+DS3231_FIELD_NEXT(ds3231_year, year, _10_year);
+DS3231_FIELD_LAST(ds3231_year, _10_year);
+
+/* --------------------------------------------------------------------------
+ * Register name: Alarm 1 Seconds
+ * -------------------------------------------------------------------------- */
+#define ds3231_alarm_1_seconds_seconds_shift 0
+#define ds3231_alarm_1_seconds_seconds_width 4
+#define ds3231_alarm_1_seconds__10_seconds_shift 4
+#define ds3231_alarm_1_seconds__10_seconds_width 3
+#define ds3231_alarm_1_seconds_a1m1_shift 7
+#define ds3231_alarm_1_seconds_a1m1_width 1
+
+DS3231_FIELD_FIRST(ds3231_alarm_1_seconds, seconds);
+DS3231_FIELD_NEXT(ds3231_alarm_1_seconds, seconds, _10_seconds);
+DS3231_FIELD_NEXT(ds3231_alarm_1_seconds, _10_seconds, a1m1);
+DS3231_FIELD_LAST(ds3231_alarm_1_seconds, a1m1);
+
+/* --------------------------------------------------------------------------
+ * Register name: Alarm 1 Minutes
+ * -------------------------------------------------------------------------- */
+#define ds3231_alarm_1_minutes_minutes_shift 0
+#define ds3231_alarm_1_minutes_minutes_width 4
+#define ds3231_alarm_1_minutes__10_minutes_shift 4
+#define ds3231_alarm_1_minutes__10_minutes_width 3
+#define ds3231_alarm_1_minutes_a1m2_shift 7
+#define ds3231_alarm_1_minutes_a1m2_width 1
+
+DS3231_FIELD_FIRST(ds3231_alarm_1_minutes, minutes);
+DS3231_FIELD_NEXT(ds3231_alarm_1_minutes, minutes, _10_minutes);
+DS3231_FIELD_NEXT(ds3231_alarm_1_minutes, _10_minutes, a1m2);
+DS3231_FIELD_LAST(ds3231_alarm_1_minutes, a1m2);
+
+/* --------------------------------------------------------------------------
+ * Register name: Alarm 1 Hour
+ * -------------------------------------------------------------------------- */
+#define ds3231_alarm_1_hour_hour_shift 0
+#define ds3231_alarm_1_hour_hour_width 4
+#define ds3231_alarm_1_hour__10_hour_shift 4
+#define ds3231_alarm_1_hour__10_hour_width 1
+#define ds3231_alarm_1_hour_ampm20hour_shift 5
+#define ds3231_alarm_1_hour_ampm20hour_width 1
+#define ds3231_alarm_1_hour__1224_shift 6
+#define ds3231_alarm_1_hour__1224_width 1
+#define ds3231_alarm_1_hour_a1m3_shift 7
+#define ds3231_alarm_1_hour_a1m3_width 1
+
+DS3231_FIELD_FIRST(ds3231_alarm_1_hour, hour);
+DS3231_FIELD_NEXT(ds3231_alarm_1_hour, hour, _10_hour);
+DS3231_FIELD_NEXT(ds3231_alarm_1_hour, _10_hour, ampm20hour);
+DS3231_FIELD_NEXT(ds3231_alarm_1_hour, ampm20hour, _1224);
+DS3231_FIELD_NEXT(ds3231_alarm_1_hour, _1224, a1m3);
+DS3231_FIELD_LAST(ds3231_alarm_1_hour, a1m3);
+
+/* --------------------------------------------------------------------------
+ * Register name: Alarm 1 Day/Date
+ * -------------------------------------------------------------------------- */
+#define ds3231_alarm_1_daydate_daydate_shift 0
+#define ds3231_alarm_1_daydate_daydate_width 4
+#define ds3231_alarm_1_daydate__10_date_shift 4
+#define ds3231_alarm_1_daydate__10_date_width 2
+#define ds3231_alarm_1_daydate_dydt_shift 6
+#define ds3231_alarm_1_daydate_dydt_width 1
+#define ds3231_alarm_1_daydate_a1m4_shift 7
+#define ds3231_alarm_1_daydate_a1m4_width 1
+
+DS3231_FIELD_FIRST(ds3231_alarm_1_daydate, daydate);
+DS3231_FIELD_NEXT(ds3231_alarm_1_daydate, daydate, _10_date);
+DS3231_FIELD_NEXT(ds3231_alarm_1_daydate, _10_date, dydt);
+DS3231_FIELD_NEXT(ds3231_alarm_1_daydate, dydt, a1m4);
+DS3231_FIELD_LAST(ds3231_alarm_1_daydate, a1m4);
+
+/* --------------------------------------------------------------------------
+ * Register name: Alarm 2 Minutes
+ * -------------------------------------------------------------------------- */
+#define ds3231_alarm_2_minutes_minutes_shift 0
+#define ds3231_alarm_2_minutes_minutes_width 4
+#define ds3231_alarm_2_minutes__10_minutes_shift 4
+#define ds3231_alarm_2_minutes__10_minutes_width 3
+#define ds3231_alarm_2_minutes_a2m2_shift 7
+#define ds3231_alarm_2_minutes_a2m2_width 1
+
+DS3231_FIELD_FIRST(ds3231_alarm_2_minutes, minutes);
+DS3231_FIELD_NEXT(ds3231_alarm_2_minutes, minutes, _10_minutes);
+DS3231_FIELD_NEXT(ds3231_alarm_2_minutes, _10_minutes, a2m2);
+DS3231_FIELD_LAST(ds3231_alarm_2_minutes, a2m2);
+
+/* --------------------------------------------------------------------------
+ * Register name: Alarm 2 Hour
+ * -------------------------------------------------------------------------- */
+#define ds3231_alarm_2_hour_hour_shift 0
+#define ds3231_alarm_2_hour_hour_width 4
+#define ds3231_alarm_2_hour__10_hour_shift 4
+#define ds3231_alarm_2_hour__10_hour_width 1
+#define ds3231_alarm_2_hour_ampm20hour_shift 5
+#define ds3231_alarm_2_hour_ampm20hour_width 1
+#define ds3231_alarm_2_hour__1224_shift 6
+#define ds3231_alarm_2_hour__1224_width 1
+#define ds3231_alarm_2_hour_a2m3_shift 7
+#define ds3231_alarm_2_hour_a2m3_width 1
+
+DS3231_FIELD_FIRST(ds3231_alarm_2_hour, hour);
+DS3231_FIELD_NEXT(ds3231_alarm_2_hour, hour, _10_hour);
+DS3231_FIELD_NEXT(ds3231_alarm_2_hour, _10_hour, ampm20hour);
+DS3231_FIELD_NEXT(ds3231_alarm_2_hour, ampm20hour, _1224);
+DS3231_FIELD_NEXT(ds3231_alarm_2_hour, _1224, a2m3);
+DS3231_FIELD_LAST(ds3231_alarm_2_hour, a2m3);
+
+/* --------------------------------------------------------------------------
+ * Register name: Alarm 2 Day/Date
+ * -------------------------------------------------------------------------- */
+#define ds3231_alarm_2_daydate_daydate_shift 0
+#define ds3231_alarm_2_daydate_daydate_width 4
+#define ds3231_alarm_2_daydate__10_date_shift 4
+#define ds3231_alarm_2_daydate__10_date_width 2
+#define ds3231_alarm_2_daydate_dydt_shift 6
+#define ds3231_alarm_2_daydate_dydt_width 1
+#define ds3231_alarm_2_daydate_a2m4_shift 7
+#define ds3231_alarm_2_daydate_a2m4_width 1
+
+DS3231_FIELD_FIRST(ds3231_alarm_2_daydate, daydate);
+DS3231_FIELD_NEXT(ds3231_alarm_2_daydate, daydate, _10_date);
+DS3231_FIELD_NEXT(ds3231_alarm_2_daydate, _10_date, dydt);
+DS3231_FIELD_NEXT(ds3231_alarm_2_daydate, dydt, a2m4);
+DS3231_FIELD_LAST(ds3231_alarm_2_daydate, a2m4);
+
+/* --------------------------------------------------------------------------
+ * Register name: Control
+ * -------------------------------------------------------------------------- */
+#define ds3231_control_a1ie_shift 0
+#define ds3231_control_a1ie_width 1
+#define ds3231_control_a2ie_shift 1
+#define ds3231_control_a2ie_width 1
+#define ds3231_control_intcn_shift 2
+#define ds3231_control_intcn_width 1
+#define ds3231_control_rs1_shift 3
+#define ds3231_control_rs1_width 1
+#define ds3231_control_rs2_shift 4
+#define ds3231_control_rs2_width 1
+#define ds3231_control_conv_shift 5
+#define ds3231_control_conv_width 1
+#define ds3231_control_bbsqw_shift 6
+#define ds3231_control_bbsqw_width 1
+#define ds3231_control_eosc_shift 7
+#define ds3231_control_eosc_width 1
+
+DS3231_FIELD_FIRST(ds3231_control, a1ie);
+DS3231_FIELD_NEXT(ds3231_control, a1ie, a2ie);
+DS3231_FIELD_NEXT(ds3231_control, a2ie, intcn);
+DS3231_FIELD_NEXT(ds3231_control, intcn, rs1);
+DS3231_FIELD_NEXT(ds3231_control, rs1, rs2);
+DS3231_FIELD_NEXT(ds3231_control, rs2, conv);
+DS3231_FIELD_NEXT(ds3231_control, conv, bbsqw);
+DS3231_FIELD_NEXT(ds3231_control, bbsqw, eosc);
+DS3231_FIELD_LAST(ds3231_control, eosc);
+
+/* --------------------------------------------------------------------------
+ * Register name: Status
+ * -------------------------------------------------------------------------- */
+#define ds3231_status_a1f_shift 0
+#define ds3231_status_a1f_width 1
+#define ds3231_status_a2f_shift 1
+#define ds3231_status_a2f_width 1
+#define ds3231_status_bsy_shift 2
+#define ds3231_status_bsy_width 1
+#define ds3231_status_en32khz_shift 3
+#define ds3231_status_en32khz_width 1
+#define ds3231_status_reserved_shift 4
+#define ds3231_status_reserved_width 3
+#define ds3231_status_ocf_shift 7
+#define ds3231_status_ocf_width 1
+
+DS3231_FIELD_FIRST(ds3231_status, a1f);
+DS3231_FIELD_NEXT(ds3231_status, a1f, a2f);
+DS3231_FIELD_NEXT(ds3231_status, a2f, bsy);
+DS3231_FIELD_NEXT(ds3231_status, bsy, en32khz);
+DS3231_FIELD_NEXT(ds3231_status, en32khz, reserved);
+DS3231_FIELD_NEXT(ds3231_status, reserved, ocf);
+DS3231_FIELD_LAST(ds3231_status, ocf);
+
+/* --------------------------------------------------------------------------
+ * Register name: Aging Offset
+ * -------------------------------------------------------------------------- */
+#define ds3231_aging_offset_data_shift 0
+#define ds3231_aging_offset_data_width 7
+#define ds3231_aging_offset_sign_shift 7
+#define ds3231_aging_offset_sign_width 1
+
+DS3231_FIELD_FIRST(ds3231_aging_offset, data);
+DS3231_FIELD_NEXT(ds3231_aging_offset, data, sign);
+DS3231_FIELD_LAST(ds3231_aging_offset, sign);
+
+/* --------------------------------------------------------------------------
+ * Register name: MSB of Temp
+ * -------------------------------------------------------------------------- */
+#define ds3231_msb_of_temp_data_shift 0
+#define ds3231_msb_of_temp_data_width 7
+#define ds3231_msb_of_temp_sign_shift 7
+#define ds3231_msb_of_temp_sign_width 1
+
+DS3231_FIELD_FIRST(ds3231_msb_of_temp, data);
+DS3231_FIELD_NEXT(ds3231_msb_of_temp, data, sign);
+DS3231_FIELD_LAST(ds3231_msb_of_temp, sign);
+
+/* --------------------------------------------------------------------------
+ * Register name: LSB of Temp
+ * -------------------------------------------------------------------------- */
+#define ds3231_lsb_of_temp_rsvd_shift 0
+#define ds3231_lsb_of_temp_rsvd_width 6
+#define ds3231_lsb_of_temp_tmplsb_shift 6
+#define ds3231_lsb_of_temp_tmplsb_width 2
+
+DS3231_FIELD_FIRST(ds3231_lsb_of_temp, rsvd);
+DS3231_FIELD_NEXT(ds3231_lsb_of_temp, rsvd, tmplsb);
+DS3231_FIELD_LAST(ds3231_lsb_of_temp, tmplsb);
+
+#endif//_SRC_DS3231_FIELDS_H
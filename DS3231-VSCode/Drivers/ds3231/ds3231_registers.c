@@ -23,9 +23,252 @@
 #include "embedd_driver.h"
 #include "embedd_misc.h"
 #include "embedd_hal.h"
+#include "embedd_event.h"
 
 #include "ds3231_registers.h"
 #include "ds3231_data_types.h"
+#include "ds3231_fields.h"
+
+/* --------------------------------------------------------------------------
+ * Ds3231 shadow registers
+ * -------------------------------------------------------------------------- */
+
+/*!
+ * \struct ds3231_reg_policy_t
+ * \brief Caching policy of a register
+ *
+ * \var policy DS3231_REG_POLICY_VOLATILE or DS3231_REG_POLICY_CACHED
+ * \var self_clearing bits cleared by the device itself after they are written with 1
+ */
+typedef struct {
+  uint8_t policy;
+  uint8_t self_clearing;
+} ds3231_reg_policy_t;
+
+static const ds3231_reg_policy_t ds3231_reg_policy[DS3231_REGISTER_MAP_SIZE] = {
+  [ds3231_seconds_read_reg_addr]         = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_minutes_read_reg_addr]         = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_hour_read_reg_addr]            = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_day_read_reg_addr]             = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_date_read_reg_addr]            = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_monthcentury_read_reg_addr]    = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_year_read_reg_addr]            = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_alarm_1_seconds_read_reg_addr] = { DS3231_REG_POLICY_CACHED,   0 },
+  [ds3231_alarm_1_minutes_read_reg_addr] = { DS3231_REG_POLICY_CACHED,   0 },
+  [ds3231_alarm_1_hour_read_reg_addr]    = { DS3231_REG_POLICY_CACHED,   0 },
+  [ds3231_alarm_1_daydate_read_reg_addr] = { DS3231_REG_POLICY_CACHED,   0 },
+  [ds3231_alarm_2_minutes_read_reg_addr] = { DS3231_REG_POLICY_CACHED,   0 },
+  [ds3231_alarm_2_hour_read_reg_addr]    = { DS3231_REG_POLICY_CACHED,   0 },
+  [ds3231_alarm_2_daydate_read_reg_addr] = { DS3231_REG_POLICY_CACHED,   0 },
+  // CONV is cleared by the device when the temperature conversion is completed
+  [ds3231_control_read_reg_addr]         = { DS3231_REG_POLICY_CACHED,   DS3231_FIELD_MASK(ds3231_control, conv) },
+  [ds3231_status_read_reg_addr]          = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_aging_offset_read_reg_addr]    = { DS3231_REG_POLICY_CACHED,   0 },
+  [ds3231_msb_of_temp_read_reg_addr]     = { DS3231_REG_POLICY_VOLATILE, 0 },
+  [ds3231_lsb_of_temp_read_reg_addr]     = { DS3231_REG_POLICY_VOLATILE, 0 },
+};
+
+static inline uint32_t ds3231_reg_range_mask(uint32_t first_addr, uint32_t count)
+{
+  return ( ( 1UL << count ) - 1UL ) << first_addr;
+}
+
+static bool ds3231_reg_range_cacheable(uint32_t first_addr, uint32_t count)
+{
+  for( uint32_t addr = first_addr; addr < first_addr + count; ++addr ) {
+    if( ds3231_reg_policy[addr].policy != DS3231_REG_POLICY_CACHED ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * \brief Copies the range from the shadow registers if all of them are staged, or cached and up to date.
+ */
+static bool ds3231_shadow_lookup(ds3231_shadow_t *shadow, uint32_t first_addr, uint32_t count, uint8_t *dst)
+{
+  if( first_addr + count > DS3231_REGISTER_MAP_SIZE ) {
+    return false;
+  }
+  uint32_t mask = ds3231_reg_range_mask( first_addr, count );
+  if( ( shadow->dirty & mask ) != mask ) {
+    if( !ds3231_reg_range_cacheable( first_addr, count ) ) {
+      return false;
+    }
+    if( ( ( shadow->valid | shadow->dirty ) & mask ) != mask ) {
+      ++ shadow->stats.misses;
+      return false;
+    }
+  }
+  embedd_copy( dst, &shadow->regs[first_addr], count );
+  ++ shadow->stats.hits;
+  return true;
+}
+
+/*!
+ * \brief Stores the cached registers of the range written to the device.
+ */
+static void ds3231_shadow_update(ds3231_shadow_t *shadow, uint32_t first_addr, uint32_t count, const uint8_t *src)
+{
+  for( uint32_t i = 0; ( i < count ) && ( first_addr + i < DS3231_REGISTER_MAP_SIZE ); ++i ) {
+    const ds3231_reg_policy_t *policy = &ds3231_reg_policy[first_addr + i];
+    uint32_t bit = 1UL << ( first_addr + i );
+    if( policy->policy == DS3231_REG_POLICY_CACHED ) {
+      shadow->regs[first_addr + i] = src[i] & (uint8_t)~policy->self_clearing;
+      shadow->valid |= bit;
+    }
+    shadow->dirty &= ~bit;
+  }
+}
+
+/*!
+ * \brief Stores the cached registers of the range read from the device and
+ * replaces the staged ones in \a buf with their not yet flushed values.
+ */
+static void ds3231_shadow_merge(ds3231_shadow_t *shadow, uint32_t first_addr, uint32_t count, uint8_t *buf)
+{
+  for( uint32_t i = 0; ( i < count ) && ( first_addr + i < DS3231_REGISTER_MAP_SIZE ); ++i ) {
+    uint32_t bit = 1UL << ( first_addr + i );
+    if( shadow->dirty & bit ) {
+      buf[i] = shadow->regs[first_addr + i];
+    } else if( ds3231_reg_policy[first_addr + i].policy == DS3231_REG_POLICY_CACHED ) {
+      shadow->regs[first_addr + i] = buf[i] & (uint8_t)~ds3231_reg_policy[first_addr + i].self_clearing;
+      shadow->valid |= bit;
+    }
+  }
+}
+
+/*!
+ * \brief Puts the range into the shadow registers and marks it dirty.
+ */
+static EMBEDD_RESULT ds3231_shadow_stage(ds3231_shadow_t *shadow, uint32_t first_addr, uint32_t count, const uint8_t *src)
+{
+  if( count == 0 || first_addr + count > DS3231_REGISTER_MAP_SIZE ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  embedd_copy( &shadow->regs[first_addr], (void*)src, count );
+  shadow->dirty |= ds3231_reg_range_mask( first_addr, count );
+  return EMBEDD_RESULT_OK;
+}
+
+/*!
+ * \brief Stores the result of the asynchronous transfer and reports it by its event, from the main context.
+ */
+static void ds3231_async_complete(embedd_device_t *dev, ds3231_async_t *async, EMBEDD_RESULT result)
+{
+  async->result = result;
+  async->busy = 0;
+  embedd_event_manager_trigger( async->event_id, dev );
+}
+
+/*!
+ * \brief Reports the transfer completed by the bus, returns whether the device is still busy.
+ *
+ * The event queue has a single producer, the main context, so the event of a
+ * transfer completed in an interrupt is triggered here rather than by the
+ * completion callback. The device stays busy until then, so the state of the
+ * transfer is not reused before its event is triggered.
+ */
+static bool ds3231_async_poll(embedd_device_t *dev, ds3231_async_t *async)
+{
+  if( __atomic_load_n( &async->done, __ATOMIC_ACQUIRE ) ) {
+    async->done = 0;
+    ds3231_async_complete( dev, async, async->result );
+  }
+  return async->busy != 0;
+}
+
+/*!
+ * \brief Returns the maximum count of registers a single write may carry on the device bus.
+ */
+static inline uint32_t ds3231_write_max_count(const embedd_device_t *dev)
+{
+  return ( dev->bus->writev != NULL ) ? DS3231_REGISTER_MAP_SIZE : DS3231_MAX_BURST_REG_COUNT;
+}
+
+/*!
+ * \brief Sends the register address followed by the range data.
+ *
+ * With a vectored bus the address and \a src go out as two segments, otherwise
+ * \a src is copied into the output buffer after the address unless it is already there.
+ */
+static EMBEDD_RESULT ds3231_write_range(embedd_device_t *dev, ds3231_data_t *_data, uint32_t first_addr, uint32_t count, const uint8_t *src)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_ERR;
+  if( ds3231_async_poll( dev, &_data->async ) || count > ds3231_write_max_count( dev ) ) {
+    return result;
+  }
+  if( dev->bus->writev != NULL ) {
+    uint8_t addr[DS3231_REGISTER_ADDR_SIZE];
+    embedd_pack_sized( addr, &first_addr, DS3231_REGISTER_ADDR_SIZE );
+    const embedd_bus_iovec_t iov[] = {
+      { .data_ptr = addr,         .data_size = DS3231_REGISTER_ADDR_SIZE },
+      { .data_ptr = (void*)src,   .data_size = count },
+    };
+    result = dev->bus->writev( dev, iov, CountOfArray(iov) );
+  } else {
+    uint8_t* _out_ptr = _data->out_buf;
+    embedd_pack_sized( _out_ptr, &first_addr, DS3231_REGISTER_ADDR_SIZE );
+    if( src != _out_ptr + DS3231_REGISTER_ADDR_SIZE ) {
+      embedd_copy( _out_ptr + DS3231_REGISTER_ADDR_SIZE, (void*)src, count );
+    }
+    result = dev->bus->write( dev, _out_ptr, DS3231_REGISTER_ADDR_SIZE + count );
+  }
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  ds3231_shadow_update( &_data->shadow, first_addr, count, src );
+  return result;
+}
+
+/*!
+ * \brief Sets the register pointer to \a first_addr and reads the range into \a dst.
+ *
+ * Uses a single write-read transfer with a repeated start when the bus provides it
+ * and no delay is required between the two halves.
+ */
+static EMBEDD_RESULT ds3231_read_range(embedd_device_t *dev, ds3231_data_t *_data, uint32_t first_addr, uint32_t count, uint8_t *dst, uint32_t delay)
+{
+  if( ds3231_async_poll( dev, &_data->async ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint8_t* _out_ptr = _data->out_buf;
+  embedd_pack_sized( _out_ptr, &first_addr, DS3231_REGISTER_ADDR_SIZE );
+  if( ( dev->bus->write_read != NULL ) && ( delay == 0 ) ) {
+    return dev->bus->write_read( dev, _out_ptr, DS3231_REGISTER_ADDR_SIZE, dst, count );
+  }
+  EMBEDD_RESULT result = dev->bus->write( dev, _out_ptr, DS3231_REGISTER_ADDR_SIZE );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  if( delay != 0 ) {
+    embedd_hal_sleep( delay );
+  }
+  return dev->bus->read( dev, dst, count );
+}
+
+/*!
+ * \brief Completion callback of the asynchronous bus transfers, may be called from an interrupt.
+ */
+static void ds3231_async_done(const embedd_device_t *dev, EMBEDD_RESULT result)
+{
+  ds3231_data_t* _data = (ds3231_data_t*)dev->data;
+  ds3231_async_t* async = &_data->async;
+  if( result == EMBEDD_RESULT_OK ) {
+    if( async->is_read ) {
+      ds3231_shadow_merge( &_data->shadow, async->reg_addr, async->reg_size, async->data );
+      if( async->data != async->reg ) {
+        embedd_unpack_sized( async->reg, async->data, async->reg_size );
+      }
+    } else {
+      ds3231_shadow_update( &_data->shadow, async->reg_addr, async->reg_size, async->data );
+    }
+  }
+  async->result = result;
+  // the result and the data are in place before the main context sees the flag
+  __atomic_store_n( &async->done, 1, __ATOMIC_RELEASE );
+}
 
 /* --------------------------------------------------------------------------
  * Ds3231 register access methods
@@ -44,14 +287,19 @@ EMBEDD_RESULT ds3231_write_reg(embedd_device_t *dev, uint32_t reg_addr, void *re
     return result;
   }
   ds3231_data_t* _data = (ds3231_data_t*)dev->data;
-  if(_data->out_buf == NULL) {
-    return result;
+  // single byte registers need no reversal and are sent straight from the caller buffer
+  const uint8_t* _payload = reg;
+  if( reg_size > 1 ) {
+    if( DS3231_REGISTER_ADDR_SIZE + reg_size > ds3231_write_message_max_size ) {
+      return result;
+    }
+    _payload = _data->out_buf + DS3231_REGISTER_ADDR_SIZE;
+    embedd_pack_sized( _data->out_buf + DS3231_REGISTER_ADDR_SIZE, reg, reg_size );
   }
-  uint32_t msg_size = DS3231_REGISTER_ADDR_SIZE + reg_size ;
-  uint8_t* _out_ptr = _data->out_buf;
-  embedd_pack( _out_ptr, &reg_addr, DS3231_REGISTER_ADDR_SIZE );
-  embedd_pack( _out_ptr + DS3231_REGISTER_ADDR_SIZE, reg, reg_size );
-  result = dev->bus->write( dev, _out_ptr, msg_size );
+  if( _data->shadow.staging ) {
+    return ds3231_shadow_stage( &_data->shadow, reg_addr, reg_size, _payload );
+  }
+  result = ds3231_write_range( dev, _data, reg_addr, reg_size, _payload );
   if(result != EMBEDD_RESULT_OK) {
     return result;
   }
@@ -72,23 +320,333 @@ EMBEDD_RESULT ds3231_read_reg(embedd_device_t *dev, uint32_t reg_addr, void *reg
     return result;
   }
   ds3231_data_t* _data = (ds3231_data_t*)dev->data;
-  if( _data->out_buf == NULL || _data->in_buf == NULL ) {
+  // single byte registers need no reversal and are read straight into the caller buffer
+  uint8_t* _in_ptr  = ( reg_size > 1 ) ? _data->in_buf : reg;
+  if( reg_size > ds3231_read_message_max_size ) {
+    return result;
+  }
+  if( ds3231_shadow_lookup( &_data->shadow, reg_addr, reg_size, _in_ptr ) ) {
+    if( _in_ptr != reg ) {
+      embedd_unpack_sized( reg, _in_ptr, reg_size );
+    }
+    return EMBEDD_RESULT_OK;
+  }
+  result = ds3231_read_range( dev, _data, reg_addr, reg_size, _in_ptr, delay );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  ds3231_shadow_merge( &_data->shadow, reg_addr, reg_size, _in_ptr );
+  if( _in_ptr != reg ) {
+    embedd_unpack_sized( reg, _in_ptr, reg_size );
+  }
+  return result;
+}
+
+EMBEDD_RESULT ds3231_read_regs(embedd_device_t *dev, uint32_t first_addr, uint32_t count, void *regs)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_ERR;
+  if( dev == NULL || regs == NULL ) {
+    return result;
+  }
+  if( ( dev->bus == NULL ) || ( dev->data == NULL ) ) {
+    return result;
+  }
+  if( dev->bus->write == NULL || dev->bus->read == NULL ) {
+    return result;
+  }
+  if( count == 0 || first_addr + count > DS3231_REGISTER_MAP_SIZE ) {
+    return result;
+  }
+  ds3231_data_t* _data = (ds3231_data_t*)dev->data;
+  // registers are transferred in address order, so the data lands directly in the caller buffer
+  uint8_t* _in_ptr  = regs;
+  if( ds3231_shadow_lookup( &_data->shadow, first_addr, count, _in_ptr ) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  result = ds3231_read_range( dev, _data, first_addr, count, _in_ptr, 0 );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  ds3231_shadow_merge( &_data->shadow, first_addr, count, _in_ptr );
+  return result;
+}
+
+EMBEDD_RESULT ds3231_write_regs(embedd_device_t *dev, uint32_t first_addr, uint32_t count, const void *regs)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_ERR;
+  if( dev == NULL || regs == NULL ) {
+    return result;
+  }
+  if( ( dev->bus == NULL ) || ( dev->data == NULL ) ) {
+    return result;
+  }
+  if( dev->bus->write == NULL ) {
+    return result;
+  }
+  if( count == 0 || first_addr + count > DS3231_REGISTER_MAP_SIZE ) {
+    return result;
+  }
+  ds3231_data_t* _data = (ds3231_data_t*)dev->data;
+  if( _data->shadow.staging ) {
+    return ds3231_shadow_stage( &_data->shadow, first_addr, count, regs );
+  }
+  return ds3231_write_range( dev, _data, first_addr, count, regs );
+}
+
+EMBEDD_RESULT ds3231_set_datetime_regs(embedd_device_t *dev, const ds3231_time_regs_t *time)
+{
+  return ds3231_write_regs( dev, ds3231_seconds_write_reg_addr, sizeof(ds3231_time_regs_t), time );
+}
+
+EMBEDD_RESULT ds3231_get_datetime_regs(embedd_device_t *dev, ds3231_time_regs_t *time)
+{
+  return ds3231_read_regs( dev, ds3231_seconds_read_reg_addr, sizeof(ds3231_time_regs_t), time );
+}
+
+EMBEDD_RESULT ds3231_cache_get_stats(embedd_device_t *dev, ds3231_cache_stats_t *stats)
+{
+  if( dev == NULL || dev->data == NULL || stats == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  *stats = ((ds3231_data_t*)dev->data)->shadow.stats;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_cache_invalidate(embedd_device_t *dev)
+{
+  if( dev == NULL || dev->data == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  ((ds3231_data_t*)dev->data)->shadow.valid = 0;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_stage_begin(embedd_device_t *dev)
+{
+  if( dev == NULL || dev->data == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  ((ds3231_data_t*)dev->data)->shadow.staging = 1;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_flush(embedd_device_t *dev)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_ERR;
+  if( dev == NULL ) {
+    return result;
+  }
+  if( ( dev->bus == NULL ) || ( dev->data == NULL ) ) {
+    return result;
+  }
+  if( dev->bus->write == NULL ) {
+    return result;
+  }
+  ds3231_data_t* _data = (ds3231_data_t*)dev->data;
+  ds3231_shadow_t* shadow = &_data->shadow;
+  uint32_t max_count = ds3231_write_max_count( dev );
+  for( uint32_t addr = 0; addr < DS3231_REGISTER_MAP_SIZE; ++addr ) {
+    if( !( shadow->dirty & ( 1UL << addr ) ) ) {
+      continue;
+    }
+    // extend the range up to the last dirty register, bridging the gaps with known cached values
+    uint32_t first_addr = addr;
+    uint32_t last_addr = addr;
+    for( uint32_t next = addr + 1; ( next < DS3231_REGISTER_MAP_SIZE ) && ( next - first_addr < max_count ); ++next ) {
+      uint32_t bit = 1UL << next;
+      if( shadow->dirty & bit ) {
+        last_addr = next;
+      } else if( ( ds3231_reg_policy[next].policy != DS3231_REG_POLICY_CACHED ) || !( shadow->valid & bit ) ) {
+        break;
+      }
+    }
+    uint32_t count = last_addr - first_addr + 1;
+    result = ds3231_write_range( dev, _data, first_addr, count, &shadow->regs[first_addr] );
+    if( result != EMBEDD_RESULT_OK ) {
+      return result;
+    }
+    addr = last_addr;
+  }
+  shadow->staging = 0;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_update_bits(embedd_device_t *dev, uint32_t reg_addr, uint8_t mask, uint8_t value)
+{
+  uint8_t reg = 0;
+  EMBEDD_RESULT result = ds3231_read_reg( dev, reg_addr, &reg, sizeof(reg), 0 );
+  if( result != EMBEDD_RESULT_OK ) {
     return result;
   }
-  uint32_t msg_size = DS3231_REGISTER_ADDR_SIZE;
+  uint8_t updated = ( reg & (uint8_t)~mask ) | ( value & mask );
+  if( updated == reg ) {
+    return result;
+  }
+  return ds3231_write_reg( dev, reg_addr, &updated, sizeof(updated), 0 );
+}
+
+EMBEDD_RESULT ds3231_read_field(embedd_device_t *dev, uint32_t reg_addr, uint8_t mask, uint8_t shift, uint8_t *value)
+{
+  if( value == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint8_t reg = 0;
+  EMBEDD_RESULT result = ds3231_read_reg( dev, reg_addr, &reg, sizeof(reg), 0 );
+  if( result != EMBEDD_RESULT_OK ) {
+    return result;
+  }
+  *value = ( reg & mask ) >> shift;
+  return result;
+}
+
+EMBEDD_RESULT ds3231_write_reg_async(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, int event_id)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_ERR;
+  if( dev == NULL || reg == NULL ) {
+    return result;
+  }
+  if( ( dev->bus == NULL ) || ( dev->data == NULL ) ) {
+    return result;
+  }
+  if( dev->bus->write_async == NULL ) {
+    return result;
+  }
+  if( reg_size == 0 || DS3231_REGISTER_ADDR_SIZE + reg_size > ds3231_write_message_max_size ) {
+    return result;
+  }
+  ds3231_data_t* _data = (ds3231_data_t*)dev->data;
+  ds3231_async_t* async = &_data->async;
+  if( ds3231_async_poll( dev, async ) ) {
+    return result;
+  }
+  async->busy = 1;
+  async->is_read = 0;
+  async->event_id = event_id;
+  async->reg_addr = reg_addr;
+  async->reg = NULL;
+  async->reg_size = reg_size;
+  async->data = _data->out_buf + DS3231_REGISTER_ADDR_SIZE;
   uint8_t* _out_ptr = _data->out_buf;
-  uint8_t* _in_ptr  = _data->in_buf;
-  embedd_pack( _out_ptr, &reg_addr, DS3231_REGISTER_ADDR_SIZE );
-  result = dev->bus->write( dev, _out_ptr, msg_size );
+  embedd_pack_sized( _out_ptr, &reg_addr, DS3231_REGISTER_ADDR_SIZE );
+  embedd_pack_sized( _out_ptr + DS3231_REGISTER_ADDR_SIZE, reg, reg_size );
+  if( _data->shadow.staging ) {
+    ds3231_async_complete( dev, async, ds3231_shadow_stage( &_data->shadow, reg_addr, reg_size, _out_ptr + DS3231_REGISTER_ADDR_SIZE ) );
+    return EMBEDD_RESULT_OK;
+  }
+  result = dev->bus->write_async( dev, _out_ptr, DS3231_REGISTER_ADDR_SIZE + reg_size, ds3231_async_done );
   if( result != EMBEDD_RESULT_OK ) {
+    async->busy = 0;
+  }
+  return result;
+}
+
+EMBEDD_RESULT ds3231_read_reg_async(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, int event_id)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_ERR;
+  if( dev == NULL || reg == NULL ) {
+    return result;
+  }
+  if( ( dev->bus == NULL ) || ( dev->data == NULL ) ) {
+    return result;
+  }
+  if( dev->bus->write_read_async == NULL ) {
     return result;
   }
-  embedd_hal_sleep(delay);
-  result = dev->bus->read( dev, _in_ptr, reg_size );
+  if( reg_size == 0 || reg_size > ds3231_read_message_max_size ) {
+    return result;
+  }
+  ds3231_data_t* _data = (ds3231_data_t*)dev->data;
+  ds3231_async_t* async = &_data->async;
+  if( ds3231_async_poll( dev, async ) ) {
+    return result;
+  }
+  async->busy = 1;
+  async->is_read = 1;
+  async->event_id = event_id;
+  async->reg_addr = reg_addr;
+  async->reg = reg;
+  async->reg_size = reg_size;
+  uint8_t* _out_ptr = _data->out_buf;
+  // single byte registers need no reversal and are read straight into the caller buffer
+  uint8_t* _in_ptr  = ( reg_size > 1 ) ? _data->in_buf : reg;
+  async->data = _in_ptr;
+  if( ds3231_shadow_lookup( &_data->shadow, reg_addr, reg_size, _in_ptr ) ) {
+    if( _in_ptr != reg ) {
+      embedd_unpack_sized( reg, _in_ptr, reg_size );
+    }
+    ds3231_async_complete( dev, async, EMBEDD_RESULT_OK );
+    return EMBEDD_RESULT_OK;
+  }
+  embedd_pack_sized( _out_ptr, &reg_addr, DS3231_REGISTER_ADDR_SIZE );
+  result = dev->bus->write_read_async( dev, _out_ptr, DS3231_REGISTER_ADDR_SIZE, _in_ptr, reg_size, ds3231_async_done );
   if( result != EMBEDD_RESULT_OK ) {
+    async->busy = 0;
+  }
+  return result;
+}
+
+EMBEDD_RESULT ds3231_read_regs_async(embedd_device_t *dev, uint32_t first_addr, uint32_t count, void *regs, int event_id)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_ERR;
+  if( dev == NULL || regs == NULL ) {
+    return result;
+  }
+  if( ( dev->bus == NULL ) || ( dev->data == NULL ) ) {
+    return result;
+  }
+  if( dev->bus->write_read_async == NULL ) {
+    return result;
+  }
+  if( count == 0 || first_addr + count > DS3231_REGISTER_MAP_SIZE ) {
+    return result;
+  }
+  ds3231_data_t* _data = (ds3231_data_t*)dev->data;
+  ds3231_async_t* async = &_data->async;
+  if( ds3231_async_poll( dev, async ) ) {
     return result;
   }
-  embedd_pack( reg, _in_ptr, reg_size );
+  async->busy = 1;
+  async->is_read = 1;
+  async->event_id = event_id;
+  async->reg_addr = first_addr;
+  async->reg = regs;
+  async->reg_size = count;
+  // registers are transferred in address order, so the data lands directly in the caller buffer
+  async->data = regs;
+  if( ds3231_shadow_lookup( &_data->shadow, first_addr, count, regs ) ) {
+    ds3231_async_complete( dev, async, EMBEDD_RESULT_OK );
+    return EMBEDD_RESULT_OK;
+  }
+  uint8_t* _out_ptr = _data->out_buf;
+  embedd_pack_sized( _out_ptr, &first_addr, DS3231_REGISTER_ADDR_SIZE );
+  result = dev->bus->write_read_async( dev, _out_ptr, DS3231_REGISTER_ADDR_SIZE, regs, count, ds3231_async_done );
+  if( result != EMBEDD_RESULT_OK ) {
+    async->busy = 0;
+  }
   return result;
 }
 
+void ds3231_async_process(embedd_device_t *dev)
+{
+  if( dev == NULL || dev->data == NULL ) {
+    return;
+  }
+  ds3231_async_poll( dev, &((ds3231_data_t*)dev->data)->async );
+}
+
+bool ds3231_async_busy(embedd_device_t *dev)
+{
+  if( dev == NULL || dev->data == NULL ) {
+    return false;
+  }
+  return ds3231_async_poll( dev, &((ds3231_data_t*)dev->data)->async );
+}
+
+EMBEDD_RESULT ds3231_async_result(embedd_device_t *dev)
+{
+  if( dev == NULL || dev->data == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  ds3231_async_poll( dev, &((ds3231_data_t*)dev->data)->async );
+  return ((ds3231_data_t*)dev->data)->async.result;
+}
@@ -23,6 +23,7 @@
 #ifndef _SRC_DS3231_REGISTERS_H
 #define _SRC_DS3231_REGISTERS_H
 
+#include <stdbool.h>
 #include "ds3231_data_types.h"
 
 /* --------------------------------------------------------------------------
@@ -67,12 +68,270 @@ EMBEDD_RESULT ds3231_write_reg(embedd_device_t *dev, uint32_t reg_addr, void *re
  */
 EMBEDD_RESULT ds3231_read_reg(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, uint32_t delay);
 
+/*!
+ * \brief Reads a contiguous range of registers of the DS3231 device.
+ *
+ * The register pointer is written once and the whole range is fetched by a
+ * single bus read, relying on the device's register pointer auto-increment.
+ * The data is stored in register address order, one byte per register, and
+ * is read directly into \a regs, so the range is not limited by the device buffers.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param first_addr The address of the first register of the range.
+ * \param count Count of registers to read.
+ * \param regs Pointer to the buffer where the read data will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_read_regs(embedd_device_t *dev, uint32_t first_addr, uint32_t count, void *regs);
+
+/*!
+ * \brief Writes a contiguous range of registers of the DS3231 device.
+ *
+ * The register address and all the data bytes are sent by one bus write, so
+ * the range is updated in a single transaction. When the bus provides writev
+ * the address and \a regs go out as two segments without being copied.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param first_addr The address of the first register of the range.
+ * \param count Count of registers to write, up to DS3231_MAX_BURST_REG_COUNT
+ *              unless the bus provides writev.
+ * \param regs Pointer to the data to write, one byte per register in address order.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_write_regs(embedd_device_t *dev, uint32_t first_addr, uint32_t count, const void *regs);
+
+/*!
+ * \brief Sets the timekeeping registers of the DS3231 device.
+ *
+ * Writes all the timekeeping registers (0x00 - 0x06) with a single burst
+ * write. The device resets its countdown chain when the seconds register is
+ * written, so the new time is applied atomically with respect to the internal
+ * rollover. See ds3231_set_datetime() for the binary date and time.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param time Pointer to the image of the timekeeping registers.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_set_datetime_regs(embedd_device_t *dev, const ds3231_time_regs_t *time);
+
+/*!
+ * \brief Reads the timekeeping registers of the DS3231 device.
+ *
+ * Reads all the timekeeping registers (0x00 - 0x06) with a single burst
+ * read, so they are consistent with each other. See ds3231_get_datetime()
+ * for the binary date and time.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param time Pointer to the image of the timekeeping registers.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_get_datetime_regs(embedd_device_t *dev, ds3231_time_regs_t *time);
+
+/*!
+ * \brief Returns the counters of the shadow register cache.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param stats Pointer to the structure the counters will be copied to.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_cache_get_stats(embedd_device_t *dev, ds3231_cache_stats_t *stats);
+
+/*!
+ * \brief Drops all the cached register values.
+ *
+ * Should be called when the device might have been reconfigured behind the
+ * driver's back, e.g. after a power loss or by another bus master. The next
+ * read of every register goes to the bus.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_cache_invalidate(embedd_device_t *dev);
+
+/*!
+ * \brief Enables the staged write mode.
+ *
+ * Subsequent register writes only update the shadow registers and mark them
+ * dirty, nothing is sent to the bus until ds3231_flush() is called. Reads of
+ * staged registers return the staged values.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_stage_begin(embedd_device_t *dev);
+
+/*!
+ * \brief Writes all the staged registers and leaves the staged write mode.
+ *
+ * Dirty registers are coalesced into contiguous ranges and each range is
+ * sent as one burst write. Gaps between dirty registers are bridged with
+ * the shadow values of cached registers, so e.g. both alarms and the control
+ * register go out as a single transaction. On error the remaining registers
+ * stay dirty and the staged write mode stays enabled, so the flush can be
+ * retried.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_flush(embedd_device_t *dev);
+
+/*!
+ * \brief Changes the selected bits of a register of the DS3231 device.
+ *
+ * The current register value is taken from the shadow registers when it is
+ * known, so for cached registers only the write goes to the bus. The write is
+ * skipped altogether if the register already holds the requested bits.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param reg_addr The register address to update.
+ * \param mask Mask of the bits to change.
+ * \param value New value of the bits, already shifted to their position.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_update_bits(embedd_device_t *dev, uint32_t reg_addr, uint8_t mask, uint8_t value);
+
+/*!
+ * \brief Reads a field of a register of the DS3231 device.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param reg_addr The register address to read from.
+ * \param mask Mask of the field's bits.
+ * \param shift Position of the field's least significant bit.
+ * \param value Pointer to the variable where the field value will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_read_field(embedd_device_t *dev, uint32_t reg_addr, uint8_t mask, uint8_t shift, uint8_t *value);
+
+/*!
+ * \brief Starts writing a register of the DS3231 device and returns without waiting for the bus.
+ *
+ * The data is copied, so \a reg may be reused right after the call. When the
+ * transfer is completed its result is stored and \a event_id is triggered with
+ * the device as event data, from the main context by the next call of
+ * ds3231_async_process() or of any other function of the device. No other
+ * access to the device may be started before that. Requires the write_async
+ * operation of the bus.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param reg_addr The register address to write to.
+ * \param reg Pointer to the data to be written.
+ * \param reg_size The size of the data to be written.
+ * \param event_id Event triggered when the transfer is completed.
+ *
+ * \return EMBEDD_RESULT_OK if the transfer is started, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_write_reg_async(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, int event_id);
+
+/*!
+ * \brief Starts reading a register of the DS3231 device and returns without waiting for the bus.
+ *
+ * \a reg must stay valid until \a event_id is triggered, it holds the data
+ * from then on if the transfer succeeded. Reads served by the shadow registers
+ * complete within the call. No other access to the device may be started
+ * before the event. Requires the write_read_async operation of the bus.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param reg_addr The register address to read from.
+ * \param reg Pointer to the buffer where the read data will be stored.
+ * \param reg_size The size of the data to be read.
+ * \param event_id Event triggered when the transfer is completed.
+ *
+ * \return EMBEDD_RESULT_OK if the transfer is started, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_read_reg_async(embedd_device_t *dev, uint32_t reg_addr, void *reg, uint32_t reg_size, int event_id);
+
+/*!
+ * \brief Starts reading a contiguous range of registers of the DS3231 device
+ * and returns without waiting for the bus.
+ *
+ * The bus transfers the data directly into \a regs, which must stay valid
+ * until \a event_id is triggered. Otherwise behaves as ds3231_read_reg_async().
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ * \param first_addr The address of the first register of the range.
+ * \param count Count of registers to read.
+ * \param regs Pointer to the buffer where the read data will be stored, in register address order.
+ * \param event_id Event triggered when the transfer is completed.
+ *
+ * \return EMBEDD_RESULT_OK if the transfer is started, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_read_regs_async(embedd_device_t *dev, uint32_t first_addr, uint32_t count, void *regs, int event_id);
+
+/*!
+ * \brief Triggers the event of the asynchronous transfer of the DS3231 device once the bus has completed it.
+ *
+ * The bus may complete the transfer in an interrupt, the event is triggered by
+ * this call instead, so all events are triggered from the main context. Call
+ * it from the main loop when waiting for the event of a transfer.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ *
+ */
+void ds3231_async_process(embedd_device_t *dev);
+
+/*!
+ * \brief Tells whether an asynchronous transfer of the DS3231 device is in flight.
+ *
+ * Triggers the event of a transfer completed by the bus, as ds3231_async_process().
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ *
+ * \return true while the transfer is in flight.
+ *
+ */
+bool ds3231_async_busy(embedd_device_t *dev);
+
+/*!
+ * \brief Returns the result of the last completed asynchronous transfer of the DS3231 device.
+ *
+ * \param dev Pointer to the embedd_device_t structure representing the device.
+ *
+ * \return EMBEDD_RESULT_OK if the transfer succeeded, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_async_result(embedd_device_t *dev);
+
 /* --------------------------------------------------------------------------
  * Registers constants
  * -------------------------------------------------------------------------- */
 
 #define DS3231_REGISTER_ADDR_SIZE (1)
 
+/*!
+ * \def DS3231_REG_POLICY_VOLATILE
+ * \brief The register is changed by the device, every read goes to the bus
+ */
+#define DS3231_REG_POLICY_VOLATILE 0
+
+/*!
+ * \def DS3231_REG_POLICY_CACHED
+ * \brief The register is changed only by the host, reads are served from the shadow copy
+ */
+#define DS3231_REG_POLICY_CACHED 1
+
 /* --------------------------------------------------------------------------
  * Register name: Seconds
  * Register description: This register contains the seconds value in BCD format.
@@ -0,0 +1,127 @@
+/*!
+ * \file ds3231_snapshot.c
+ * \brief Ds3231 register map snapshot
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "embedd_event.h"
+#include "embedd_misc.h"
+
+#include "ds3231_snapshot.h"
+#include "ds3231_registers.h"
+#include "ds3231_events.h"
+
+/*!
+ * \brief Makes the buffer filled by the last transfer the published one.
+ */
+static void ds3231_snapshot_publish(ds3231_snapshot_t *snap)
+{
+  uint32_t seq = snap->seq;
+  __atomic_store_n( &snap->seq, seq + 1, __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  snap->front ^= 1;
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  __atomic_store_n( &snap->seq, seq + 2, __ATOMIC_RELAXED );
+}
+
+EMBEDD_RESULT ds3231_snapshot_init(ds3231_snapshot_t *snap, embedd_device_t *dev, uint32_t period_ms)
+{
+  if( snap == NULL || dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( snap, 0, sizeof(ds3231_snapshot_t) );
+  snap->dev = dev;
+  snap->period_ms = period_ms;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_snapshot_process(ds3231_snapshot_t *snap, uint32_t now_ms)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_OK;
+  if( snap == NULL || snap->dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( snap->pending ) {
+    if( ds3231_async_busy( snap->dev ) ) {
+      return result;
+    }
+    snap->pending = 0;
+    if( ds3231_async_result( snap->dev ) == EMBEDD_RESULT_OK ) {
+      ds3231_snapshot_publish( snap );
+      embedd_event_manager_trigger( DS3231_SNAPSHOT_UPDATED_EVENT_ID, snap->dev );
+    } else {
+      ++ snap->errors;
+      result = EMBEDD_RESULT_ERR;
+    }
+  }
+  if( snap->started && ( (uint32_t)( now_ms - snap->last_ms ) < snap->period_ms ) ) {
+    return result;
+  }
+  if( ds3231_async_busy( snap->dev ) ) {
+    return result;
+  }
+  snap->started = 1;
+  snap->last_ms = now_ms;
+  if( ds3231_read_regs_async( snap->dev, ds3231_seconds_read_reg_addr, DS3231_REGISTER_MAP_SIZE,
+                              snap->buf[snap->front ^ 1], VOID_EVENT_ID ) != EMBEDD_RESULT_OK ) {
+    ++ snap->errors;
+    return EMBEDD_RESULT_ERR;
+  }
+  snap->pending = 1;
+  return result;
+}
+
+EMBEDD_RESULT ds3231_snapshot_read(const ds3231_snapshot_t *snap, uint8_t regs[DS3231_REGISTER_MAP_SIZE], uint32_t *seq)
+{
+  if( snap == NULL || regs == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  for( uint32_t attempt = 0; attempt < DS3231_SNAPSHOT_READ_RETRIES; ++attempt ) {
+    uint32_t begin = __atomic_load_n( &snap->seq, __ATOMIC_RELAXED );
+    if( begin == 0 ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    if( begin & 1 ) {
+      continue;
+    }
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    embedd_copy( regs, (void*)snap->buf[snap->front], DS3231_REGISTER_MAP_SIZE );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &snap->seq, __ATOMIC_RELAXED ) == begin ) {
+      if( seq != NULL ) {
+        *seq = begin;
+      }
+      return EMBEDD_RESULT_OK;
+    }
+  }
+  return EMBEDD_RESULT_ERR;
+}
+
+const uint8_t* ds3231_snapshot_latest(const ds3231_snapshot_t *snap, uint32_t *seq)
+{
+  if( snap == NULL || snap->seq == 0 ) {
+    return NULL;
+  }
+  if( seq != NULL ) {
+    *seq = snap->seq;
+  }
+  return snap->buf[snap->front];
+}
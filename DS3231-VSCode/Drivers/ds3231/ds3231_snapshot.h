@@ -0,0 +1,120 @@
+/*!
+ * \file ds3231_snapshot.h
+ * \brief Ds3231 register map snapshot
+ *
+ * Background engine reading the whole register map of the device at a fixed
+ * period with asynchronous bus transfers. The latest complete snapshot is
+ * published through a double buffer guarded by a sequence counter, so
+ * consumers get a consistent copy without touching the bus.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_SNAPSHOT_H
+#define _SRC_DS3231_SNAPSHOT_H
+
+#include <stdint.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+
+/*!
+ * \struct ds3231_snapshot_t
+ * \brief State of the snapshot engine
+ *
+ * \var dev        device the snapshots are taken from
+ * \var buf        double buffer, one published snapshot and one being transferred
+ * \var seq        sequence counter, odd while a snapshot is being published,
+ *                 incremented by 2 for each published snapshot, 0 before the first one
+ * \var front      index of the published buffer
+ * \var started    non-zero once the first transfer has been started
+ * \var pending    non-zero while a transfer into the other buffer is in flight
+ * \var period_ms  period of the snapshots in ms
+ * \var last_ms    time the last transfer was started at
+ * \var errors     count of failed transfers
+ */
+typedef struct {
+  embedd_device_t *dev;
+  uint8_t buf[2][DS3231_REGISTER_MAP_SIZE];
+  volatile uint32_t seq;
+  volatile uint8_t front;
+  uint8_t started;
+  uint8_t pending;
+  uint32_t period_ms;
+  uint32_t last_ms;
+  uint32_t errors;
+} ds3231_snapshot_t;
+
+/*!
+ * \brief Initializes the snapshot engine.
+ *
+ * \param snap Pointer to the snapshot engine.
+ * \param dev Pointer to the device, its bus must provide write_read_async.
+ * \param period_ms Period of the snapshots in ms.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_snapshot_init(ds3231_snapshot_t *snap, embedd_device_t *dev, uint32_t period_ms);
+
+/*!
+ * \brief Runs the snapshot engine, to be called periodically from the main loop.
+ *
+ * Publishes the snapshot whose transfer has completed and triggers
+ * DS3231_SNAPSHOT_UPDATED_EVENT_ID, then starts the next transfer once the
+ * period has elapsed. A period is skipped while another asynchronous transfer
+ * of the device is in flight.
+ *
+ * \param snap Pointer to the snapshot engine.
+ * \param now_ms Current time in ms.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if a transfer failed.
+ *
+ */
+EMBEDD_RESULT ds3231_snapshot_process(ds3231_snapshot_t *snap, uint32_t now_ms);
+
+/*!
+ * \brief Copies the latest published snapshot.
+ *
+ * Can be called from any context, the copy is retried if a snapshot is
+ * published meanwhile.
+ *
+ * \param snap Pointer to the snapshot engine.
+ * \param regs Buffer for the register map, indexed by register address.
+ * \param seq Optional pointer where the sequence counter of the copy will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if
+ *         nothing is published yet or no consistent copy could be made.
+ *
+ */
+EMBEDD_RESULT ds3231_snapshot_read(const ds3231_snapshot_t *snap, uint8_t regs[DS3231_REGISTER_MAP_SIZE], uint32_t *seq);
+
+/*!
+ * \brief Returns the latest published snapshot without copying it.
+ *
+ * Snapshots are published only by ds3231_snapshot_process(), so in the context
+ * calling it the returned buffer stays unchanged until its next call.
+ *
+ * \param snap Pointer to the snapshot engine.
+ * \param seq Optional pointer where the sequence counter of the snapshot will be stored.
+ *
+ * \return Pointer to the register map indexed by register address, NULL if nothing is published yet.
+ *
+ */
+const uint8_t* ds3231_snapshot_latest(const ds3231_snapshot_t *snap, uint32_t *seq);
+
+#endif//_SRC_DS3231_SNAPSHOT_H
@@ -0,0 +1,134 @@
+/*!
+ * \file ds3231_sqw.c
+ * \brief Ds3231 1 Hz square-wave edge capture
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "ds3231_sqw.h"
+#include "ds3231_datetime.h"
+#include "ds3231_registers.h"
+#include "ds3231_fields.h"
+
+#define DS3231_SQW_CONTROL_MASK   ( DS3231_FIELD_MASK(ds3231_control, intcn) | DS3231_FIELD_MASK(ds3231_control, rs1) | \
+                                    DS3231_FIELD_MASK(ds3231_control, rs2) )
+
+// edges come once per second, so a copy interrupted by one is always consistent on the next attempt
+#define DS3231_SQW_COPY_ATTEMPTS  (2U)
+
+EMBEDD_RESULT ds3231_sqw_init(ds3231_sqw_t *sqw, embedd_device_t *dev, ds3231_clock_ticks_t get_ticks)
+{
+  if( sqw == NULL || dev == NULL || get_ticks == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( sqw, 0, sizeof(ds3231_sqw_t) );
+  sqw->dev = dev;
+  sqw->get_ticks = get_ticks;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_sqw_enable(ds3231_sqw_t *sqw)
+{
+  if( sqw == NULL || sqw->dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  // INTCN = 0 selects the square wave, RS2 = RS1 = 0 selects 1 Hz
+  return ds3231_update_bits( sqw->dev, ds3231_control_write_reg_addr, DS3231_SQW_CONTROL_MASK, 0 );
+}
+
+void ds3231_sqw_capture(ds3231_sqw_t *sqw)
+{
+  // the pin may fire before the capture is initialized
+  if( sqw->get_ticks == NULL ) {
+    return;
+  }
+  uint32_t tick = sqw->get_ticks();
+  uint32_t count = sqw->count;
+  ds3231_sqw_edge_t *edge = &sqw->edges[count % DS3231_SQW_EDGE_COUNT];
+  edge->tick = tick;
+  edge->second = count;
+  __atomic_store_n( &sqw->count, count + 1, __ATOMIC_RELEASE );
+}
+
+EMBEDD_RESULT ds3231_sqw_sync(ds3231_sqw_t *sqw)
+{
+  ds3231_datetime_t datetime;
+  int64_t epoch;
+  if( sqw == NULL || sqw->dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  uint32_t count = __atomic_load_n( &sqw->count, __ATOMIC_ACQUIRE );
+  if( count == 0 ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( ds3231_get_datetime( sqw->dev, &datetime ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( ds3231_datetime_to_epoch( &datetime, &epoch ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  // the time read belongs to the last edge only if no edge came meanwhile
+  if( __atomic_load_n( &sqw->count, __ATOMIC_ACQUIRE ) != count ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  sqw->epoch_base = epoch - ( count - 1 );
+  sqw->synced = 1;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_sqw_get_edges(const ds3231_sqw_t *sqw, ds3231_sqw_edge_t *edges, uint32_t max_count, uint32_t *count)
+{
+  if( sqw == NULL || edges == NULL || count == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  for( uint32_t attempt = 0; attempt < DS3231_SQW_COPY_ATTEMPTS; ++attempt ) {
+    uint32_t captured = __atomic_load_n( &sqw->count, __ATOMIC_ACQUIRE );
+    if( captured == 0 ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    uint32_t n = captured < DS3231_SQW_EDGE_COUNT ? captured : DS3231_SQW_EDGE_COUNT;
+    if( n > max_count ) {
+      n = max_count;
+    }
+    for( uint32_t i = 0; i < n; ++i ) {
+      edges[i] = sqw->edges[( captured - n + i ) % DS3231_SQW_EDGE_COUNT];
+    }
+    if( __atomic_load_n( &sqw->count, __ATOMIC_ACQUIRE ) == captured ) {
+      *count = n;
+      return EMBEDD_RESULT_OK;
+    }
+  }
+  return EMBEDD_RESULT_ERR;
+}
+
+EMBEDD_RESULT ds3231_sqw_get_last(const ds3231_sqw_t *sqw, int64_t *epoch, uint32_t *tick)
+{
+  ds3231_sqw_edge_t edge;
+  uint32_t count;
+  if( sqw == NULL || epoch == NULL || tick == NULL || !sqw->synced ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( ds3231_sqw_get_edges( sqw, &edge, 1, &count ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  *epoch = sqw->epoch_base + edge.second;
+  *tick = edge.tick;
+  return EMBEDD_RESULT_OK;
+}
@@ -0,0 +1,140 @@
+/*!
+ * \file ds3231_sqw.h
+ * \brief Ds3231 1 Hz square-wave edge capture
+ *
+ * The INT/SQW output of the device is set to a 1 Hz square wave and its edges
+ * are captured by an interrupt, each one taking the value of a tick counter.
+ * The falling edge of the square wave is the moment the seconds register is
+ * incremented, so the captured ticks mark where each second of the device
+ * starts. The last DS3231_SQW_EDGE_COUNT edges are kept for drift computation.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_SQW_H
+#define _SRC_DS3231_SQW_H
+
+#include <stdint.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+#include "ds3231_clock.h"
+
+/*!
+ * \struct ds3231_sqw_edge_t
+ * \brief Captured second boundary
+ *
+ * \var tick    tick counter value at the edge
+ * \var second  index of the second starting at the edge, counted from the first captured edge
+ */
+typedef struct {
+  uint32_t tick;
+  uint32_t second;
+} ds3231_sqw_edge_t;
+
+/*!
+ * \struct ds3231_sqw_t
+ * \brief State of the edge capture
+ *
+ * \var dev         device generating the square wave
+ * \var get_ticks   tick counter taken at every edge
+ * \var edges       ring of the last captured edges
+ * \var count       count of captured edges, written only by ds3231_sqw_capture()
+ * \var synced      non-zero once epoch_base is known
+ * \var epoch_base  Unix time of the second with index 0
+ */
+typedef struct {
+  embedd_device_t *dev;
+  ds3231_clock_ticks_t get_ticks;
+  ds3231_sqw_edge_t edges[DS3231_SQW_EDGE_COUNT];
+  volatile uint32_t count;
+  uint8_t synced;
+  int64_t epoch_base;
+} ds3231_sqw_t;
+
+/*!
+ * \brief Initializes the edge capture.
+ *
+ * \param sqw Pointer to the edge capture.
+ * \param dev Pointer to the device.
+ * \param get_ticks Tick counter taken at every edge.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_sqw_init(ds3231_sqw_t *sqw, embedd_device_t *dev, ds3231_clock_ticks_t get_ticks);
+
+/*!
+ * \brief Sets the INT/SQW output of the device to a 1 Hz square wave.
+ *
+ * Clears INTCN, RS1 and RS2 of the control register, so the alarms no longer
+ * drive the pin.
+ *
+ * \param sqw Pointer to the edge capture.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_sqw_enable(ds3231_sqw_t *sqw);
+
+/*!
+ * \brief Captures an edge, to be called from the interrupt of the falling edge of INT/SQW.
+ *
+ * \param sqw Pointer to the edge capture.
+ *
+ */
+void ds3231_sqw_capture(ds3231_sqw_t *sqw);
+
+/*!
+ * \brief Reads the time of the device to assign Unix time to the captured seconds.
+ *
+ * Has to be called after an edge has been captured, fails if another edge is
+ * captured during the read, in which case it may be called again.
+ *
+ * \param sqw Pointer to the edge capture.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_sqw_sync(ds3231_sqw_t *sqw);
+
+/*!
+ * \brief Copies the last captured edges, oldest first.
+ *
+ * \param sqw Pointer to the edge capture.
+ * \param edges Buffer for the edges.
+ * \param max_count Size of the buffer in edges.
+ * \param count Pointer where the count of copied edges will be stored, at most DS3231_SQW_EDGE_COUNT.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if no edge has been captured.
+ *
+ */
+EMBEDD_RESULT ds3231_sqw_get_edges(const ds3231_sqw_t *sqw, ds3231_sqw_edge_t *edges, uint32_t max_count, uint32_t *count);
+
+/*!
+ * \brief Returns the last second boundary, e.g. to latch an interpolated clock with ds3231_clock_set().
+ *
+ * \param sqw Pointer to the edge capture.
+ * \param epoch Pointer where Unix time of the second starting at the edge will be stored.
+ * \param tick Pointer where the tick counter value at the edge will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if not synced yet.
+ *
+ */
+EMBEDD_RESULT ds3231_sqw_get_last(const ds3231_sqw_t *sqw, int64_t *epoch, uint32_t *tick);
+
+#endif//_SRC_DS3231_SQW_H
@@ -0,0 +1,125 @@
+/*!
+ * \file ds3231_temp.c
+ * \brief Ds3231 temperature conversion
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+
+#include <string.h>
+
+#include "embedd_event.h"
+
+#include "ds3231_temp.h"
+#include "ds3231_registers.h"
+#include "ds3231_fields.h"
+#include "ds3231_events.h"
+
+/*!
+ * \brief Abandons the conversion.
+ */
+static EMBEDD_RESULT ds3231_temp_fail(ds3231_temp_t *temp)
+{
+  temp->state = DS3231_TEMP_STATE_IDLE;
+  ++ temp->errors;
+  return EMBEDD_RESULT_ERR;
+}
+
+EMBEDD_RESULT ds3231_temp_init(ds3231_temp_t *temp, embedd_device_t *dev, uint32_t poll_ms)
+{
+  if( temp == NULL || dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( temp, 0, sizeof(ds3231_temp_t) );
+  temp->dev = dev;
+  temp->poll_ms = poll_ms;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_temp_start(ds3231_temp_t *temp, uint32_t now_ms)
+{
+  if( temp == NULL || temp->dev == NULL || temp->state != DS3231_TEMP_STATE_IDLE ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  temp->state = DS3231_TEMP_STATE_START;
+  temp->start_ms = now_ms;
+  // the first poll is due at once
+  temp->last_ms = now_ms - temp->poll_ms;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_temp_process(ds3231_temp_t *temp, uint32_t now_ms)
+{
+  uint8_t regs[2];
+  if( temp == NULL || temp->dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( temp->state == DS3231_TEMP_STATE_IDLE ) {
+    return EMBEDD_RESULT_OK;
+  }
+  if( (uint32_t)( now_ms - temp->last_ms ) < temp->poll_ms ) {
+    return EMBEDD_RESULT_OK;
+  }
+  if( (uint32_t)( now_ms - temp->start_ms ) > DS3231_TEMP_TIMEOUT_MS ) {
+    return ds3231_temp_fail( temp );
+  }
+  // the bus belongs to a transfer in flight, retry on the next call
+  if( ds3231_async_busy( temp->dev ) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  temp->last_ms = now_ms;
+  if( temp->state == DS3231_TEMP_STATE_START ) {
+    // a conversion must not be forced while the device runs its own one
+    if( ds3231_read_reg( temp->dev, ds3231_status_read_reg_addr, regs, sizeof(ds3231_status), ds3231_status_delay ) != EMBEDD_RESULT_OK ) {
+      return ds3231_temp_fail( temp );
+    }
+    if( regs[0] & DS3231_FIELD_MASK(ds3231_status, bsy) ) {
+      return EMBEDD_RESULT_OK;
+    }
+    if( ds3231_update_bits( temp->dev, ds3231_control_write_reg_addr, DS3231_FIELD_MASK(ds3231_control, conv),
+                            DS3231_FIELD_MASK(ds3231_control, conv) ) != EMBEDD_RESULT_OK ) {
+      return ds3231_temp_fail( temp );
+    }
+    temp->state = DS3231_TEMP_STATE_CONVERTING;
+    return EMBEDD_RESULT_OK;
+  }
+  // control and status in one transfer, the range is volatile so it is never served from the cache
+  if( ds3231_read_regs( temp->dev, ds3231_control_read_reg_addr, sizeof(regs), regs ) != EMBEDD_RESULT_OK ) {
+    return ds3231_temp_fail( temp );
+  }
+  if( ( regs[0] & DS3231_FIELD_MASK(ds3231_control, conv) ) || ( regs[1] & DS3231_FIELD_MASK(ds3231_status, bsy) ) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  if( ds3231_read_regs( temp->dev, ds3231_msb_of_temp_read_reg_addr, sizeof(regs), regs ) != EMBEDD_RESULT_OK ) {
+    return ds3231_temp_fail( temp );
+  }
+  temp->quarters = ds3231_temp_from_regs( regs[0], regs[1] );
+  temp->valid = 1;
+  temp->state = DS3231_TEMP_STATE_IDLE;
+  embedd_event_manager_trigger( DS3231_TEMPERATURE_READY_EVENT_ID, temp->dev );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_temp_get(const ds3231_temp_t *temp, int16_t *quarters)
+{
+  if( temp == NULL || quarters == NULL || !temp->valid ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  *quarters = temp->quarters;
+  return EMBEDD_RESULT_OK;
+}
@@ -0,0 +1,146 @@
+/*!
+ * \file ds3231_temp.h
+ * \brief Ds3231 temperature conversion
+ *
+ * Non-blocking temperature conversion driven from the main loop. A requested
+ * conversion is started by setting CONV once the device is not busy with its
+ * own TCXO conversion, then CONV and BSY are polled at a configurable cadence.
+ * When both are cleared the temperature registers are read in one burst and
+ * DS3231_TEMPERATURE_READY_EVENT_ID is triggered with the device as event data.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_TEMP_H
+#define _SRC_DS3231_TEMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+
+/*!
+ * \enum ds3231_temp_state_t
+ * \brief States of the temperature conversion
+ */
+typedef enum {
+  DS3231_TEMP_STATE_IDLE = 0,   // no conversion requested
+  DS3231_TEMP_STATE_START,      // requested, waiting for the device not to be busy
+  DS3231_TEMP_STATE_CONVERTING, // CONV set, waiting for CONV and BSY to be cleared
+} ds3231_temp_state_t;
+
+/*!
+ * \struct ds3231_temp_t
+ * \brief State of the temperature conversion
+ *
+ * \var dev         device converting the temperature
+ * \var state       state of the conversion
+ * \var poll_ms     period of polling the device in ms
+ * \var start_ms    time the conversion was requested at
+ * \var last_ms     time the device was polled at
+ * \var quarters    last temperature in 0.25 °C
+ * \var valid       non-zero once a temperature has been read
+ * \var errors      count of failed conversions
+ */
+typedef struct {
+  embedd_device_t *dev;
+  ds3231_temp_state_t state;
+  uint32_t poll_ms;
+  uint32_t start_ms;
+  uint32_t last_ms;
+  int16_t quarters;
+  uint8_t valid;
+  uint32_t errors;
+} ds3231_temp_t;
+
+/*!
+ * \brief Initializes the temperature conversion.
+ *
+ * \param temp Pointer to the temperature conversion.
+ * \param dev Pointer to the device.
+ * \param poll_ms Period of polling the device in ms, 0 to poll on every call of ds3231_temp_process().
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_temp_init(ds3231_temp_t *temp, embedd_device_t *dev, uint32_t poll_ms);
+
+/*!
+ * \brief Requests a conversion, it is carried out by ds3231_temp_process().
+ *
+ * \param temp Pointer to the temperature conversion.
+ * \param now_ms Current time in ms.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if a conversion is in progress.
+ *
+ */
+EMBEDD_RESULT ds3231_temp_start(ds3231_temp_t *temp, uint32_t now_ms);
+
+/*!
+ * \brief Runs the temperature conversion, to be called periodically from the main loop.
+ *
+ * Touches the bus at most once per poll period. A conversion not completed
+ * within DS3231_TEMP_TIMEOUT_MS is abandoned.
+ *
+ * \param temp Pointer to the temperature conversion.
+ * \param now_ms Current time in ms.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if the conversion failed.
+ *
+ */
+EMBEDD_RESULT ds3231_temp_process(ds3231_temp_t *temp, uint32_t now_ms);
+
+/*!
+ * \brief Returns whether a conversion is in progress.
+ *
+ * \param temp Pointer to the temperature conversion.
+ *
+ * \return true while a conversion is requested and not completed.
+ *
+ */
+static inline bool ds3231_temp_busy(const ds3231_temp_t *temp)
+{
+  return temp->state != DS3231_TEMP_STATE_IDLE;
+}
+
+/*!
+ * \brief Returns the last converted temperature.
+ *
+ * \param temp Pointer to the temperature conversion.
+ * \param quarters Pointer where the temperature in 0.25 °C will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if no temperature has been read yet.
+ *
+ */
+EMBEDD_RESULT ds3231_temp_get(const ds3231_temp_t *temp, int16_t *quarters);
+
+/*!
+ * \brief Converts the temperature registers to 0.25 °C.
+ *
+ * \param msb Temperature MSB register, the integer part in two's complement.
+ * \param lsb Temperature LSB register, the fraction in its upper 2 bits.
+ *
+ * \return Temperature in 0.25 °C.
+ *
+ */
+static inline int16_t ds3231_temp_from_regs(uint8_t msb, uint8_t lsb)
+{
+  return (int16_t)( (int8_t)msb * 4 + ( lsb >> 6 ) );
+}
+
+#endif//_SRC_DS3231_TEMP_H
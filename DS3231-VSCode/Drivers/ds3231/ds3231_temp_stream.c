@@ -0,0 +1,98 @@
+/*!
+ * \file ds3231_temp_stream.c
+ * \brief Ds3231 temperature stream
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+
+#include <string.h>
+
+#include "ds3231_temp_stream.h"
+
+/*!
+ * \brief Default smoothing filter, 2nd order Butterworth low-pass with the
+ * cut-off at 0.05 of the sample rate. The coefficients are halved to fit q15
+ * and restored by the post shift, their sums give a DC gain of exactly 1.
+ */
+static const q15_t ds3231_temp_stream_lowpass[6 * DS3231_TEMP_STREAM_STAGES] = {
+  329, 0, 658, 329, 25576, -10508,
+};
+
+#define DS3231_TEMP_STREAM_LOWPASS_SHIFT (1)
+
+EMBEDD_RESULT ds3231_temp_stream_init(ds3231_temp_stream_t *stream, const q15_t *coeffs, int8_t post_shift)
+{
+  if( stream == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( stream, 0, sizeof(ds3231_temp_stream_t) );
+  if( coeffs == NULL ) {
+    coeffs = ds3231_temp_stream_lowpass;
+    post_shift = DS3231_TEMP_STREAM_LOWPASS_SHIFT;
+  }
+  arm_biquad_cascade_df1_init_q15( &stream->filter, DS3231_TEMP_STREAM_STAGES, coeffs, stream->state, post_shift );
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_temp_stream_add(ds3231_temp_stream_t *stream, int16_t quarters)
+{
+  q15_t sample = ds3231_temp_stream_from_quarters( quarters );
+  if( stream == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( !stream->primed ) {
+    // start the filter settled at the first sample rather than ramping up from 0 °C
+    for( uint32_t i = 0; i < 4 * DS3231_TEMP_STREAM_STAGES; ++i ) {
+      stream->state[i] = sample;
+    }
+    stream->primed = 1;
+  }
+  stream->samples[stream->count] = sample;
+  if( ++ stream->count < DS3231_TEMP_STREAM_WINDOW ) {
+    return EMBEDD_RESULT_OK;
+  }
+  stream->count = 0;
+  arm_biquad_cascade_df1_q15( &stream->filter, stream->samples, stream->filtered, DS3231_TEMP_STREAM_WINDOW );
+  arm_mean_q15( stream->filtered, DS3231_TEMP_STREAM_WINDOW, &stream->stats.mean );
+  // 1 LSB of the variance of q15 temperatures is 0.5 °C², so the deviations from the mean are
+  // scaled up first, into the window just consumed by the filter
+  q15_t offset = ( stream->stats.mean == INT16_MIN ) ? INT16_MAX : -stream->stats.mean;
+  arm_offset_q15( stream->filtered, offset, stream->samples, DS3231_TEMP_STREAM_WINDOW );
+  arm_shift_q15( stream->samples, DS3231_TEMP_STREAM_VAR_SHIFT, stream->samples, DS3231_TEMP_STREAM_WINDOW );
+  arm_var_q15( stream->samples, DS3231_TEMP_STREAM_WINDOW, &stream->stats.var );
+  arm_max_q15( stream->filtered, DS3231_TEMP_STREAM_WINDOW, &stream->stats.max, &stream->stats.max_index );
+  ++ stream->stats.window;
+  return EMBEDD_RESULT_OK;
+}
+
+const ds3231_temp_stream_stats_t* ds3231_temp_stream_stats(const ds3231_temp_stream_t *stream)
+{
+  if( stream == NULL || stream->stats.window == 0 ) {
+    return NULL;
+  }
+  return &stream->stats;
+}
+
+const q15_t* ds3231_temp_stream_filtered(const ds3231_temp_stream_t *stream)
+{
+  if( stream == NULL || stream->stats.window == 0 ) {
+    return NULL;
+  }
+  return stream->filtered;
+}
@@ -0,0 +1,166 @@
+/*!
+ * \file ds3231_temp_stream.h
+ * \brief Ds3231 temperature stream
+ *
+ * Reduction of the temperature samples on the device. The samples are
+ * collected in windows of DS3231_TEMP_STREAM_WINDOW q15 values, every
+ * complete window is smoothed by a biquad low-pass filter and reduced to its
+ * mean, variance and maximum with CMSIS-DSP. The filtered window and its
+ * statistics are kept until the next window is complete, so they are read in
+ * place instead of being copied.
+ *
+ * A temperature in q15 is the temperature in °C divided by 128, a sample is
+ * the temperature in 0.25 °C shifted left by 6 bits, so the whole range of
+ * the device fits without saturation.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_TEMP_STREAM_H
+#define _SRC_DS3231_TEMP_STREAM_H
+
+#include <stdint.h>
+#include "arm_math.h"
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+
+/*!
+ * \def DS3231_TEMP_STREAM_STAGES
+ * \brief Count of the second order stages of the smoothing filter
+ */
+#define DS3231_TEMP_STREAM_STAGES (1U)
+
+/*!
+ * \struct ds3231_temp_stream_stats_t
+ * \brief Statistics of a window
+ *
+ * \var mean       mean of the filtered window in q15, 1.0 is 128 °C
+ * \var var        variance of the filtered window about its mean in q15, of the deviations scaled by
+ *                 2^DS3231_TEMP_STREAM_VAR_SHIFT, 1 LSB is 2^-(1 + 2 * DS3231_TEMP_STREAM_VAR_SHIFT) °C²,
+ *                 1/2048 °C² by default, see ds3231_temp_stream_var_to_mdeg2()
+ * \var max        maximum of the filtered window in q15
+ * \var max_index  index of the maximum in the filtered window
+ * \var window     count of windows completed including this one
+ */
+typedef struct {
+  q15_t mean;
+  q15_t var;
+  q15_t max;
+  uint32_t max_index;
+  uint32_t window;
+} ds3231_temp_stream_stats_t;
+
+/*!
+ * \struct ds3231_temp_stream_t
+ * \brief State of the temperature stream
+ *
+ * \var filter     instance of the smoothing filter
+ * \var state      state of the smoothing filter, carried over between windows
+ * \var samples    window being collected, holds the scaled deviations once the window is complete
+ * \var filtered   last complete window after smoothing
+ * \var count      count of samples in the window being collected
+ * \var primed     non-zero once the filter state is set from the first sample
+ * \var stats      statistics of the last complete window
+ */
+typedef struct {
+  arm_biquad_casd_df1_inst_q15 filter;
+  q15_t state[4 * DS3231_TEMP_STREAM_STAGES];
+  q15_t samples[DS3231_TEMP_STREAM_WINDOW];
+  q15_t filtered[DS3231_TEMP_STREAM_WINDOW];
+  uint32_t count;
+  uint8_t primed;
+  ds3231_temp_stream_stats_t stats;
+} ds3231_temp_stream_t;
+
+/*!
+ * \brief Converts a temperature in 0.25 °C to q15.
+ */
+static inline q15_t ds3231_temp_stream_from_quarters(int16_t quarters)
+{
+  return (q15_t)( quarters * 64 );
+}
+
+/*!
+ * \brief Converts a temperature in q15 to 0.25 °C, rounding to the nearest.
+ */
+static inline int16_t ds3231_temp_stream_to_quarters(q15_t value)
+{
+  return (int16_t)( ( value + 32 ) >> 6 );
+}
+
+/*!
+ * \brief Converts the variance of ds3231_temp_stream_stats_t to m°C², rounding down.
+ */
+static inline uint32_t ds3231_temp_stream_var_to_mdeg2(q15_t var)
+{
+  return ( (uint32_t)var * 1000U ) >> ( 1U + 2U * DS3231_TEMP_STREAM_VAR_SHIFT );
+}
+
+/*!
+ * \brief Initializes the temperature stream.
+ *
+ * \param stream Pointer to the temperature stream.
+ * \param coeffs Coefficients of the smoothing filter in the order of arm_biquad_cascade_df1_init_q15(),
+ *               6 for each of DS3231_TEMP_STREAM_STAGES, or NULL for the default low-pass
+ *               filter with the cut-off at 1/20 of the sample rate.
+ * \param post_shift Shift of the filter output matching the format of \a coeffs, ignored with the default filter.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_temp_stream_init(ds3231_temp_stream_t *stream, const q15_t *coeffs, int8_t post_shift);
+
+/*!
+ * \brief Adds a temperature sample to the stream.
+ *
+ * When the sample completes a window, the window is filtered and its
+ * statistics are computed before returning.
+ *
+ * \param stream Pointer to the temperature stream.
+ * \param quarters Temperature in 0.25 °C, see ds3231_temp_get().
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_temp_stream_add(ds3231_temp_stream_t *stream, int16_t quarters);
+
+/*!
+ * \brief Returns the statistics of the last complete window.
+ *
+ * The statistics stay unchanged until the next window is completed by ds3231_temp_stream_add().
+ *
+ * \param stream Pointer to the temperature stream.
+ *
+ * \return Pointer to the statistics, NULL if no window is complete yet.
+ *
+ */
+const ds3231_temp_stream_stats_t* ds3231_temp_stream_stats(const ds3231_temp_stream_t *stream);
+
+/*!
+ * \brief Returns the last complete window after smoothing.
+ *
+ * The window stays unchanged until the next window is completed by ds3231_temp_stream_add().
+ *
+ * \param stream Pointer to the temperature stream.
+ *
+ * \return Pointer to DS3231_TEMP_STREAM_WINDOW samples in q15, oldest first, NULL if no window is complete yet.
+ *
+ */
+const q15_t* ds3231_temp_stream_filtered(const ds3231_temp_stream_t *stream);
+
+#endif//_SRC_DS3231_TEMP_STREAM_H
@@ -0,0 +1,323 @@
+/*!
+ * \file ds3231_timer.c
+ * \brief Ds3231 software timers
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+
+#include <string.h>
+
+#include "embedd_event.h"
+
+#include "ds3231_timer.h"
+#include "ds3231_alarm.h"
+#include "ds3231_datetime.h"
+#include "ds3231_registers.h"
+#include "ds3231_fields.h"
+#include "ds3231_events.h"
+
+/*!
+ * \brief Swaps two entries of the heap and updates their indexes.
+ */
+static void ds3231_timer_heap_swap(ds3231_timer_service_t *svc, uint32_t a, uint32_t b)
+{
+  ds3231_timer_t *timer = svc->heap[a];
+  svc->heap[a] = svc->heap[b];
+  svc->heap[b] = timer;
+  svc->heap[a]->index = a;
+  svc->heap[b]->index = b;
+}
+
+/*!
+ * \brief Moves the entry towards the root while it is earlier than its parent.
+ */
+static void ds3231_timer_heap_up(ds3231_timer_service_t *svc, uint32_t index)
+{
+  while( index > 0 ) {
+    uint32_t parent = ( index - 1 ) >> 1;
+    if( svc->heap[parent]->deadline <= svc->heap[index]->deadline ) {
+      break;
+    }
+    ds3231_timer_heap_swap( svc, parent, index );
+    index = parent;
+  }
+}
+
+/*!
+ * \brief Moves the entry towards the leaves while it is later than one of its children.
+ */
+static void ds3231_timer_heap_down(ds3231_timer_service_t *svc, uint32_t index)
+{
+  for( ;; ) {
+    uint32_t child = ( index << 1 ) + 1;
+    if( child >= svc->count ) {
+      break;
+    }
+    if( ( child + 1 < svc->count ) && ( svc->heap[child + 1]->deadline < svc->heap[child]->deadline ) ) {
+      ++ child;
+    }
+    if( svc->heap[index]->deadline <= svc->heap[child]->deadline ) {
+      break;
+    }
+    ds3231_timer_heap_swap( svc, index, child );
+    index = child;
+  }
+}
+
+/*!
+ * \brief Puts the timer into the heap, there must be room for it.
+ */
+static void ds3231_timer_heap_insert(ds3231_timer_service_t *svc, ds3231_timer_t *timer)
+{
+  timer->index = svc->count;
+  svc->heap[svc->count ++] = timer;
+  ds3231_timer_heap_up( svc, timer->index );
+}
+
+/*!
+ * \brief Takes the timer out of the heap.
+ */
+static void ds3231_timer_heap_remove(ds3231_timer_service_t *svc, ds3231_timer_t *timer)
+{
+  uint32_t index = timer->index;
+  timer->index = DS3231_TIMER_INDEX_NONE;
+  if( index != -- svc->count ) {
+    svc->heap[index] = svc->heap[svc->count];
+    svc->heap[index]->index = index;
+    ds3231_timer_heap_down( svc, index );
+    ds3231_timer_heap_up( svc, index );
+  }
+}
+
+/*!
+ * \brief Reads the time of the device as Unix time.
+ */
+static EMBEDD_RESULT ds3231_timer_now(ds3231_timer_service_t *svc, int64_t *now)
+{
+  ds3231_datetime_t datetime;
+  if( ds3231_get_datetime( svc->dev, &datetime ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  return ds3231_datetime_to_epoch( &datetime, now );
+}
+
+/*!
+ * \brief Compiles the deadline to the image of Alarm 1, matching date, hours, minutes and seconds.
+ */
+static EMBEDD_RESULT ds3231_timer_alarm_image(int64_t deadline, ds3231_alarm_image_t *image)
+{
+  ds3231_datetime_t datetime;
+  if( ds3231_epoch_to_datetime( deadline, &datetime ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  ds3231_alarm_spec_t spec = {
+    .mode = DS3231_ALARM_MODE_DATE,
+    .day_date = datetime.date,
+    .hour = datetime.hour,
+    .minutes = datetime.minutes,
+    .seconds = datetime.seconds,
+  };
+  return ds3231_alarm_compile( DS3231_ALARM_1, &spec, image );
+}
+
+/*!
+ * \brief Notes a failed transfer of the service, the next process retries it.
+ */
+static EMBEDD_RESULT ds3231_timer_retry(ds3231_timer_service_t *svc)
+{
+  ++ svc->stats.errors;
+  svc->pending = 1;
+  return EMBEDD_RESULT_ERR;
+}
+
+/*!
+ * \brief Programs the earliest deadline to Alarm 1 if it has changed.
+ *
+ * Only the registers differing from the cached ones are written. A deadline
+ * already passed when the alarm is programmed would match only a month later,
+ * so it is marked overdue and fired by the next process. On failure the
+ * alarm is left not armed and the next process programs it again.
+ */
+static EMBEDD_RESULT ds3231_timer_rearm(ds3231_timer_service_t *svc)
+{
+  ds3231_alarm_image_t image;
+  ds3231_alarm_image_t current;
+  uint32_t first = 0;
+  uint32_t last;
+  int64_t now;
+  if( svc->processing || svc->count == 0 ) {
+    return EMBEDD_RESULT_OK;
+  }
+  int64_t deadline = svc->heap[0]->deadline;
+  if( svc->is_armed && ( svc->armed == deadline ) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  svc->is_armed = 0;
+  if( ds3231_timer_alarm_image( deadline, &image ) != EMBEDD_RESULT_OK ) {
+    ++ svc->stats.errors;
+    return EMBEDD_RESULT_ERR;
+  }
+  // served from the register cache once the alarm has been read or written
+  if( ds3231_alarm_read( svc->dev, DS3231_ALARM_1, &current ) != EMBEDD_RESULT_OK ) {
+    return ds3231_timer_retry( svc );
+  }
+  last = image.size;
+  for( ; ( first < last ) && ( image.regs[first] == current.regs[first] ); ++first );
+  for( ; ( last > first ) && ( image.regs[last - 1] == current.regs[last - 1] ); --last );
+  if( first < last ) {
+    if( ds3231_write_regs( svc->dev, ds3231_alarm_1_seconds_write_reg_addr + first, last - first, &image.regs[first] ) != EMBEDD_RESULT_OK ) {
+      return ds3231_timer_retry( svc );
+    }
+    svc->stats.regs_written += last - first;
+  }
+  svc->armed = deadline;
+  svc->is_armed = 1;
+  ++ svc->stats.rearms;
+  if( ds3231_timer_now( svc, &now ) != EMBEDD_RESULT_OK ) {
+    // the deadline may have passed, the next process checks it against the time
+    svc->overdue = 1;
+    return ds3231_timer_retry( svc );
+  }
+  if( deadline <= now ) {
+    svc->overdue = 1;
+    svc->pending = 1;
+  }
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_timer_init(ds3231_timer_t *timer, ds3231_timer_cb_t cb, void *arg)
+{
+  if( timer == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( timer, 0, sizeof(ds3231_timer_t) );
+  timer->cb = cb;
+  timer->arg = arg;
+  timer->index = DS3231_TIMER_INDEX_NONE;
+  return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT ds3231_timer_service_init(ds3231_timer_service_t *svc, embedd_device_t *dev)
+{
+  if( svc == NULL || dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  memset( svc, 0, sizeof(ds3231_timer_service_t) );
+  svc->dev = dev;
+  // the flag is set on a match either way, the interrupt reaches the pin only while INTCN is set
+  return ds3231_update_bits( dev, ds3231_control_write_reg_addr, DS3231_FIELD_MASK(ds3231_control, a1ie),
+                             DS3231_FIELD_MASK(ds3231_control, a1ie) );
+}
+
+EMBEDD_RESULT ds3231_timer_start(ds3231_timer_service_t *svc, ds3231_timer_t *timer, int64_t deadline, uint32_t period_s)
+{
+  if( svc == NULL || svc->dev == NULL || timer == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( ds3231_timer_active( timer ) ) {
+    ds3231_timer_heap_remove( svc, timer );
+  } else if( svc->count == DS3231_TIMER_COUNT ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  timer->deadline = deadline;
+  timer->period_s = period_s;
+  ds3231_timer_heap_insert( svc, timer );
+  return ds3231_timer_rearm( svc );
+}
+
+EMBEDD_RESULT ds3231_timer_stop(ds3231_timer_service_t *svc, ds3231_timer_t *timer)
+{
+  if( svc == NULL || timer == NULL || !ds3231_timer_active( timer ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  ds3231_timer_heap_remove( svc, timer );
+  return ds3231_timer_rearm( svc );
+}
+
+EMBEDD_RESULT ds3231_timer_process(ds3231_timer_service_t *svc)
+{
+  uint8_t status;
+  int64_t now;
+  if( svc == NULL || svc->dev == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( !svc->pending ) {
+    return EMBEDD_RESULT_OK;
+  }
+  // the status read would fail while a transfer is in flight, the signal is kept for the next call
+  if( ds3231_async_busy( svc->dev ) ) {
+    return EMBEDD_RESULT_OK;
+  }
+  // cleared before the status is read, so a signal meanwhile is not lost
+  svc->pending = 0;
+  if( ds3231_read_reg( svc->dev, ds3231_status_read_reg_addr, &status, sizeof(status), ds3231_status_delay ) != EMBEDD_RESULT_OK ) {
+    return ds3231_timer_retry( svc );
+  }
+  if( status & DS3231_FIELD_MASK(ds3231_status, a1f) ) {
+    // A2F written with 1 is left as it is, so a match of Alarm 2 meanwhile is not lost
+    status = ( status & (uint8_t)~DS3231_FIELD_MASK(ds3231_status, a1f) ) | DS3231_FIELD_MASK(ds3231_status, a2f);
+    if( ds3231_write_reg( svc->dev, ds3231_status_write_reg_addr, &status, sizeof(status), ds3231_status_delay ) != EMBEDD_RESULT_OK ) {
+      return ds3231_timer_retry( svc );
+    }
+    ++ svc->stats.matches;
+    embedd_event_manager_trigger( DS3231_ALARM_1_MATCH_EVENT_ID, svc->dev );
+  } else if( !svc->overdue ) {
+    // the alarm is programmed again after a failed rearm
+    if( !svc->is_armed && ( svc->count > 0 ) ) {
+      return ds3231_timer_rearm( svc );
+    }
+    return EMBEDD_RESULT_OK;
+  }
+  svc->is_armed = 0;
+  if( svc->count == 0 ) {
+    svc->overdue = 0;
+    return EMBEDD_RESULT_OK;
+  }
+  if( ds3231_timer_now( svc, &now ) != EMBEDD_RESULT_OK ) {
+    // the flag is cleared already, the expired timers are fired by the next call
+    svc->overdue = 1;
+    return ds3231_timer_retry( svc );
+  }
+  svc->overdue = 0;
+  svc->processing = 1;
+  while( ( svc->count > 0 ) && ( svc->heap[0]->deadline <= now ) ) {
+    ds3231_timer_t *timer = svc->heap[0];
+    ds3231_timer_heap_remove( svc, timer );
+    if( timer->period_s ) {
+      // periods missed while the alarm was not served are skipped
+      timer->deadline += ( ( now - timer->deadline ) / timer->period_s + 1 ) * timer->period_s;
+      ds3231_timer_heap_insert( svc, timer );
+    }
+    ++ svc->stats.fired;
+    if( timer->cb ) {
+      timer->cb( timer );
+    }
+  }
+  svc->processing = 0;
+  return ds3231_timer_rearm( svc );
+}
+
+EMBEDD_RESULT ds3231_timer_get_stats(const ds3231_timer_service_t *svc, ds3231_timer_stats_t *stats)
+{
+  if( svc == NULL || stats == NULL ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  *stats = svc->stats;
+  return EMBEDD_RESULT_OK;
+}
@@ -0,0 +1,218 @@
+/*!
+ * \file ds3231_timer.h
+ * \brief Ds3231 software timers
+ *
+ * Any number of software timers multiplexed over Alarm 1. Started timers are
+ * kept in a binary min-heap ordered by their deadline, and Alarm 1 is
+ * reprogrammed only when the earliest deadline changes, writing just the
+ * alarm registers that differ in one burst. On an alarm match all the expired
+ * timers are fired, so the MCU is woken only when a timer is due.
+ *
+ * Deadlines are in Unix time, see ds3231_datetime_to_epoch(). Alarm 1 matches
+ * the date, hours, minutes and seconds, so a deadline may be at most a month
+ * ahead of the device time; a deadline further ahead is reached by a
+ * spurious match rearming the alarm.
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _SRC_DS3231_TIMER_H
+#define _SRC_DS3231_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "embedd_driver.h"
+#include "ds3231_data_types.h"
+
+/*!
+ * \def DS3231_TIMER_INDEX_NONE
+ * \brief Heap index of a timer that is not started
+ */
+#define DS3231_TIMER_INDEX_NONE (0xFFFFFFFFU)
+
+struct ds3231_timer;
+
+/*!
+ * \brief Callback of an expired timer, called from ds3231_timer_process().
+ *
+ * The callback may start and stop timers, including the expired one.
+ */
+typedef void (*ds3231_timer_cb_t)(struct ds3231_timer *timer);
+
+/*!
+ * \struct ds3231_timer_t
+ * \brief Software timer, owned by the caller and linked into the service while started
+ *
+ * \var deadline   Unix time the timer expires at
+ * \var period_s   period in s of a periodic timer, 0 for a one-shot timer
+ * \var cb         callback of the expired timer
+ * \var arg        argument of the callback
+ * \var index      position in the heap, DS3231_TIMER_INDEX_NONE while stopped
+ */
+typedef struct ds3231_timer {
+  int64_t deadline;
+  uint32_t period_s;
+  ds3231_timer_cb_t cb;
+  void *arg;
+  uint32_t index;
+} ds3231_timer_t;
+
+/*!
+ * \struct ds3231_timer_stats_t
+ * \brief Counters of the timer service
+ *
+ * \var matches      alarm matches handled
+ * \var fired        timers fired
+ * \var rearms       times the earliest deadline was programmed to Alarm 1
+ * \var regs_written alarm registers written, at most 4 per rearm
+ * \var errors       failed bus transfers
+ */
+typedef struct {
+  uint32_t matches;
+  uint32_t fired;
+  uint32_t rearms;
+  uint32_t regs_written;
+  uint32_t errors;
+} ds3231_timer_stats_t;
+
+/*!
+ * \struct ds3231_timer_service_t
+ * \brief State of the timer service
+ *
+ * \var dev        device whose Alarm 1 is used
+ * \var heap       started timers, a min-heap by deadline
+ * \var count      count of started timers
+ * \var armed      deadline programmed to Alarm 1, valid while \a is_armed is set
+ * \var is_armed   non-zero while Alarm 1 holds the earliest deadline
+ * \var pending    set by ds3231_timer_signal() and by a failed transfer, the alarm flag is checked and
+ *                 a failed rearm is retried on the next process
+ * \var overdue    non-zero if the earliest deadline had passed when it was programmed
+ * \var processing non-zero while expired timers are fired, rearming is deferred until they are done
+ * \var stats      counters of the service
+ */
+typedef struct {
+  embedd_device_t *dev;
+  ds3231_timer_t *heap[DS3231_TIMER_COUNT];
+  uint32_t count;
+  int64_t armed;
+  uint8_t is_armed;
+  volatile uint8_t pending;
+  uint8_t overdue;
+  uint8_t processing;
+  ds3231_timer_stats_t stats;
+} ds3231_timer_service_t;
+
+/*!
+ * \brief Initializes a timer.
+ *
+ * \param timer Pointer to the timer.
+ * \param cb Callback of the expired timer.
+ * \param arg Argument of the callback, see ds3231_timer_t.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_timer_init(ds3231_timer_t *timer, ds3231_timer_cb_t cb, void *arg);
+
+/*!
+ * \brief Initializes the timer service and enables the interrupt of Alarm 1.
+ *
+ * \param svc Pointer to the timer service.
+ * \param dev Pointer to the device.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_timer_service_init(ds3231_timer_service_t *svc, embedd_device_t *dev);
+
+/*!
+ * \brief Starts a timer, a started timer is restarted with the new deadline.
+ *
+ * \param svc Pointer to the timer service.
+ * \param timer Pointer to the timer.
+ * \param deadline Unix time the timer expires at.
+ * \param period_s Period in s of a periodic timer, 0 for a one-shot timer.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if the
+ *         service is full or Alarm 1 could not be programmed, the timer is then
+ *         started and ds3231_timer_process() programs the alarm.
+ *
+ */
+EMBEDD_RESULT ds3231_timer_start(ds3231_timer_service_t *svc, ds3231_timer_t *timer, int64_t deadline, uint32_t period_s);
+
+/*!
+ * \brief Stops a timer.
+ *
+ * \param svc Pointer to the timer service.
+ * \param timer Pointer to the timer.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code if the timer is not started.
+ *
+ */
+EMBEDD_RESULT ds3231_timer_stop(ds3231_timer_service_t *svc, ds3231_timer_t *timer);
+
+/*!
+ * \brief Returns whether a timer is started.
+ */
+static inline bool ds3231_timer_active(const ds3231_timer_t *timer)
+{
+  return timer->index != DS3231_TIMER_INDEX_NONE;
+}
+
+/*!
+ * \brief Notes a possible alarm match, can be called from an interrupt.
+ *
+ * To be called from the interrupt of the INT/SQW pin when INTCN is set, or
+ * once per second otherwise, e.g. from the square-wave edge capture.
+ *
+ * \param svc Pointer to the timer service.
+ *
+ */
+static inline void ds3231_timer_signal(ds3231_timer_service_t *svc)
+{
+  svc->pending = 1;
+}
+
+/*!
+ * \brief Runs the timer service, to be called periodically from the main loop.
+ *
+ * Touches the bus only after ds3231_timer_signal() or a failed transfer, and
+ * not while an asynchronous transfer of the device is in flight, the signal
+ * is then kept for the next call. When Alarm 1 has matched, clears its flag,
+ * triggers DS3231_ALARM_1_MATCH_EVENT_ID, fires all the expired timers and
+ * programs the next deadline. A failed transfer is retried by the next call.
+ *
+ * \param svc Pointer to the timer service.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_timer_process(ds3231_timer_service_t *svc);
+
+/*!
+ * \brief Returns the counters of the timer service.
+ *
+ * \param svc Pointer to the timer service.
+ * \param stats Pointer where the counters will be stored.
+ *
+ * \return EMBEDD_RESULT_OK on success, or an EMBEDD_RESULT_ERR error code.
+ *
+ */
+EMBEDD_RESULT ds3231_timer_get_stats(const ds3231_timer_service_t *svc, ds3231_timer_stats_t *stats);
+
+#endif//_SRC_DS3231_TIMER_H
@@ -35,4 +35,8 @@ __attribute__((weak)) EMBEDD_RESULT embedd_event_manager_process_events_enable()
 __attribute__((weak)) EMBEDD_RESULT embedd_event_manager_process_events_disable() { return EMBEDD_RESULT_OK; }
 
 __attribute__((weak)) EMBEDD_RESULT embedd_event_manager_process() { return EMBEDD_RESULT_OK; }
+__attribute__((weak)) uint32_t embedd_event_manager_process_budget(uint32_t max_events, uint32_t max_ticks) { return 0; }
 __attribute__((weak)) EMBEDD_RESULT embedd_event_manager_trigger(int event_id, void *device) { return EMBEDD_RESULT_OK; }
+__attribute__((weak)) EMBEDD_RESULT embedd_event_manager_set_overflow_policy(embedd_event_overflow_t policy) { return EMBEDD_RESULT_OK; }
+__attribute__((weak)) EMBEDD_RESULT embedd_event_manager_get_stats(embedd_event_stats_t *stats) { return EMBEDD_RESULT_ERR; }
+__attribute__((weak)) EMBEDD_RESULT embedd_event_manager_set_coalescing(int id, int enable) { return EMBEDD_RESULT_OK; }
@@ -83,16 +83,78 @@ EMBEDD_RESULT embedd_event_manager_process_events_disable();
 /*!
  *  \fn     embedd_event_manager_process
  *  \brief  process events in queue by event manager
+ *
+ *  The queue has a single consumer, events are processed from one context only.
  */
 EMBEDD_RESULT embedd_event_manager_process();
 
+/*!
+ *  \fn     embedd_event_manager_process_budget
+ *  \brief  process events in queue until a count or a time budget is spent
+ *
+ *  At least one pending event is processed per call, the time budget is
+ *  checked after each event against embedd_hal_get_ticks(), so a callback
+ *  running longer than the budget is never interrupted. Same single consumer
+ *  rule as embedd_event_manager_process().
+ *
+ *  \param  max_events  maximum count of events to process, 0 - no limit
+ *  \param  max_ticks   maximum ticks to spend, 0 - no limit
+ *
+ *  \return count of events still pending in queue
+ */
+uint32_t embedd_event_manager_process_budget(uint32_t max_events, uint32_t max_ticks);
+
 /*!
  *  \fn     embedd_event_manager_trigger
  *  \brief  add event to queue by event manager
  *
+ *  The queue has a single producer, events are triggered from one context
+ *  only, which may be an interrupt handler, without any critical section.
+ *  Triggers from contexts preempting each other must be serialized by the
+ *  caller. An event triggered while the queue is full is handled by the
+ *  overflow policy, see embedd_event_manager_set_overflow_policy().
+ *
  *  \param  id    ID of event
  *  \param  data  data poiner, pointer to @embedd_device_t or pointer to @fsm_t
  */
 EMBEDD_RESULT embedd_event_manager_trigger(int event_id, void *data);
 
+/*!
+ *  \fn     embedd_event_manager_set_overflow_policy
+ *  \brief  set handling of events triggered while the queue is full
+ *
+ *  With EMBEDD_EVENT_OVERFLOW_DROP_OLDEST the producer moves the tail and
+ *  with EMBEDD_EVENT_OVERFLOW_COALESCE it updates queued items, so then
+ *  both trigger and process run their queue update between engage_guard()
+ *  and disengage_guard(), which must mask the producer context. Set from
+ *  the context processing events.
+ *
+ *  \param  policy  overflow policy
+ */
+EMBEDD_RESULT embedd_event_manager_set_overflow_policy(embedd_event_overflow_t policy);
+
+/*!
+ *  \fn     embedd_event_manager_get_stats
+ *  \brief  read queue health counters
+ *
+ *  \param  stats   pointer where the counters will be stored
+ */
+EMBEDD_RESULT embedd_event_manager_get_stats(embedd_event_stats_t *stats);
+
+/*!
+ *  \fn     embedd_event_manager_set_coalescing
+ *  \brief  enable or disable coalescing of events with @id
+ *
+ *  While an event with the same id and device is queued and not yet
+ *  processed, a new trigger increments its count instead of taking
+ *  another item, callbacks see the count in @EventSource. Queue updates
+ *  are guarded as with EMBEDD_EVENT_OVERFLOW_COALESCE while any id
+ *  coalesces. The option is cleared when the last callback for @id is
+ *  unregistered. Set from the context processing events.
+ *
+ *  \param  id      ID of event with registered callbacks
+ *  \param  enable  1 - coalesce events, 0 - queue each event
+ */
+EMBEDD_RESULT embedd_event_manager_set_coalescing(int id, int enable);
+
 #endif //_SRC_EMBEDD_EVENT_H
@@ -35,10 +35,12 @@
  *
  *  \param  device  pointer to event data
  *  \param  id      event id
+ *  \param  count   count of triggers merged in this event, 1 unless coalesced
  */
 struct EventSource {
     embedd_device_t *device;
     int event_id;
+    uint32_t count;
 };
 
 /*!
@@ -47,6 +49,41 @@ struct EventSource {
  */
 typedef void (*embedd_callback_t)(struct EventSource*);
 
+/*!
+ *  \enum     embedd_event_overflow_t
+ *  \brief    handling of an event triggered while the queue is full
+ *
+ *  \param    EMBEDD_EVENT_OVERFLOW_REJECT       new event is dropped, trigger returns an error
+ *  \param    EMBEDD_EVENT_OVERFLOW_DROP_NEWEST  new event is dropped, trigger succeeds
+ *  \param    EMBEDD_EVENT_OVERFLOW_DROP_OLDEST  oldest queued event is dropped to make room for the new one
+ *  \param    EMBEDD_EVENT_OVERFLOW_COALESCE     new event is merged into a queued one with the same id and device,
+ *                                               whose count is incremented, rejected if there is none
+ */
+typedef enum {
+    EMBEDD_EVENT_OVERFLOW_REJECT        =0,
+    EMBEDD_EVENT_OVERFLOW_DROP_NEWEST,
+    EMBEDD_EVENT_OVERFLOW_DROP_OLDEST,
+    EMBEDD_EVENT_OVERFLOW_COALESCE,
+}   embedd_event_overflow_t;
+
+/*!
+ *  \struct   embedd_event_stats_t
+ *  \brief    queue health counters, all of them since init
+ *
+ *  \param    enqueued    count of events put in queue
+ *  \param    dispatched  count of events taken from queue by process
+ *  \param    dropped     count of events lost on overflow, new or oldest ones
+ *  \param    coalesced   count of events merged into a queued one
+ *  \param    high_water  maximum count of items in queue
+ */
+typedef struct {
+    uint32_t enqueued;
+    uint32_t dispatched;
+    uint32_t dropped;
+    uint32_t coalesced;
+    uint32_t high_water;
+}   embedd_event_stats_t;
+
 #define     VOID_EVENT_ID   (0)
 
 #endif //_SRC_EMBEDD_EVENT_TYPES_H
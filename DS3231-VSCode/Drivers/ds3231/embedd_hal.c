@@ -27,3 +27,4 @@
 #include "embedd_hal.h"
 
 __attribute__((weak)) void embedd_hal_sleep(uint32_t mseconds) {}
+__attribute__((weak)) uint32_t embedd_hal_get_ticks(void) { return 0; }
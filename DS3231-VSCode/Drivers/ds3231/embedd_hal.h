@@ -56,6 +56,27 @@ typedef struct {
     void *configs;
 } embedd_bus_dev_cfg_t;
 
+/*!
+ *  \struct     embedd_bus_iovec_t
+ *  \brief      one segment of a vectored bus transfer
+ *
+ *  \param      data_ptr   pointer to the segment data
+ *  \param      data_size  size of the segment in bytes
+ */
+typedef struct {
+    void *data_ptr;
+    uint32_t data_size;
+} embedd_bus_iovec_t;
+
+/*!
+ *  \typedef    embedd_bus_done_t
+ *  \brief      completion callback of an asynchronous bus transfer, may be called from an interrupt
+ *
+ *  \param      dev     pointer to the device the transfer was started for
+ *  \param      result  result of the transfer
+ */
+typedef void (*embedd_bus_done_t)(const struct embedd_device_t *dev, EMBEDD_RESULT result);
+
 /*!
  *  \struct     embedd_bus_t
  *  \brief      bus structure
@@ -64,12 +85,22 @@ typedef struct {
  *  \param      instance  pointer to the bus object which is specific for user library
  *  \param      write     pointer to bus write function
  *  \param      read      pointer to bus read function
+ *  \param      writev    optional, pointer to bus function writing all segments in one transfer, NULL if not supported
+ *  \param      write_read optional, pointer to bus function writing and then reading in one transfer
+ *                         with a repeated start in between, NULL if not supported
+ *  \param      write_async      optional, pointer to bus function starting a write and returning immediately,
+ *                               \a done is called when it is completed, NULL if not supported
+ *  \param      write_read_async optional, asynchronous variant of \a write_read, NULL if not supported
  */
 typedef struct embedd_bus_t {
     const char *name;
     void *instance;
     EMBEDD_RESULT (*write)(const struct embedd_device_t *dev, const uint8_t *data_ptr, uint32_t data_size);
     EMBEDD_RESULT (*read)(const struct embedd_device_t *dev, uint8_t *data_ptr, uint32_t data_size);
+    EMBEDD_RESULT (*writev)(const struct embedd_device_t *dev, const embedd_bus_iovec_t *iov, uint32_t iov_count);
+    EMBEDD_RESULT (*write_read)(const struct embedd_device_t *dev, const uint8_t *wr_ptr, uint32_t wr_size, uint8_t *rd_ptr, uint32_t rd_size);
+    EMBEDD_RESULT (*write_async)(const struct embedd_device_t *dev, const uint8_t *data_ptr, uint32_t data_size, embedd_bus_done_t done);
+    EMBEDD_RESULT (*write_read_async)(const struct embedd_device_t *dev, const uint8_t *wr_ptr, uint32_t wr_size, uint8_t *rd_ptr, uint32_t rd_size, embedd_bus_done_t done);
 } embedd_bus_t;
 
 /*!
@@ -80,4 +111,15 @@ typedef struct embedd_bus_t {
  */
 void embedd_hal_sleep(uint32_t mseconds);
 
+/*!
+ *  \fn       embedd_hal_get_ticks
+ *  \brief    read free running tick counter, wraps around at 2^32
+ *
+ *  The default implementation returns 0, a platform without a tick source
+ *  still links and time budgets based on it never expire.
+ *
+ *  \return   current tick count
+ */
+uint32_t embedd_hal_get_ticks(void);
+
 #endif  //_SRC_EMBEDD_HAL_H
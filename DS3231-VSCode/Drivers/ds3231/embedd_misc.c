@@ -40,12 +40,6 @@ size_t embedd_pack(void* dst, void* src, size_t Size) {
         return 0;
     }
 
-    const uint8_t *srcPtr = (const uint8_t *)src + Size - 1;
-    uint8_t *dstPtr = (uint8_t *)dst;
-
-    for (size_t i = 0; i < Size; ++i) {
-        *dstPtr++ = *srcPtr--;
-    }
-
+    embedd_pack_n(dst, src, Size);
     return Size;
 }
@@ -65,6 +65,100 @@ size_t  embedd_copy(void* dst, void* src, size_t Size);
  */
 size_t  embedd_pack(void* dst, void* src, size_t Size);
 
+/*!
+ * \brief Copy a single byte, the one byte variant of embedd_pack().
+ *
+ * \param dst Pointer to the destination buffer.
+ * \param src Pointer to the source buffer.
+ */
+static inline void embedd_pack_1(void* dst, const void* src) {
+    *(uint8_t *)dst = *(const uint8_t *)src;
+}
+
+/*!
+ * \brief Copy two bytes in reverse order, the two bytes variant of embedd_pack().
+ *
+ * \param dst Pointer to the destination buffer.
+ * \param src Pointer to the source buffer.
+ */
+static inline void embedd_pack_2(void* dst, const void* src) {
+    const uint8_t *srcPtr = (const uint8_t *)src;
+    uint8_t *dstPtr = (uint8_t *)dst;
+    uint8_t b0 = srcPtr[0];
+    uint8_t b1 = srcPtr[1];
+    dstPtr[0] = b1;
+    dstPtr[1] = b0;
+}
+
+/*!
+ * \brief Copy four bytes in reverse order, the four bytes variant of embedd_pack().
+ *
+ * Buffers may be unaligned, the word is moved with memcpy() and reversed by
+ * a single byte swap (REV instruction on Cortex-M).
+ *
+ * \param dst Pointer to the destination buffer.
+ * \param src Pointer to the source buffer.
+ */
+static inline void embedd_pack_4(void* dst, const void* src) {
+    uint32_t word;
+    memcpy( &word, src, sizeof(word) );
+    word = __builtin_bswap32( word );
+    memcpy( dst, &word, sizeof(word) );
+}
+
+/*!
+ * \brief Copy data of any size in reverse order, the generic variant of embedd_pack().
+ *
+ * Unlike embedd_pack() it does not check its arguments.
+ *
+ * \param dst Pointer to the destination buffer.
+ * \param src Pointer to the source buffer, must not overlap \a dst.
+ * \param Size The size of the data to be packed (in bytes).
+ */
+static inline void embedd_pack_n(void* dst, const void* src, size_t Size) {
+    const uint8_t *srcPtr = (const uint8_t *)src + Size;
+    uint8_t *dstPtr = (uint8_t *)dst;
+    while (Size--) {
+        *dstPtr++ = *--srcPtr;
+    }
+}
+
+/*!
+ * \brief Copy data in reverse order using the variant specialized for \a Size.
+ *
+ * When \a Size is a compile-time constant the selection is resolved by the
+ * compiler and only the specialized copy is emitted.
+ *
+ * \param dst Pointer to the destination buffer.
+ * \param src Pointer to the source buffer, must not overlap \a dst.
+ * \param Size The size of the data to be packed (in bytes).
+ *
+ * \return The size of the data that was packed.
+ */
+static inline size_t embedd_pack_sized(void* dst, const void* src, size_t Size) {
+    switch (Size) {
+        case 1:  embedd_pack_1(dst, src);       break;
+        case 2:  embedd_pack_2(dst, src);       break;
+        case 4:  embedd_pack_4(dst, src);       break;
+        default: embedd_pack_n(dst, src, Size); break;
+    }
+    return Size;
+}
+
+/*!
+ * \brief Restore data packed by embedd_pack_sized(). Reversing the byte order
+ * is its own inverse, so this is the same operation named for the read side.
+ *
+ * \param dst Pointer to the destination buffer.
+ * \param src Pointer to the source buffer, must not overlap \a dst.
+ * \param Size The size of the data to be unpacked (in bytes).
+ *
+ * \return The size of the data that was unpacked.
+ */
+static inline size_t embedd_unpack_sized(void* dst, const void* src, size_t Size) {
+    return embedd_pack_sized(dst, src, Size);
+}
+
 /*!
  *  \struct table_t
  *  \brief  struct for common type of table data
@@ -29,6 +29,7 @@
 
 #include    "event_manager_cfg.h"
 #include    "embedd_event_types.h"
+#include    "embedd_event.h"
 
 // ------------------------------------------------------------------------- //
 // event manager data
@@ -50,29 +51,80 @@ typedef struct {
  *  \brief    structure for id, includes id and table of potential callbacks
  *
  *  \param    id                id of event
+ *  \param    deleted           true if the id was removed, the probe for other ids goes on past it
+ *  \param    coalesce          true if a trigger is merged into a queued event with the same device
  *  \param    cb_item_t table   table for single id
  */
 typedef struct {
     int id;
+    int deleted;
+    int coalesce;
     cb_item_t table[EMBEDD_EVENT_MGR_MAX_CB_FOR_ID_COUNT];
 }   id_item_t;
 
+// Ids are kept in an open addressing hash table with linear probing, so an id
+// is found in constant time whatever the count of active ids. The table is
+// at most half full, removed ids are marked deleted instead of moving the
+// others, so the index of an id stays valid for the events queued with it.
+#define     ID_TABLE_SIZE       (1U << EMBEDD_EVENT_MGR_ID_HASH_BITS)
+#define     ID_HASH_MULTIPLIER  (2654435769U)       // 2^32 divided by the golden ratio
+
+#if ID_TABLE_SIZE < 2U * EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT
+#error "EMBEDD_EVENT_MGR_ID_HASH_BITS is too small for EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT"
+#endif
+
 /*!
  *  \brief    table of processed is with its own tables
  */
-static id_item_t event_manager_data[EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT];  // <! table for all active ids
+static id_item_t event_manager_data[ID_TABLE_SIZE];                         // <! table for all active ids
+static size_t    active_id_count          =0;                               // count of ids in table
+static size_t    coalescing_id_count      =0;                               // count of ids with coalesce option
 // ------------------------------------------------------------------------- //
 // event queue data
-static struct   EventSource queue[EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT];  // queue cycle buffer
-static struct   EventSource *queue_wr_ptr =(struct EventSource *)NULL;      // buffer write pointer
-static struct   EventSource *queue_rd_ptr =(struct EventSource *)NULL;      // buffer read pointer
-static size_t   queue_data_size           =0;                               // queue data current size
+//
+// Single-producer/single-consumer ring. The head is written only by the
+// producer (trigger) and the tail only by the consumer (process), each side
+// publishes its index with a single aligned word store after a barrier, so no
+// read-modify-write is shared and neither side masks interrupts. Indices run
+// over twice the queue size to tell a full queue from an empty one without
+// a spare item and without division. The drop oldest overflow policy is the
+// exception, the producer then moves the tail too, so both sides update the
+// queue between engage_guard() and disengage_guard(). So do they for the
+// coalesce policy and for ids with the coalesce option, where the producer
+// increments the count of a queued item the consumer may be taking.
+#define     QUEUE_INDEX_WRAP    (2U * EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT)
+
+/*!
+ *  \struct   queue_item_t
+ *  \brief    queued event with the index of its id resolved by trigger
+ *
+ *  \param    ev          event
+ *  \param    id_index    index of the id in event_manager_data
+ */
+typedef struct {
+    struct   EventSource ev;
+    uint32_t id_index;
+}   queue_item_t;
+
+static queue_item_t queue[EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT];         // queue cycle buffer
+static uint32_t queue_head                =0;                               // next item to write, producer side
+static uint32_t queue_tail                =0;                               // next item to read, consumer side
 static int      process_enable            =false;                           // process enable flag, true - processing enabled, false - disabled
+static embedd_event_overflow_t overflow_policy = EMBEDD_EVENT_MGR_OVERFLOW_POLICY; // handling of events triggered while queue is full
+static embedd_event_stats_t stats;                                          // queue health counters, each written by one side only
 
-static void queue_rd_inc();
-static void queue_wr_inc();
+static uint32_t queue_index_inc(uint32_t index);
+static uint32_t queue_size(uint32_t head, uint32_t tail);
+static queue_item_t* queue_item(uint32_t index);
+static EMBEDD_RESULT enqueue(id_item_t* pId, embedd_device_t *device, embedd_event_overflow_t policy);
+static bool dequeue(queue_item_t *item);
+static queue_item_t* find_queued(int event_id, embedd_device_t *device, uint32_t head, uint32_t tail);
+static void dispatch(queue_item_t *item);
+static bool policy_guarded(embedd_event_overflow_t policy);
 
 static id_item_t* get_id_ptr(int event_id);
+static id_item_t* add_id(int event_id);
+static void remove_id(id_item_t* pId);
 static EMBEDD_RESULT register_cb(  int event_id, embedd_callback_t cb, int one_shot );
 // ------------------------------------------------------------------------- //
 __attribute__((weak)) void engage_guard() {}
@@ -82,19 +134,21 @@ __attribute__((weak)) void engage_deinit() {}
 // ------------------------------------------------------------------------- //
 // event manager functions
 EMBEDD_RESULT embedd_event_manager_init() {
-    queue_wr_ptr    = queue;
-    queue_rd_ptr    = queue;
-    queue_data_size = 0;
+    queue_head      = 0;
+    queue_tail      = 0;
     process_enable  = true;
+    overflow_policy = EMBEDD_EVENT_MGR_OVERFLOW_POLICY;
+    memset ( &stats, 0, sizeof(stats) );
     memset ( event_manager_data, 0, sizeof(event_manager_data) );
+    active_id_count = 0;
+    coalescing_id_count = 0;
     engage_init();
     return EMBEDD_RESULT_OK;
 }
 
 EMBEDD_RESULT embedd_event_manager_deinit() {
-    queue_wr_ptr    = (struct EventSource *)NULL;
-    queue_rd_ptr    = (struct EventSource *)NULL;
-    queue_data_size = 0;
+    queue_head      = 0;
+    queue_tail      = 0;
     process_enable  = false;
     engage_deinit();
     return EMBEDD_RESULT_OK;
@@ -136,7 +190,7 @@ EMBEDD_RESULT embedd_event_manager_unregister_callback( int event_id, embedd_cal
                 
                 for( ; (pCb < pId->table + EMBEDD_EVENT_MGR_MAX_CB_FOR_ID_COUNT) && (pCb->cb == NULL); ++pCb );
                 if( pCb == pId->table + EMBEDD_EVENT_MGR_MAX_CB_FOR_ID_COUNT ) {
-                    pId->id = 0;
+                    remove_id( pId );
                 }
             }
         }
@@ -148,19 +202,17 @@ EMBEDD_RESULT embedd_event_manager_unregister_callback( int event_id, embedd_cal
 EMBEDD_RESULT embedd_event_manager_trigger(int event_id, void *device) {
     EMBEDD_RESULT res = EMBEDD_RESULT_OK;
     if( event_id != VOID_EVENT_ID ) {
-        if( get_id_ptr(event_id) != NULL ) {
-            if( queue_data_size == EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT ) {
-                queue_rd_inc();
-            }      
-
-            struct   EventSource ev = { .device = (embedd_device_t*)device, .event_id = event_id };
-        
-            engage_guard();
-            memcpy( queue_wr_ptr, &ev, sizeof(struct EventSource) );
-            disengage_guard(); 
-
-            queue_wr_inc();
-            res = EMBEDD_RESULT_OK; 
+        id_item_t* pId = get_id_ptr(event_id);
+        if( pId != NULL ) {
+            embedd_event_overflow_t policy = overflow_policy;
+            if( policy_guarded( policy ) || pId->coalesce ) {
+                // the tail or a queued item is updated here too, the consumer must not be taking an item meanwhile
+                engage_guard();
+                res = enqueue( pId, (embedd_device_t*)device, policy );
+                disengage_guard();
+            } else {
+                res = enqueue( pId, (embedd_device_t*)device, policy );
+            }
         } else {
             res = EMBEDD_RESULT_ERR;
         }
@@ -180,67 +232,252 @@ EMBEDD_RESULT embedd_event_manager_process_events_disable() {
     return EMBEDD_RESULT_OK; 
 }
 
+EMBEDD_RESULT embedd_event_manager_set_overflow_policy(embedd_event_overflow_t policy) {
+    if( policy > EMBEDD_EVENT_OVERFLOW_COALESCE ) {
+        return EMBEDD_RESULT_ERR;
+    }
+    overflow_policy =policy;
+    return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT embedd_event_manager_get_stats(embedd_event_stats_t *pStats) {
+    if( pStats == NULL ) {
+        return EMBEDD_RESULT_ERR;
+    }
+    pStats->enqueued    = __atomic_load_n( &stats.enqueued, __ATOMIC_RELAXED );
+    pStats->dispatched  = __atomic_load_n( &stats.dispatched, __ATOMIC_RELAXED );
+    pStats->dropped     = __atomic_load_n( &stats.dropped, __ATOMIC_RELAXED );
+    pStats->coalesced   = __atomic_load_n( &stats.coalesced, __ATOMIC_RELAXED );
+    pStats->high_water  = __atomic_load_n( &stats.high_water, __ATOMIC_RELAXED );
+    return EMBEDD_RESULT_OK;
+}
+
+EMBEDD_RESULT embedd_event_manager_set_coalescing(int event_id, int enable) {
+    EMBEDD_RESULT res = EMBEDD_RESULT_OK;
+    engage_guard();
+    id_item_t* pId = get_id_ptr(event_id);
+    if( pId == NULL ) {
+        res = EMBEDD_RESULT_ERR;
+    } else if( !pId->coalesce != !enable ) {
+        pId->coalesce = ( enable != 0 );
+        if( pId->coalesce ) {
+            ++ coalescing_id_count;
+        } else {
+            -- coalescing_id_count;
+        }
+    }
+    disengage_guard();
+    return res;
+}
+
 EMBEDD_RESULT embedd_event_manager_process() {
-    if( process_enable ) {
-        
-        for( ; queue_data_size; ) {
-            // check if if is in list
-            engage_guard();    
-            struct   EventSource ev = *queue_rd_ptr;
-            disengage_guard();    
-            id_item_t* pId = get_id_ptr(ev.event_id);
-            if( pId != NULL ) {
-                // check if exists registered callback
-                for( cb_item_t *pCb = pId->table ; pCb < pId->table + EMBEDD_EVENT_MGR_MAX_CB_FOR_ID_COUNT; ++pCb ) {
-                    if( pCb->cb ) {
-                        (*pCb->cb)( &ev );
-                        if( pCb->one_shot ) {
-                            // removed callback if one shot option
-                            pCb->cb =(embedd_callback_t)NULL;
-                            pCb->one_shot =0;
-                        }
-                    }
-                }
-            }
-            queue_rd_inc();
 #if EMBEDD_EVENT_MGR_PROCESS_ONE_ITEM == 1 
-            break;
+    embedd_event_manager_process_budget( 1, 0 );
+#else
+    embedd_event_manager_process_budget( 0, 0 );
 #endif
+    return EMBEDD_RESULT_OK; 
+}
+
+uint32_t embedd_event_manager_process_budget(uint32_t max_events, uint32_t max_ticks) {
+    if( process_enable ) {
+        uint32_t start = ( max_ticks != 0 ) ? embedd_hal_get_ticks() : 0;
+        queue_item_t item;
+        for( uint32_t count = 0; dequeue( &item ); ) {
+            dispatch( &item );
+            // the budget is checked after the event, so each call makes progress
+            if( ( max_events != 0 ) && ( ++count >= max_events ) ) {
+                break;
+            }
+            if( ( max_ticks != 0 ) && ( (uint32_t)( embedd_hal_get_ticks() - start ) >= max_ticks ) ) {
+                break;
+            }
         }
     }
-    return EMBEDD_RESULT_OK; 
+    return queue_size( __atomic_load_n( &queue_head, __ATOMIC_ACQUIRE ), __atomic_load_n( &queue_tail, __ATOMIC_ACQUIRE ) );
 }
 
 // ------------------------------------------------------------------------- //
-static void queue_rd_inc() {
-    engage_guard();
-    -- queue_data_size;
-    ++ queue_rd_ptr;
-    if( queue_rd_ptr >= queue + EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT ) {
-        queue_rd_ptr = queue;
+static EMBEDD_RESULT enqueue(id_item_t* pId, embedd_device_t *device, embedd_event_overflow_t policy) {
+    uint32_t head = queue_head;
+    uint32_t tail = __atomic_load_n( &queue_tail, __ATOMIC_ACQUIRE );
+    queue_item_t *item;
+    if( pId->coalesce ) {
+        // called guarded, the queued event is not being taken by the consumer
+        item = find_queued( pId->id, device, head, tail );
+        if( item != NULL ) {
+            ++ item->ev.count;
+            ++ stats.coalesced;
+            return EMBEDD_RESULT_OK;
+        }
     }
-    disengage_guard();
+    if( queue_size( head, tail ) == EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT ) {
+        switch( policy ) {
+        case EMBEDD_EVENT_OVERFLOW_DROP_NEWEST:
+            ++ stats.dropped;
+            return EMBEDD_RESULT_OK;
+        case EMBEDD_EVENT_OVERFLOW_DROP_OLDEST:
+            // called guarded, no item is being taken by the consumer
+            tail = queue_index_inc( tail );
+            __atomic_store_n( &queue_tail, tail, __ATOMIC_RELEASE );
+            ++ stats.dropped;
+            break;
+        case EMBEDD_EVENT_OVERFLOW_COALESCE:
+            item = find_queued( pId->id, device, head, tail );
+            if( item != NULL ) {
+                ++ item->ev.count;
+                ++ stats.coalesced;
+                return EMBEDD_RESULT_OK;
+            }
+            ++ stats.dropped;
+            return EMBEDD_RESULT_ERR;
+        default:
+            ++ stats.dropped;
+            return EMBEDD_RESULT_ERR;
+        }
+    }
+    item = queue_item( head );
+    item->ev.device     = device;
+    item->ev.event_id   = pId->id;
+    item->ev.count      = 1;
+    item->id_index      = (uint32_t)( pId - event_manager_data );
+    head = queue_index_inc( head );
+    // the item is complete before the consumer can see it
+    __atomic_store_n( &queue_head, head, __ATOMIC_RELEASE );
+    ++ stats.enqueued;
+    // the tail read before may only be behind, the mark errs on the high side
+    uint32_t size = queue_size( head, tail );
+    if( size > stats.high_water ) {
+        stats.high_water = size;
+    }
+    return EMBEDD_RESULT_OK;
 }
 
-static void queue_wr_inc() {
-    engage_guard();
-    ++ queue_data_size;
-    ++ queue_wr_ptr;
-    if( queue_wr_ptr >= queue + EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT ) {
-        queue_wr_ptr = queue;
+static bool dequeue(queue_item_t *item) {
+    bool res = false;
+    bool guarded = policy_guarded( overflow_policy ) || ( coalescing_id_count != 0 );
+    if( guarded ) {
+        engage_guard();
+    }
+    uint32_t tail = __atomic_load_n( &queue_tail, __ATOMIC_ACQUIRE );
+    if( queue_size( __atomic_load_n( &queue_head, __ATOMIC_ACQUIRE ), tail ) ) {
+        // copy the item out, it is reused once the tail is released
+        *item = *queue_item( tail );
+        __atomic_store_n( &queue_tail, queue_index_inc( tail ), __ATOMIC_RELEASE );
+        ++ stats.dispatched;
+        res = true;
+    }
+    if( guarded ) {
+        disengage_guard();
+    }
+    return res;
+}
+
+static queue_item_t* find_queued(int event_id, embedd_device_t *device, uint32_t head, uint32_t tail) {
+    // items between tail and head are written by the producer only
+    for( ; tail != head; tail = queue_index_inc( tail ) ) {
+        queue_item_t *item = queue_item( tail );
+        if( item->ev.event_id == event_id && item->ev.device == device ) {
+            return item;
+        }
+    }
+    return (queue_item_t*)NULL;
+}
+
+static void dispatch(queue_item_t *item) {
+    struct   EventSource ev = item->ev;
+    // the id resolved by trigger, unless it has been removed since
+    id_item_t* pId = &event_manager_data[item->id_index];
+    if( pId->id != ev.event_id ) {
+        pId = get_id_ptr(ev.event_id);
+    }
+    if( pId != NULL ) {
+        // check if exists registered callback
+        for( cb_item_t *pCb = pId->table ; pCb < pId->table + EMBEDD_EVENT_MGR_MAX_CB_FOR_ID_COUNT; ++pCb ) {
+            if( pCb->cb ) {
+                (*pCb->cb)( &ev );
+                if( pCb->one_shot ) {
+                    // removed callback if one shot option
+                    pCb->cb =(embedd_callback_t)NULL;
+                    pCb->one_shot =0;
+                }
+            }
+        }
     }
-    disengage_guard();
+}
+
+// ------------------------------------------------------------------------- //
+static bool policy_guarded(embedd_event_overflow_t policy) {
+    return ( policy == EMBEDD_EVENT_OVERFLOW_DROP_OLDEST ) || ( policy == EMBEDD_EVENT_OVERFLOW_COALESCE );
+}
+
+static uint32_t queue_index_inc(uint32_t index) {
+    return ( index + 1 == QUEUE_INDEX_WRAP ) ? 0 : index + 1;
+}
+
+static uint32_t queue_size(uint32_t head, uint32_t tail) {
+    return ( head >= tail ) ? head - tail : head + QUEUE_INDEX_WRAP - tail;
+}
+
+static queue_item_t* queue_item(uint32_t index) {
+    return &queue[ ( index < EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT ) ? index : index - EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT ];
+}
+
+static uint32_t id_hash(int event_id) {
+    return ( (uint32_t)event_id * ID_HASH_MULTIPLIER ) >> ( 32U - EMBEDD_EVENT_MGR_ID_HASH_BITS );
 }
 
 static id_item_t* get_id_ptr(int event_id) {
-    for( id_item_t* p = event_manager_data; p < event_manager_data + EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT; ++p ) {
+    if( event_id == VOID_EVENT_ID ) {
+        return (id_item_t*)NULL;
+    }
+    uint32_t index = id_hash(event_id);
+    for( uint32_t n = 0; n < ID_TABLE_SIZE; ++n ) {
+        id_item_t* p = &event_manager_data[index];
         if( p->id == event_id ) {
             return p;
         }
+        if( p->id == VOID_EVENT_ID && !p->deleted ) {
+            // the probe of the id would have ended here
+            break;
+        }
+        index = ( index + 1 ) & ( ID_TABLE_SIZE - 1 );
     }
     return (id_item_t*)NULL;
 }
 
+static id_item_t* add_id(int event_id) {
+    if( active_id_count == EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT ) {
+        return (id_item_t*)NULL;
+    }
+    // the id is not in table, it takes the first free item of its probe
+    uint32_t index = id_hash(event_id);
+    for( ; event_manager_data[index].id != VOID_EVENT_ID; index = ( index + 1 ) & ( ID_TABLE_SIZE - 1 ) );
+    id_item_t* p = &event_manager_data[index];
+    memset( p, 0, sizeof(id_item_t) );
+    p->id = event_id;
+    ++ active_id_count;
+    return p;
+}
+
+static void remove_id(id_item_t* pId) {
+    uint32_t index = (uint32_t)( pId - event_manager_data );
+    if( pId->coalesce ) {
+        -- coalescing_id_count;
+    }
+    memset( pId, 0, sizeof(id_item_t) );
+    -- active_id_count;
+    if( event_manager_data[( index + 1 ) & ( ID_TABLE_SIZE - 1 )].deleted ||
+        event_manager_data[( index + 1 ) & ( ID_TABLE_SIZE - 1 )].id != VOID_EVENT_ID ) {
+        pId->deleted = true;
+        return;
+    }
+    // no probe goes on past a free item, so the deleted items before it are free as well
+    for( index = ( index - 1 ) & ( ID_TABLE_SIZE - 1 ); event_manager_data[index].deleted; index = ( index - 1 ) & ( ID_TABLE_SIZE - 1 ) ) {
+        event_manager_data[index].deleted = false;
+    }
+}
+
 static EMBEDD_RESULT register_cb(  int event_id, embedd_callback_t cb, int one_shot ) {
     if( cb == NULL || event_id == VOID_EVENT_ID ) {
         return EMBEDD_RESULT_ERR;
@@ -264,7 +501,7 @@ static EMBEDD_RESULT register_cb(  int event_id, embedd_callback_t cb, int one_s
     }
         
     // no id, look for free space        
-    pId = get_id_ptr(VOID_EVENT_ID);
+    pId = add_id(event_id);
     if( pId != NULL ) {
         pId->id = event_id;
         pId->table[0].cb = cb;
@@ -28,9 +28,21 @@
 #define _SRC_EMBEDD_EVENT_MGR_CFG_H
   
 /*!
- *          Maximum count of events id processed by event manager
+ *          Maximum count of events id processed by event manager,
+ *          may be set by the build together with the table size
  */
-#define     EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT    (2U)
+#ifndef     EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT
+#define     EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT    (4U)
+#endif
+
+/*!
+ *          Size of the table of event ids as a power of two, the
+ *          table must have at least twice as many items as
+ *          EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT
+ */
+#ifndef     EMBEDD_EVENT_MGR_ID_HASH_BITS
+#define     EMBEDD_EVENT_MGR_ID_HASH_BITS           (3U)
+#endif
 
 /*!
  *          Maximum count of items in callback table for each event id
@@ -40,7 +52,7 @@
 /*!
  *          Maximum count of items in queue
  */
-#define     EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT  (4U)
+#define     EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT  (8U)
 
 /*!
  *          If this parameter is 1 events manager will process 
@@ -50,5 +62,11 @@
  */
 #define     EMBEDD_EVENT_MGR_PROCESS_ONE_ITEM       (1U)
 
+/*!
+ *          Handling of events triggered while the queue is full
+ *          after init, one of embedd_event_overflow_t
+ */
+#define     EMBEDD_EVENT_MGR_OVERFLOW_POLICY        (EMBEDD_EVENT_OVERFLOW_REJECT)
+
  
 #endif //_SRC_EMBEDD_EVENT_MGR_CFG_H
@@ -0,0 +1,133 @@
+/*!
+ * \file bench_bcd.c
+ * \brief Host benchmark of the BCD conversions used by the date and time codec
+ *
+ * Compares the lookup tables of ds3231_datetime.c (356 bytes of flash) with
+ * the arithmetic conversions they replaced, nibble multiply for BCD to binary
+ * and divide by ten for binary to BCD. Each access converts the seven
+ * timekeeping registers, as ds3231_datetime_from_regs() and
+ * ds3231_datetime_to_regs() do. The Cortex-M0+ has no hardware divider, so
+ * the divide by ten costs a call to __aeabi_uidivmod there; the host divides
+ * in hardware and understates the gap. Figures are host ns, only their
+ * ratios carry over to the target.
+ *
+ * Before timing, both paths are checked against each other over their
+ * whole input range.
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <stdlib.h>
+
+#include "ds3231_datetime.h"
+#include "test_util.h"
+
+#define BENCH_ITERATIONS    (10000000U)
+#define BENCH_ROUNDS        (5U)
+#define BENCH_SETS          (64U)
+#define BENCH_REGS          (7U)
+
+static uint8_t bench_bcd[BENCH_SETS][BENCH_REGS];
+static uint8_t bench_bin[BENCH_SETS][BENCH_REGS];
+
+/*!
+ * \brief BCD to binary without the table.
+ */
+static inline uint8_t bench_bcd2bin_naive(uint8_t bcd)
+{
+  return (uint8_t)( ( bcd >> 4 ) * 10U + ( bcd & 0x0FU ) );
+}
+
+/*!
+ * \brief Binary to BCD without the table.
+ */
+static inline uint8_t bench_bin2bcd_naive(uint8_t bin)
+{
+  return (uint8_t)( ( ( bin / 10U ) << 4 ) | ( bin % 10U ) );
+}
+
+/*!
+ * \brief Table lookups of the driver, wrapped to the signature of the arithmetic path.
+ */
+static inline uint8_t bench_bcd2bin_table(uint8_t bcd)
+{
+  return ds3231_bcd2bin( bcd );
+}
+
+static inline uint8_t bench_bin2bcd_table(uint8_t bin)
+{
+  return ds3231_bin2bcd( bin );
+}
+
+/*!
+ * \brief Checks the tables against the arithmetic over every valid input.
+ */
+static void bench_check(void)
+{
+  for( uint32_t bin = 0; bin < 100U; ++bin ) {
+    uint8_t bcd = bench_bin2bcd_naive( (uint8_t)bin );
+    CHECK( ds3231_bin2bcd( (uint8_t)bin ) == bcd );
+    CHECK( ds3231_bcd2bin( bcd ) == bin );
+    CHECK( bench_bcd2bin_naive( bcd ) == bin );
+  }
+}
+
+/*!
+ * \brief Times the conversion of a register image by \a convert, the best of BENCH_ROUNDS rounds is reported.
+ */
+#define BENCH_CONVERSIONS(name, from, convert) do { \
+  uint64_t elapsed = UINT64_MAX; \
+  uint32_t sum = 0; \
+  for( uint32_t round = 0; round < BENCH_ROUNDS; ++round ) { \
+    uint64_t start = test_now_ns(); \
+    for( uint32_t i = 0; i < BENCH_ITERATIONS; ++i ) { \
+      const uint8_t *regs = from[i & ( BENCH_SETS - 1 )]; \
+      for( uint32_t reg = 0; reg < BENCH_REGS; ++reg ) { \
+        sum += convert( regs[reg] ); \
+      } \
+    } \
+    uint64_t round_ns = test_now_ns() - start; \
+    elapsed = ( round_ns < elapsed ) ? round_ns : elapsed; \
+  } \
+  test_keep( sum ); \
+  printf( "%-24s %6.2f ns/image\n", name, (double)elapsed / BENCH_ITERATIONS ); \
+} while( 0 )
+
+int main(void)
+{
+  static const uint8_t limits[BENCH_REGS] = { 60, 60, 24, 7, 31, 12, 100 };
+
+  bench_check();
+  if( test_failures ) {
+    return TEST_RESULT();
+  }
+
+  for( uint32_t set = 0; set < BENCH_SETS; ++set ) {
+    for( uint32_t reg = 0; reg < BENCH_REGS; ++reg ) {
+      bench_bin[set][reg] = (uint8_t)( rand() % limits[reg] );
+      bench_bcd[set][reg] = ds3231_bin2bcd( bench_bin[set][reg] );
+    }
+  }
+
+  BENCH_CONVERSIONS( "bcd2bin arithmetic", bench_bcd, bench_bcd2bin_naive );
+  BENCH_CONVERSIONS( "bcd2bin table", bench_bcd, bench_bcd2bin_table );
+  BENCH_CONVERSIONS( "bin2bcd divide by ten", bench_bin, bench_bin2bcd_naive );
+  BENCH_CONVERSIONS( "bin2bcd table", bench_bin, bench_bin2bcd_table );
+  return 0;
+}
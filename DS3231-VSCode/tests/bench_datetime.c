@@ -0,0 +1,94 @@
+/*!
+ * \file bench_datetime.c
+ * \brief Host benchmark of the Unix time conversions
+ *
+ * Compares ds3231_datetime_to_epoch() and ds3231_epoch_to_datetime() with
+ * the libc timegm() and gmtime_r() they replace, over random instants of
+ * the chip's range. The newlib versions on the target are slower than the
+ * host libc, figures are host ns, only their ratios carry over.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "ds3231_datetime.h"
+#include "test_util.h"
+
+#define BENCH_ITERATIONS    (2000000U)
+#define BENCH_ROUNDS        (5U)
+#define BENCH_INSTANTS      (1024U)
+
+static int64_t bench_epochs[BENCH_INSTANTS];
+static ds3231_datetime_t bench_datetimes[BENCH_INSTANTS];
+static struct tm bench_tms[BENCH_INSTANTS];
+
+/*!
+ * \brief Times \a convert applied to instant i, the best of BENCH_ROUNDS rounds is reported.
+ */
+#define BENCH_CONVERSIONS(name, convert) do {   uint64_t elapsed = UINT64_MAX;   uint32_t sum = 0;   for( uint32_t round = 0; round < BENCH_ROUNDS; ++round ) {     uint64_t start = test_now_ns();     for( uint32_t n = 0; n < BENCH_ITERATIONS; ++n ) {       uint32_t i = n & ( BENCH_INSTANTS - 1 );       sum += (uint32_t)( convert );     }     uint64_t round_ns = test_now_ns() - start;     elapsed = ( round_ns < elapsed ) ? round_ns : elapsed;   }   test_keep( sum );   printf( "%-26s %7.2f ns/conversion\n", name, (double)elapsed / BENCH_ITERATIONS ); } while( 0 )
+
+static uint32_t bench_to_epoch(uint32_t i)
+{
+  int64_t epoch;
+  ds3231_datetime_to_epoch( &bench_datetimes[i], &epoch );
+  return (uint32_t)epoch;
+}
+
+static uint32_t bench_timegm(uint32_t i)
+{
+  struct tm tm = bench_tms[i];
+  return (uint32_t)timegm( &tm );
+}
+
+static uint32_t bench_from_epoch(uint32_t i)
+{
+  ds3231_datetime_t datetime;
+  ds3231_epoch_to_datetime( bench_epochs[i], &datetime );
+  return datetime.date + datetime.seconds;
+}
+
+static uint32_t bench_gmtime(uint32_t i)
+{
+  struct tm tm;
+  time_t t = (time_t)bench_epochs[i];
+  gmtime_r( &t, &tm );
+  return (uint32_t)( tm.tm_mday + tm.tm_sec );
+}
+
+int main(void)
+{
+  for( uint32_t i = 0; i < BENCH_INSTANTS; ++i ) {
+    uint64_t r = ( (uint64_t)rand() << 31 ) | (uint64_t)rand();
+    bench_epochs[i] = DS3231_EPOCH_MIN + (int64_t)( r % (uint64_t)( DS3231_EPOCH_MAX - DS3231_EPOCH_MIN + 1 ) );
+    ds3231_epoch_to_datetime( bench_epochs[i], &bench_datetimes[i] );
+    time_t t = (time_t)bench_epochs[i];
+    gmtime_r( &t, &bench_tms[i] );
+  }
+
+  BENCH_CONVERSIONS( "ds3231_datetime_to_epoch", bench_to_epoch( i ) );
+  BENCH_CONVERSIONS( "timegm", bench_timegm( i ) );
+  BENCH_CONVERSIONS( "ds3231_epoch_to_datetime", bench_from_epoch( i ) );
+  BENCH_CONVERSIONS( "gmtime_r", bench_gmtime( i ) );
+  return 0;
+}
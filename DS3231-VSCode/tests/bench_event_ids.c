@@ -0,0 +1,195 @@
+/*!
+ * \file bench_event_ids.c
+ * \brief Host benchmark of the event manager over hundreds of event ids
+ *
+ * The event manager is built into this benchmark on its own with room for
+ * BENCH_MAX_IDS ids, and the count of registered ids is swept from 1 up to
+ * that. Each point times the trigger and the processing of an event, cycling
+ * over all the registered ids so that every probe length is taken, and the
+ * trigger of an id that is not registered, which probes up to a free item.
+ * The churn columns do the same after BENCH_MAX_IDS ids were registered and
+ * all but the count of the point unregistered, so the table is full of
+ * deleted items. A linear search over the same ids, as the id table did
+ * before it was hashed, is timed for comparison. Figures are host ns, only
+ * their trend over the id count carries over to the target.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include "event_manager_cfg.h"
+#include "embedd_event.h"
+#include "test_util.h"
+
+#define BENCH_MAX_IDS       (EMBEDD_EVENT_MGR_MAX_ACTIVE_ID_COUNT)
+#define BENCH_EVENTS        (1U << 20)
+#define BENCH_ROUNDS        (5U)
+#define BENCH_BATCH         (EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT)
+
+/*!
+ * \struct bench_cost_t
+ * \brief Costs of a point, ns per call
+ */
+typedef struct {
+  double trigger;
+  double process;
+  double miss;
+} bench_cost_t;
+
+static int bench_ids[BENCH_MAX_IDS];
+static int bench_missing[BENCH_MAX_IDS];
+static uint32_t bench_dispatched;
+
+static void bench_on_event(struct EventSource *ev)
+{
+  ++ bench_dispatched;
+}
+
+/*!
+ * \brief Fills the ids and the ids never registered, all distinct and spread over 32 bits as the driver ids.
+ */
+static void bench_make_ids(void)
+{
+  uint32_t x = 1;
+  for( uint32_t i = 0; i < 2 * BENCH_MAX_IDS; ) {
+    // full period generator, no value repeats
+    x = x * 1664525U + 1013904223U;
+    if( (int)x == VOID_EVENT_ID ) {
+      continue;
+    }
+    if( i < BENCH_MAX_IDS ) {
+      bench_ids[i] = (int)x;
+    } else {
+      bench_missing[i - BENCH_MAX_IDS] = (int)x;
+    }
+    ++ i;
+  }
+}
+
+/*!
+ * \brief Linear search of the id table before it was hashed.
+ */
+__attribute__((noipa)) static int bench_linear_find(const int *ids, uint32_t count, int id)
+{
+  for( uint32_t i = 0; i < count; ++i ) {
+    if( ids[i] == id ) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+/*!
+ * \brief Registers the ids \a first to \a last - 1 after a fresh init.
+ */
+static void bench_register(uint32_t first, uint32_t last)
+{
+  embedd_event_manager_init();
+  for( uint32_t i = first; i < last; ++i ) {
+    CHECK( embedd_event_manager_register_callback( bench_ids[i], bench_on_event ) == EMBEDD_RESULT_OK );
+  }
+}
+
+/*!
+ * \brief Times the events of the ids \a first to \a last - 1, the best of BENCH_ROUNDS rounds is reported.
+ */
+static bench_cost_t bench_events(uint32_t first, uint32_t last)
+{
+  bench_cost_t best = { 1e9, 1e9, 1e9 };
+  uint32_t count = last - first;
+
+  for( uint32_t round = 0; round < BENCH_ROUNDS; ++round ) {
+    uint64_t trigger_ns = 0, process_ns = 0;
+    uint32_t id = 0;
+    bench_dispatched = 0;
+    for( uint32_t event = 0; event < BENCH_EVENTS; event += BENCH_BATCH ) {
+      uint64_t start = test_now_ns();
+      for( uint32_t i = 0; i < BENCH_BATCH; ++i ) {
+        embedd_event_manager_trigger( bench_ids[first + id], NULL );
+        id = ( id + 1 == count ) ? 0 : id + 1;
+      }
+      uint64_t triggered = test_now_ns();
+      embedd_event_manager_process_budget( 0, 0 );
+      process_ns += test_now_ns() - triggered;
+      trigger_ns += triggered - start;
+    }
+    CHECK( bench_dispatched == BENCH_EVENTS );
+
+    uint32_t rejected = 0;
+    uint64_t start = test_now_ns();
+    for( uint32_t event = 0; event < BENCH_EVENTS; ++event ) {
+      rejected += ( embedd_event_manager_trigger( bench_missing[event & ( BENCH_MAX_IDS - 1 )], NULL ) != EMBEDD_RESULT_OK );
+    }
+    uint64_t miss_ns = test_now_ns() - start;
+    CHECK( rejected == BENCH_EVENTS );
+
+    bench_cost_t cost = { (double)trigger_ns / BENCH_EVENTS, (double)process_ns / BENCH_EVENTS, (double)miss_ns / BENCH_EVENTS };
+    best.trigger = ( cost.trigger < best.trigger ) ? cost.trigger : best.trigger;
+    best.process = ( cost.process < best.process ) ? cost.process : best.process;
+    best.miss = ( cost.miss < best.miss ) ? cost.miss : best.miss;
+  }
+  return best;
+}
+
+/*!
+ * \brief Times the linear search of the ids, cycling over them as bench_events() does.
+ */
+static double bench_linear(uint32_t count)
+{
+  uint64_t elapsed = UINT64_MAX;
+  uint32_t sum = 0;
+  for( uint32_t round = 0; round < BENCH_ROUNDS; ++round ) {
+    uint32_t id = 0;
+    uint64_t start = test_now_ns();
+    for( uint32_t event = 0; event < BENCH_EVENTS; ++event ) {
+      sum += (uint32_t)bench_linear_find( bench_ids, count, bench_ids[id] );
+      id = ( id + 1 == count ) ? 0 : id + 1;
+    }
+    uint64_t round_ns = test_now_ns() - start;
+    elapsed = ( round_ns < elapsed ) ? round_ns : elapsed;
+  }
+  test_keep( sum );
+  return (double)elapsed / BENCH_EVENTS;
+}
+
+int main(void)
+{
+  static const uint32_t counts[] = { 1, 4, 16, 64, 128, 256, 384, 512 };
+
+  bench_make_ids();
+  printf( "%5s %9s %9s %9s | %9s %9s %9s | %9s\n", "ids", "trigger", "process", "miss",
+          "trigger", "process", "miss", "linear" );
+  printf( "%5s %29s | %29s | %9s\n", "", "fresh table, ns/event", "after churn, ns/event", "ns/find" );
+  for( uint32_t i = 0; i < sizeof(counts) / sizeof(counts[0]) && counts[i] <= BENCH_MAX_IDS; ++i ) {
+    uint32_t count = counts[i];
+    bench_register( 0, count );
+    bench_cost_t fresh = bench_events( 0, count );
+
+    // all the ids registered, then the first ones unregistered, leaving deleted items all over the table
+    bench_register( 0, BENCH_MAX_IDS );
+    for( uint32_t id = 0; id < BENCH_MAX_IDS - count; ++id ) {
+      CHECK( embedd_event_manager_unregister_callback( bench_ids[id], bench_on_event ) == EMBEDD_RESULT_OK );
+    }
+    bench_cost_t churn = bench_events( BENCH_MAX_IDS - count, BENCH_MAX_IDS );
+
+    printf( "%5u %9.2f %9.2f %9.2f | %9.2f %9.2f %9.2f | %9.2f\n", count, fresh.trigger, fresh.process, fresh.miss,
+            churn.trigger, churn.process, churn.miss, bench_linear( count ) );
+  }
+  return TEST_RESULT();
+}
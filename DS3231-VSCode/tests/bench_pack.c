@@ -0,0 +1,111 @@
+/*!
+ * \file bench_pack.c
+ * \brief Host benchmark of the byte-order packing used by every register access
+ *
+ * Compares, for the register sizes the driver uses, the out-of-line checked
+ * byte loop every access went through before (reproduced here), the current
+ * out-of-line embedd_pack() and the inline embedd_pack_sized() selected at
+ * compile time by the register macros. A register access packs on the way
+ * out and unpacks on the way in, so one access is timed as two copies.
+ * Figures are host ns, only their ratios carry over to the target.
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <stdlib.h>
+
+#include "embedd_misc.h"
+#include "test_util.h"
+
+#define BENCH_ITERATIONS    (10000000U)
+#define BENCH_ROUNDS        (5U)
+#define BENCH_BUF_SIZE      (64U)
+
+static uint8_t bench_src[BENCH_BUF_SIZE + 8];
+static uint8_t bench_dst[BENCH_BUF_SIZE + 8];
+
+/*!
+ * \brief embedd_pack() as it was before the size-specialized variants.
+ */
+__attribute__((noipa)) static size_t bench_pack_loop(void* dst, void* src, size_t Size)
+{
+  if( dst == NULL || src == NULL ) {
+    return 0;
+  }
+  if( Size == 0 ) {
+    return 0;
+  }
+  const uint8_t *srcPtr = (const uint8_t *)src + Size - 1;
+  uint8_t *dstPtr = (uint8_t *)dst;
+  for( size_t i = 0; i < Size; ++i ) {
+    *dstPtr++ = *srcPtr--;
+  }
+  return Size;
+}
+
+/*!
+ * \brief Times a register access done by \a pack, the best of BENCH_ROUNDS rounds is reported.
+ */
+#define BENCH_ACCESSES(name, size, pack) do { \
+  uint64_t elapsed = UINT64_MAX; \
+  for( uint32_t round = 0; round < BENCH_ROUNDS; ++round ) { \
+    uint64_t start = test_now_ns(); \
+    for( uint32_t i = 0; i < BENCH_ITERATIONS; ++i ) { \
+      uint32_t offset = i & ( BENCH_BUF_SIZE - 1 ); \
+      pack( bench_dst + offset, bench_src + offset, size ); \
+      pack( bench_src + offset, bench_dst + offset, size ); \
+    } \
+    uint64_t round_ns = test_now_ns() - start; \
+    elapsed = ( round_ns < elapsed ) ? round_ns : elapsed; \
+  } \
+  test_keep( bench_src[0] ); \
+  printf( "%-22s %u bytes  %6.2f ns/access\n", name, (unsigned)(size), (double)elapsed / BENCH_ITERATIONS ); \
+} while( 0 )
+
+static void bench_size_1(void)
+{
+  BENCH_ACCESSES( "checked byte loop", 1, bench_pack_loop );
+  BENCH_ACCESSES( "embedd_pack", 1, embedd_pack );
+  BENCH_ACCESSES( "embedd_pack_sized", 1, embedd_pack_sized );
+}
+
+static void bench_size_2(void)
+{
+  BENCH_ACCESSES( "checked byte loop", 2, bench_pack_loop );
+  BENCH_ACCESSES( "embedd_pack", 2, embedd_pack );
+  BENCH_ACCESSES( "embedd_pack_sized", 2, embedd_pack_sized );
+}
+
+static void bench_size_4(void)
+{
+  BENCH_ACCESSES( "checked byte loop", 4, bench_pack_loop );
+  BENCH_ACCESSES( "embedd_pack", 4, embedd_pack );
+  BENCH_ACCESSES( "embedd_pack_sized", 4, embedd_pack_sized );
+}
+
+int main(void)
+{
+  for( uint32_t i = 0; i < sizeof(bench_src); ++i ) {
+    bench_src[i] = (uint8_t)rand();
+  }
+  bench_size_1();
+  bench_size_2();
+  bench_size_4();
+  return 0;
+}
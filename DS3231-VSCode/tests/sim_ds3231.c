@@ -0,0 +1,177 @@
+/*!
+ * \file sim_ds3231.c
+ * \brief Simulated Ds3231 on a fake bus for the host tests
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "sim_ds3231.h"
+
+sim_ds3231_t sim_ds3231;
+
+static void sim_ds3231_read_bytes(uint8_t *data_ptr, uint32_t data_size)
+{
+  for( uint32_t i = 0; i < data_size; ++i ) {
+    if( sim_ds3231.on_read != NULL ) {
+      sim_ds3231.on_read( sim_ds3231.ptr );
+    }
+    data_ptr[i] = sim_ds3231.regs[sim_ds3231.ptr];
+    ++ sim_ds3231.reads;
+    sim_ds3231.ptr = ( sim_ds3231.ptr + 1 ) % DS3231_REGISTER_MAP_SIZE;
+  }
+}
+
+static void sim_ds3231_write_bytes(const uint8_t *data_ptr, uint32_t data_size)
+{
+  // the first byte sets the register pointer
+  sim_ds3231.ptr = data_ptr[0] % DS3231_REGISTER_MAP_SIZE;
+  for( uint32_t i = 1; i < data_size; ++i ) {
+    uint8_t addr = sim_ds3231.ptr;
+    sim_ds3231.regs[addr] = data_ptr[i];
+    ++ sim_ds3231.writes;
+    sim_ds3231.ptr = ( sim_ds3231.ptr + 1 ) % DS3231_REGISTER_MAP_SIZE;
+    if( sim_ds3231.on_write != NULL ) {
+      sim_ds3231.on_write( addr, data_ptr[i] );
+    }
+  }
+}
+
+/*!
+ * \brief Counts a transfer and returns its result.
+ */
+static EMBEDD_RESULT sim_ds3231_begin(void)
+{
+  ++ sim_ds3231.transfers;
+  if( ( sim_ds3231.fail_from != 0 ) && ( sim_ds3231.transfers >= sim_ds3231.fail_from ) ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  return sim_ds3231.result;
+}
+
+static EMBEDD_RESULT sim_ds3231_write(const struct embedd_device_t *dev, const uint8_t *data_ptr, uint32_t data_size)
+{
+  EMBEDD_RESULT result = sim_ds3231_begin();
+  if( result == EMBEDD_RESULT_OK ) {
+    sim_ds3231_write_bytes( data_ptr, data_size );
+  }
+  return result;
+}
+
+static EMBEDD_RESULT sim_ds3231_read(const struct embedd_device_t *dev, uint8_t *data_ptr, uint32_t data_size)
+{
+  EMBEDD_RESULT result = sim_ds3231_begin();
+  if( result == EMBEDD_RESULT_OK ) {
+    sim_ds3231_read_bytes( data_ptr, data_size );
+  }
+  return result;
+}
+
+static EMBEDD_RESULT sim_ds3231_writev(const struct embedd_device_t *dev, const embedd_bus_iovec_t *iov, uint32_t iov_count)
+{
+  uint8_t buf[DS3231_REGISTER_ADDR_SIZE + DS3231_REGISTER_MAP_SIZE];
+  uint32_t size = 0;
+  for( uint32_t i = 0; i < iov_count; ++i ) {
+    if( size + iov[i].data_size > sizeof(buf) ) {
+      return EMBEDD_RESULT_ERR;
+    }
+    memcpy( buf + size, iov[i].data_ptr, iov[i].data_size );
+    size += iov[i].data_size;
+  }
+  return sim_ds3231_write( dev, buf, size );
+}
+
+static EMBEDD_RESULT sim_ds3231_write_read(const struct embedd_device_t *dev, const uint8_t *wr_ptr, uint32_t wr_size, uint8_t *rd_ptr, uint32_t rd_size)
+{
+  EMBEDD_RESULT result = sim_ds3231_begin();
+  if( result == EMBEDD_RESULT_OK ) {
+    sim_ds3231_write_bytes( wr_ptr, wr_size );
+    sim_ds3231_read_bytes( rd_ptr, rd_size );
+  }
+  return result;
+}
+
+static EMBEDD_RESULT sim_ds3231_start(const struct embedd_device_t *dev, uint8_t *rd_ptr, uint32_t rd_size, embedd_bus_done_t done)
+{
+  if( sim_ds3231.pending ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  sim_ds3231.done = done;
+  sim_ds3231.done_dev = dev;
+  sim_ds3231.rd_ptr = rd_ptr;
+  sim_ds3231.rd_size = rd_size;
+  // the transfer is complete before another thread completing it sees the flag
+  __atomic_store_n( &sim_ds3231.pending, true, __ATOMIC_RELEASE );
+  return EMBEDD_RESULT_OK;
+}
+
+static EMBEDD_RESULT sim_ds3231_write_async(const struct embedd_device_t *dev, const uint8_t *data_ptr, uint32_t data_size, embedd_bus_done_t done)
+{
+  // the register pointer and the data are taken now, the driver keeps its buffer until completion anyway
+  if( sim_ds3231_start( dev, NULL, 0, done ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  if( sim_ds3231.result == EMBEDD_RESULT_OK ) {
+    sim_ds3231_write_bytes( data_ptr, data_size );
+  }
+  return EMBEDD_RESULT_OK;
+}
+
+static EMBEDD_RESULT sim_ds3231_write_read_async(const struct embedd_device_t *dev, const uint8_t *wr_ptr, uint32_t wr_size, uint8_t *rd_ptr, uint32_t rd_size, embedd_bus_done_t done)
+{
+  if( sim_ds3231_start( dev, rd_ptr, rd_size, done ) != EMBEDD_RESULT_OK ) {
+    return EMBEDD_RESULT_ERR;
+  }
+  sim_ds3231.ptr = wr_ptr[0] % DS3231_REGISTER_MAP_SIZE;
+  return EMBEDD_RESULT_OK;
+}
+
+static embedd_bus_t sim_ds3231_bus = {
+  .name = "sim",
+  .write = sim_ds3231_write,
+  .read = sim_ds3231_read,
+  .writev = sim_ds3231_writev,
+  .write_read = sim_ds3231_write_read,
+  .write_async = sim_ds3231_write_async,
+  .write_read_async = sim_ds3231_write_read_async,
+};
+
+void sim_ds3231_attach(embedd_device_t *dev)
+{
+  memset( &sim_ds3231, 0, sizeof(sim_ds3231) );
+  sim_ds3231.result = EMBEDD_RESULT_OK;
+  dev->bus = &sim_ds3231_bus;
+  embedd_i2c_dev_cfg_t cfg = { .addr = 0x68 };
+  embedd_i2c_set_dev_config( dev, &cfg );
+}
+
+bool sim_ds3231_complete(void)
+{
+  if( !__atomic_load_n( &sim_ds3231.pending, __ATOMIC_ACQUIRE ) ) {
+    return false;
+  }
+  sim_ds3231.pending = false;
+  ++ sim_ds3231.transfers;
+  if( sim_ds3231.rd_ptr != NULL && sim_ds3231.result == EMBEDD_RESULT_OK ) {
+    sim_ds3231_read_bytes( sim_ds3231.rd_ptr, sim_ds3231.rd_size );
+  }
+  sim_ds3231.done( sim_ds3231.done_dev, sim_ds3231.result );
+  return true;
+}
@@ -0,0 +1,96 @@
+/*!
+ * \file sim_ds3231.h
+ * \brief Simulated Ds3231 on a fake bus for the host tests
+ *
+ * The register map is an array behind an embedd_bus_t with all the optional
+ * operations. Register accesses can be observed and altered by hooks, which
+ * model the timing of the device. Asynchronous transfers stay pending until
+ * sim_ds3231_complete() is called, the data is moved at completion as by DMA.
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _TESTS_SIM_DS3231_H
+#define _TESTS_SIM_DS3231_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ds3231.h"
+
+/*!
+ * \struct sim_ds3231_t
+ * \brief State of the simulated device
+ *
+ * \var regs          register map indexed by register address
+ * \var ptr           register pointer, incremented by each access and wrapping after the last register
+ * \var transfers     count of bus transfers
+ * \var reads         count of registers read
+ * \var writes        count of registers written
+ * \var result        result of the next transfers, a failed transfer does not access the registers
+ * \var fail_from     number of the synchronous transfer from which on all fail, 0 for none
+ * \var on_read       optional hook called before a register is read
+ * \var on_write      optional hook called after a register is written
+ * \var pending       true while an asynchronous transfer waits for completion
+ * \var done          completion callback of the pending transfer
+ * \var done_dev      device of the pending transfer
+ * \var rd_ptr        buffer of the pending read, NULL for a write
+ * \var rd_size       size of the pending read
+ */
+typedef struct {
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+  uint8_t ptr;
+  uint32_t transfers;
+  uint32_t reads;
+  uint32_t writes;
+  EMBEDD_RESULT result;
+  uint32_t fail_from;
+  void (*on_read)(uint8_t addr);
+  void (*on_write)(uint8_t addr, uint8_t value);
+  bool pending;
+  embedd_bus_done_t done;
+  const embedd_device_t *done_dev;
+  uint8_t *rd_ptr;
+  uint32_t rd_size;
+} sim_ds3231_t;
+
+/*!
+ * \var sim_ds3231
+ * \brief The simulated device
+ */
+extern sim_ds3231_t sim_ds3231;
+
+/*!
+ * \brief Resets the simulated device and attaches \a dev to its bus.
+ *
+ * All registers are cleared, hooks are removed and transfers succeed.
+ *
+ * \param dev Pointer to the device defined by DS3231_I2C_DEVICE_DEFINE.
+ */
+void sim_ds3231_attach(embedd_device_t *dev);
+
+/*!
+ * \brief Completes the pending asynchronous transfer.
+ *
+ * May be called from another thread, as the completion interrupt of the bus.
+ *
+ * \return true if a transfer was pending.
+ */
+bool sim_ds3231_complete(void);
+
+#endif//_TESTS_SIM_DS3231_H
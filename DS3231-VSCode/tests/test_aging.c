@@ -0,0 +1,150 @@
+/*!
+ * \file test_aging.c
+ * \brief Host test of the aging offset calibration
+ *
+ * Checks that a new aging offset forces a temperature conversion, deferred
+ * while the device is busy, and that the drift samples are discarded until
+ * the conversion applying the offset has completed.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include "ds3231.h"
+#include "ds3231_fields.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+#define REF_HZ          (1000000U)
+#define SAMPLE_SECONDS  (10U)
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+static ds3231_aging_t aging;
+
+static bool conv_set(void)
+{
+  return ( sim_ds3231.regs[ds3231_control_read_reg_addr] & DS3231_FIELD_MASK(ds3231_control, conv) ) != 0;
+}
+
+/*!
+ * \brief Completes the conversion forced by CONV.
+ */
+static void conversion_done(void)
+{
+  sim_ds3231.regs[ds3231_control_read_reg_addr] &= ~DS3231_FIELD_MASK(ds3231_control, conv);
+}
+
+static void set_busy(bool busy)
+{
+  if( busy ) {
+    sim_ds3231.regs[ds3231_status_read_reg_addr] |= DS3231_FIELD_MASK(ds3231_status, bsy);
+  } else {
+    sim_ds3231.regs[ds3231_status_read_reg_addr] &= ~DS3231_FIELD_MASK(ds3231_status, bsy);
+  }
+}
+
+/*!
+ * \brief Adds a sample of the device drifting by about \a drift_ppb.
+ */
+static EMBEDD_RESULT add_sample(int32_t drift_ppb)
+{
+  uint32_t ticks = SAMPLE_SECONDS * REF_HZ - drift_ppb * (int32_t)( SAMPLE_SECONDS * REF_HZ / 1000000U ) / 1000;
+  return ds3231_aging_add_sample( &aging, SAMPLE_SECONDS, ticks, REF_HZ );
+}
+
+static void test_set_code(void)
+{
+  CHECK( ds3231_aging_init( &aging, &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( aging.code == -3 && aging.settle == DS3231_AGING_SETTLE_NONE );
+
+  // the conversion is forced with the write
+  CHECK( ds3231_aging_set_code( &aging, 5 ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.regs[ds3231_aging_offset_read_reg_addr] == 5 );
+  CHECK( conv_set() && aging.settle == DS3231_AGING_SETTLE_CONVERTING );
+
+  // discarded while converting and for the sample the conversion completed in
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK );
+  CHECK( aging.discarded == 1 && aging.samples == 0 );
+  conversion_done();
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK );
+  CHECK( aging.discarded == 2 && aging.samples == 0 && aging.settle == DS3231_AGING_SETTLE_NONE );
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK );
+  CHECK( aging.discarded == 2 && aging.samples == 1 );
+}
+
+static void test_busy(void)
+{
+  // the device runs its own conversion, CONV is set by a later sample
+  set_busy( true );
+  CHECK( ds3231_aging_set_code( &aging, -7 ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.regs[ds3231_aging_offset_read_reg_addr] == (uint8_t)-7 );
+  CHECK( !conv_set() && aging.settle == DS3231_AGING_SETTLE_PENDING );
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK );
+  CHECK( !conv_set() && aging.discarded == 3 );
+  set_busy( false );
+
+  // a failed bus leaves the conversion to be forced by the next sample
+  sim_ds3231.result = EMBEDD_RESULT_ERR;
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_ERR );
+  CHECK( aging.settle == DS3231_AGING_SETTLE_PENDING && aging.samples == 0 );
+  sim_ds3231.result = EMBEDD_RESULT_OK;
+
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK );
+  CHECK( conv_set() && aging.settle == DS3231_AGING_SETTLE_CONVERTING && aging.discarded == 4 );
+  conversion_done();
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK );
+  CHECK( aging.discarded == 5 && aging.samples == 0 );
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK && aging.samples == 1 );
+}
+
+static void test_correction(void)
+{
+  CHECK( ds3231_aging_set_code( &aging, 0 ) == EMBEDD_RESULT_OK );
+  conversion_done();
+  CHECK( add_sample( 0 ) == EMBEDD_RESULT_OK );
+  CHECK( aging.settle == DS3231_AGING_SETTLE_NONE && aging.samples == 0 );
+
+  // 500 ppb fast is corrected by 5 LSB once the filter has its samples
+  uint32_t discarded = aging.discarded;
+  for( uint32_t i = 0; i < DS3231_AGING_MIN_SAMPLES; ++i ) {
+    CHECK( !conv_set() );
+    CHECK( add_sample( 500 ) == EMBEDD_RESULT_OK );
+  }
+  CHECK( aging.code == 5 && aging.corrections == 1 );
+  CHECK( conv_set() && aging.settle == DS3231_AGING_SETTLE_CONVERTING );
+  CHECK( aging.discarded == discarded );
+
+  // the samples measured with the old offset are not counted against the new one
+  CHECK( add_sample( 500 ) == EMBEDD_RESULT_OK );
+  conversion_done();
+  CHECK( add_sample( 500 ) == EMBEDD_RESULT_OK );
+  CHECK( aging.samples == 0 && aging.discarded == discarded + 2 );
+}
+
+int main(void)
+{
+  sim_ds3231_attach( &clock_chip );
+  sim_ds3231.regs[ds3231_aging_offset_read_reg_addr] = (uint8_t)-3;
+
+  test_set_code();
+  test_busy();
+  test_correction();
+  return TEST_RESULT();
+}
@@ -0,0 +1,256 @@
+/*!
+ * \file test_alarm.c
+ * \brief Host test of the alarm compiler against the datasheet
+ *
+ * For every mode on both alarms, every valid value of the matched fields is
+ * compiled and the image is compared byte for byte with the mask bits and
+ * DY/DT of the alarm mask bits table of the datasheet, then decoded back.
+ * Modes an alarm does not have, out of range fields and register contents
+ * that do not form a mode are rejected.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "ds3231.h"
+#include "test_util.h"
+
+#define MASK        (0x80U)
+#define DYDT        (0x40U)
+#define X           (-1)      // DY/DT not looked at
+#define UNUSED      (99U)     // value of the fields not matched, ignored by the compiler
+
+/*!
+ * \struct alarm_row_t
+ * \brief Row of the alarm mask bits table, masks in the order of the alarm registers
+ */
+typedef struct {
+  ds3231_alarm_t alarm;
+  ds3231_alarm_mode_t mode;
+  int8_t dydt;
+  uint8_t masks[DS3231_ALARM_IMAGE_SIZE];
+} alarm_row_t;
+
+static const alarm_row_t alarm_table[] = {
+  //                                              DY/DT  A1M1 A1M2 A1M3 A1M4
+  { DS3231_ALARM_1, DS3231_ALARM_MODE_EVERY_SECOND, X,   { 1, 1, 1, 1 } },
+  { DS3231_ALARM_1, DS3231_ALARM_MODE_AT_SECONDS,   X,   { 0, 1, 1, 1 } },
+  { DS3231_ALARM_1, DS3231_ALARM_MODE_AT_MINUTES,   X,   { 0, 0, 1, 1 } },
+  { DS3231_ALARM_1, DS3231_ALARM_MODE_DAILY,        X,   { 0, 0, 0, 1 } },
+  { DS3231_ALARM_1, DS3231_ALARM_MODE_DATE,         0,   { 0, 0, 0, 0 } },
+  { DS3231_ALARM_1, DS3231_ALARM_MODE_WEEKDAY,      1,   { 0, 0, 0, 0 } },
+  //                                              DY/DT  A2M2 A2M3 A2M4
+  { DS3231_ALARM_2, DS3231_ALARM_MODE_EVERY_MINUTE, X,   { 1, 1, 1 } },
+  { DS3231_ALARM_2, DS3231_ALARM_MODE_AT_MINUTES,   X,   { 0, 1, 1 } },
+  { DS3231_ALARM_2, DS3231_ALARM_MODE_DAILY,        X,   { 0, 0, 1 } },
+  { DS3231_ALARM_2, DS3231_ALARM_MODE_DATE,         0,   { 0, 0, 0 } },
+  { DS3231_ALARM_2, DS3231_ALARM_MODE_WEEKDAY,      1,   { 0, 0, 0 } },
+};
+
+static uint8_t to_bcd(uint8_t value)
+{
+  return (uint8_t)( ( ( value / 10 ) << 4 ) | ( value % 10 ) );
+}
+
+static const alarm_row_t* find_row(ds3231_alarm_t alarm, ds3231_alarm_mode_t mode)
+{
+  for( uint32_t i = 0; i < CountOfArray(alarm_table); ++i ) {
+    if( alarm_table[i].alarm == alarm && alarm_table[i].mode == mode ) {
+      return &alarm_table[i];
+    }
+  }
+  return NULL;
+}
+
+/*!
+ * \brief Compiles \a spec, checks the image against the row and decodes it back.
+ */
+static void check_spec(const alarm_row_t *row, const ds3231_alarm_spec_t *spec, const uint8_t values[DS3231_ALARM_IMAGE_SIZE])
+{
+  ds3231_alarm_image_t image;
+  ds3231_alarm_spec_t decoded, expected = { .mode = row->mode };
+  uint8_t size = ( row->alarm == DS3231_ALARM_1 ) ? 4 : 3;
+
+  CHECK( ds3231_alarm_compile( row->alarm, spec, &image ) == EMBEDD_RESULT_OK );
+  CHECK( image.alarm == row->alarm && image.size == size );
+  for( uint32_t i = 0; i < size; ++i ) {
+    uint8_t byte = row->masks[i] ? MASK : to_bcd( values[i] );
+    if( i == size - 1u && row->dydt == 1 ) {
+      byte |= DYDT;
+    }
+    CHECK( image.regs[i] == byte );
+  }
+
+  // fields not matched decode as 0
+  uint8_t *fields[DS3231_ALARM_IMAGE_SIZE] = { &expected.seconds, &expected.minutes, &expected.hour, &expected.day_date };
+  for( uint32_t i = 0; i < size; ++i ) {
+    *fields[i + 4 - size] = row->masks[i] ? 0 : values[i];
+  }
+  CHECK( ds3231_alarm_decode( &image, &decoded ) == EMBEDD_RESULT_OK );
+  CHECK( memcmp( &decoded, &expected, sizeof(decoded) ) == 0 );
+
+  // DY/DT is not looked at while the day/date is masked
+  if( row->dydt == X ) {
+    image.regs[size - 1] |= DYDT;
+    CHECK( ds3231_alarm_decode( &image, &decoded ) == EMBEDD_RESULT_OK );
+    CHECK( decoded.mode == row->mode );
+  }
+}
+
+/*!
+ * \brief Compiles every valid value of the fields matched by the row.
+ */
+static uint32_t check_row(const alarm_row_t *row)
+{
+  uint8_t size = ( row->alarm == DS3231_ALARM_1 ) ? 4 : 3;
+  // matched fields in the layout of Alarm 1, the seconds of Alarm 2 are never matched
+  bool matched[4] = { false };
+  for( uint32_t i = 0; i < size; ++i ) {
+    matched[i + 4 - size] = !row->masks[i];
+  }
+  uint8_t days = ( row->dydt == 1 ) ? 7 : 31;
+  uint32_t count = 0;
+
+  for( uint32_t s = matched[0] ? 0 : UNUSED; s <= ( matched[0] ? 59 : UNUSED ); ++s ) {
+    for( uint32_t m = matched[1] ? 0 : UNUSED; m <= ( matched[1] ? 59 : UNUSED ); ++m ) {
+      for( uint32_t h = matched[2] ? 0 : UNUSED; h <= ( matched[2] ? 23 : UNUSED ); ++h ) {
+        for( uint32_t d = matched[3] ? 1 : UNUSED; d <= ( matched[3] ? days : UNUSED ); ++d ) {
+          ds3231_alarm_spec_t spec = { .mode = row->mode, .day_date = d, .hour = h, .minutes = m, .seconds = s };
+          uint8_t all[4] = { s, m, h, d };
+          check_spec( row, &spec, &all[4 - size] );
+          ++ count;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+static void test_table(void)
+{
+  static const uint32_t counts[] = { 1, 60, 3600, 86400, 86400 * 31, 86400 * 7, 1, 60, 1440, 1440 * 31, 1440 * 7 };
+
+  for( uint32_t i = 0; i < CountOfArray(alarm_table); ++i ) {
+    CHECK( check_row( &alarm_table[i] ) == counts[i] );
+  }
+}
+
+static void test_invalid(void)
+{
+  ds3231_alarm_image_t image;
+
+  // every mode of each alarm is in the table or rejected
+  for( uint32_t alarm = DS3231_ALARM_1; alarm <= DS3231_ALARM_2; ++alarm ) {
+    for( uint32_t mode = DS3231_ALARM_MODE_EVERY_SECOND; mode <= DS3231_ALARM_MODE_DATE; ++mode ) {
+      ds3231_alarm_spec_t spec = { .mode = mode, .day_date = 1 };
+      bool supported = find_row( alarm, mode ) != NULL;
+      CHECK( ( ds3231_alarm_compile( alarm, &spec, &image ) == EMBEDD_RESULT_OK ) == supported );
+    }
+  }
+  ds3231_alarm_spec_t spec = { .mode = DS3231_ALARM_MODE_EVERY_SECOND };
+  CHECK( ds3231_alarm_compile( DS3231_ALARM_2, &spec, &image ) == EMBEDD_RESULT_ERR );
+  spec.mode = DS3231_ALARM_MODE_AT_SECONDS;
+  CHECK( ds3231_alarm_compile( DS3231_ALARM_2, &spec, &image ) == EMBEDD_RESULT_ERR );
+  spec.mode = DS3231_ALARM_MODE_EVERY_MINUTE;
+  CHECK( ds3231_alarm_compile( DS3231_ALARM_1, &spec, &image ) == EMBEDD_RESULT_ERR );
+  spec.mode = DS3231_ALARM_MODE_DATE + 1;
+  CHECK( ds3231_alarm_compile( DS3231_ALARM_1, &spec, &image ) == EMBEDD_RESULT_ERR );
+  spec.mode = DS3231_ALARM_MODE_DAILY;
+  CHECK( ds3231_alarm_compile( DS3231_ALARM_2 + 1, &spec, &image ) == EMBEDD_RESULT_ERR );
+
+  // matched fields out of their range
+  static const ds3231_alarm_spec_t out_of_range[] = {
+    { DS3231_ALARM_MODE_DATE, 1, 0, 0, 60 },
+    { DS3231_ALARM_MODE_DATE, 1, 0, 60, 0 },
+    { DS3231_ALARM_MODE_DATE, 1, 24, 0, 0 },
+    { DS3231_ALARM_MODE_DATE, 0, 0, 0, 0 },
+    { DS3231_ALARM_MODE_DATE, 32, 0, 0, 0 },
+    { DS3231_ALARM_MODE_WEEKDAY, 0, 0, 0, 0 },
+    { DS3231_ALARM_MODE_WEEKDAY, 8, 0, 0, 0 },
+  };
+  for( uint32_t i = 0; i < CountOfArray(out_of_range); ++i ) {
+    CHECK( ds3231_alarm_compile( DS3231_ALARM_1, &out_of_range[i], &image ) == EMBEDD_RESULT_ERR );
+    bool seconds_only = ( out_of_range[i].seconds != 0 );
+    CHECK( ( ds3231_alarm_compile( DS3231_ALARM_2, &out_of_range[i], &image ) == EMBEDD_RESULT_OK ) == seconds_only );
+  }
+}
+
+static void test_decode(void)
+{
+  ds3231_alarm_image_t image = { .alarm = DS3231_ALARM_1, .size = 4 };
+  ds3231_alarm_spec_t spec;
+
+  // every combination of the mask bits and DY/DT decodes exactly when it is a row of the table
+  for( uint32_t alarm = DS3231_ALARM_1; alarm <= DS3231_ALARM_2; ++alarm ) {
+    uint8_t size = ( alarm == DS3231_ALARM_1 ) ? 4 : 3;
+    for( uint32_t bits = 0; bits < ( 1U << ( size + 1 ) ); ++bits ) {
+      image = (ds3231_alarm_image_t){ .alarm = alarm, .size = size, .regs = { 0x01, 0x01, 0x01, 0x01 } };
+      for( uint32_t i = 0; i < size; ++i ) {
+        image.regs[i] |= ( bits & ( 1U << i ) ) ? MASK : 0;
+      }
+      uint8_t dydt = ( bits >> size ) & 1U;
+      image.regs[size - 1] |= dydt ? DYDT : 0;
+      bool expected = false;
+      for( uint32_t r = 0; r < CountOfArray(alarm_table); ++r ) {
+        const alarm_row_t *row = &alarm_table[r];
+        bool same = ( row->alarm == alarm ) && ( row->dydt == X || row->dydt == dydt );
+        for( uint32_t i = 0; same && i < size; ++i ) {
+          same = ( row->masks[i] == ( ( bits >> i ) & 1U ) );
+        }
+        expected |= same;
+      }
+      CHECK( ( ds3231_alarm_decode( &image, &spec ) == EMBEDD_RESULT_OK ) == expected );
+    }
+  }
+
+  // 12-hour format, 12 AM is 0 and 12 PM is 12
+  static const struct { uint8_t reg; uint8_t hour; } hours12[] = {
+    { 0x52, 0 }, { 0x41, 1 }, { 0x51, 11 }, { 0x72, 12 }, { 0x61, 13 }, { 0x71, 23 },
+  };
+  for( uint32_t i = 0; i < CountOfArray(hours12); ++i ) {
+    image = (ds3231_alarm_image_t){ .alarm = DS3231_ALARM_1, .size = 4, .regs = { 0x00, 0x00, hours12[i].reg, MASK } };
+    CHECK( ds3231_alarm_decode( &image, &spec ) == EMBEDD_RESULT_OK );
+    CHECK( spec.mode == DS3231_ALARM_MODE_DAILY && spec.hour == hours12[i].hour );
+  }
+
+  // fields that are not valid BCD or out of their range
+  static const uint8_t bad[][4] = {
+    { 0x5A, 0x00, 0x00, 0x01 }, { 0x60, 0x00, 0x00, 0x01 }, { 0x00, 0x60, 0x00, 0x01 },
+    { 0x00, 0x00, 0x24, 0x01 }, { 0x00, 0x00, 0x40 | 0x13, 0x01 }, { 0x00, 0x00, 0x40, 0x01 },
+    { 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00, 0x32 }, { 0x00, 0x00, 0x00, DYDT | 0x08 },
+  };
+  for( uint32_t i = 0; i < CountOfArray(bad); ++i ) {
+    image = (ds3231_alarm_image_t){ .alarm = DS3231_ALARM_1, .size = 4 };
+    memcpy( image.regs, bad[i], sizeof(bad[i]) );
+    CHECK( ds3231_alarm_decode( &image, &spec ) == EMBEDD_RESULT_ERR );
+  }
+  image = (ds3231_alarm_image_t){ .alarm = DS3231_ALARM_2, .size = 4 };
+  CHECK( ds3231_alarm_decode( &image, &spec ) == EMBEDD_RESULT_ERR );
+}
+
+int main(void)
+{
+  test_table();
+  test_invalid();
+  test_decode();
+  return TEST_RESULT();
+}
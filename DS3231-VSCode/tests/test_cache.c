@@ -0,0 +1,188 @@
+/*!
+ * \file test_cache.c
+ * \brief Host test of the shadow register cache
+ *
+ * Counts the transfers of the simulated device to check that reads of cached
+ * registers known to the shadow skip the bus, that volatile registers and
+ * ranges holding one always go to the bus, that bits cleared by the device
+ * are not cached as written, and that invalidated or failed accesses leave
+ * nothing behind.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include "ds3231.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+#define CONV    (DS3231_FIELD_MASK(ds3231_control, conv))
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+/*!
+ * \brief Reads a register and returns the count of bus transfers it took.
+ */
+static uint32_t read_transfers(uint32_t addr, uint8_t *value)
+{
+  uint32_t transfers = sim_ds3231.transfers;
+  CHECK( ds3231_read_reg( &clock_chip, addr, value, 1, 0 ) == EMBEDD_RESULT_OK );
+  return sim_ds3231.transfers - transfers;
+}
+
+/*!
+ * \brief Reads a range of registers and returns the count of bus transfers it took.
+ */
+static uint32_t read_range_transfers(uint32_t first_addr, uint32_t count, uint8_t *regs)
+{
+  uint32_t transfers = sim_ds3231.transfers;
+  CHECK( ds3231_read_regs( &clock_chip, first_addr, count, regs ) == EMBEDD_RESULT_OK );
+  return sim_ds3231.transfers - transfers;
+}
+
+static void setup(void)
+{
+  sim_ds3231_attach( &clock_chip );
+  ds3231_cache_invalidate( &clock_chip );
+  for( uint32_t i = 0; i < DS3231_REGISTER_MAP_SIZE; ++i ) {
+    sim_ds3231.regs[i] = (uint8_t)( 0x10 + i );
+  }
+}
+
+static void test_cached(void)
+{
+  ds3231_cache_stats_t stats;
+  uint8_t value = 0;
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+
+  setup();
+  CHECK( ds3231_cache_get_stats( &clock_chip, &stats ) == EMBEDD_RESULT_OK );
+  uint32_t hits = stats.hits, misses = stats.misses;
+
+  // the first read goes to the bus, the next ones are served by the shadow
+  CHECK( read_transfers( ds3231_aging_offset_read_reg_addr, &value ) == 1 && value == 0x20 );
+  sim_ds3231.regs[ds3231_aging_offset_read_reg_addr] = 0x55;
+  CHECK( read_transfers( ds3231_aging_offset_read_reg_addr, &value ) == 0 && value == 0x20 );
+  CHECK( ds3231_cache_get_stats( &clock_chip, &stats ) == EMBEDD_RESULT_OK );
+  CHECK( stats.hits == hits + 1 && stats.misses == misses + 1 );
+
+  // a written register is known without reading it
+  value = 0x33;
+  CHECK( ds3231_write_reg( &clock_chip, ds3231_alarm_2_hour_write_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( read_transfers( ds3231_alarm_2_hour_read_reg_addr, &value ) == 0 && value == 0x33 );
+
+  // a range of cached registers, served once all of them are known
+  CHECK( read_range_transfers( ds3231_alarm_1_seconds_read_reg_addr, 7, regs ) == 1 );
+  CHECK( regs[0] == 0x17 && regs[5] == 0x33 && regs[6] == 0x1d );
+  CHECK( read_range_transfers( ds3231_alarm_1_seconds_read_reg_addr, 7, regs ) == 0 );
+  CHECK( read_range_transfers( ds3231_alarm_1_hour_read_reg_addr, 2, regs ) == 0 && regs[0] == 0x19 );
+
+  // the part known is not enough, the whole range goes to the bus
+  CHECK( read_range_transfers( ds3231_alarm_2_daydate_read_reg_addr, 2, regs ) == 1 );
+  CHECK( read_transfers( ds3231_control_read_reg_addr, &value ) == 0 && value == 0x1e );
+}
+
+static void test_volatile(void)
+{
+  uint8_t value = 0;
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+
+  setup();
+  static const uint8_t volatile_addrs[] = {
+    ds3231_seconds_read_reg_addr, ds3231_year_read_reg_addr, ds3231_status_read_reg_addr,
+    ds3231_msb_of_temp_read_reg_addr, ds3231_lsb_of_temp_read_reg_addr,
+  };
+  for( uint32_t i = 0; i < CountOfArray(volatile_addrs); ++i ) {
+    uint8_t addr = volatile_addrs[i];
+    CHECK( read_transfers( addr, &value ) == 1 );
+    sim_ds3231.regs[addr] ^= 0xff;
+    CHECK( read_transfers( addr, &value ) == 1 && value == sim_ds3231.regs[addr] );
+    // written, still read from the device
+    CHECK( ds3231_write_reg( &clock_chip, addr, &value, 1, 0 ) == EMBEDD_RESULT_OK );
+    CHECK( read_transfers( addr, &value ) == 1 );
+  }
+
+  // the control register is cached, the control/status range is not
+  CHECK( read_transfers( ds3231_control_read_reg_addr, &value ) == 1 );
+  CHECK( read_transfers( ds3231_control_read_reg_addr, &value ) == 0 );
+  sim_ds3231.regs[ds3231_status_read_reg_addr] = 0x88;
+  CHECK( read_range_transfers( ds3231_control_read_reg_addr, 2, regs ) == 1 );
+  CHECK( regs[0] == 0x1e && regs[1] == 0x88 );
+  CHECK( read_range_transfers( ds3231_control_read_reg_addr, 2, regs ) == 1 );
+
+  // the temperature and the time are read every time
+  CHECK( read_range_transfers( ds3231_msb_of_temp_read_reg_addr, 2, regs ) == 1 );
+  CHECK( read_range_transfers( ds3231_msb_of_temp_read_reg_addr, 2, regs ) == 1 );
+  CHECK( read_range_transfers( ds3231_seconds_read_reg_addr, 7, regs ) == 1 );
+  CHECK( read_range_transfers( ds3231_seconds_read_reg_addr, 7, regs ) == 1 );
+}
+
+static void test_self_clearing(void)
+{
+  uint8_t value = 0x1c | CONV;
+
+  // CONV is cleared by the device, the shadow keeps the other bits as written
+  setup();
+  CHECK( ds3231_write_reg( &clock_chip, ds3231_control_write_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.regs[ds3231_control_read_reg_addr] == ( 0x1c | CONV ) );
+  CHECK( read_transfers( ds3231_control_read_reg_addr, &value ) == 0 && value == 0x1c );
+
+  // nor is it cached as read
+  ds3231_cache_invalidate( &clock_chip );
+  CHECK( read_transfers( ds3231_control_read_reg_addr, &value ) == 1 && value == ( 0x1c | CONV ) );
+  CHECK( read_transfers( ds3231_control_read_reg_addr, &value ) == 0 && value == 0x1c );
+}
+
+static void test_invalidate(void)
+{
+  uint8_t value = 0;
+
+  setup();
+  CHECK( read_transfers( ds3231_aging_offset_read_reg_addr, &value ) == 1 );
+  CHECK( read_transfers( ds3231_aging_offset_read_reg_addr, &value ) == 0 );
+  sim_ds3231.regs[ds3231_aging_offset_read_reg_addr] = 0x66;
+  CHECK( ds3231_cache_invalidate( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( read_transfers( ds3231_aging_offset_read_reg_addr, &value ) == 1 && value == 0x66 );
+  CHECK( read_transfers( ds3231_aging_offset_read_reg_addr, &value ) == 0 && value == 0x66 );
+  CHECK( ds3231_cache_invalidate( NULL ) == EMBEDD_RESULT_ERR );
+}
+
+static void test_failed_access(void)
+{
+  uint8_t value = 0x77;
+
+  // a failed read or write is not cached
+  setup();
+  sim_ds3231.result = EMBEDD_RESULT_ERR;
+  CHECK( ds3231_read_reg( &clock_chip, ds3231_aging_offset_read_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_ERR );
+  CHECK( ds3231_write_reg( &clock_chip, ds3231_alarm_1_hour_write_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_ERR );
+  sim_ds3231.result = EMBEDD_RESULT_OK;
+  CHECK( read_transfers( ds3231_aging_offset_read_reg_addr, &value ) == 1 && value == 0x20 );
+  CHECK( read_transfers( ds3231_alarm_1_hour_read_reg_addr, &value ) == 1 && value == 0x19 );
+}
+
+int main(void)
+{
+  test_cached();
+  test_volatile();
+  test_self_clearing();
+  test_invalidate();
+  test_failed_access();
+  return TEST_RESULT();
+}
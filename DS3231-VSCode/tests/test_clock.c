@@ -0,0 +1,274 @@
+/*!
+ * \file test_clock.c
+ * \brief Host test of the interpolated clock against a simulated device
+ *
+ * The simulated device keeps the reference time: its timekeeping registers
+ * are loaded at the start of each read from the simulated time, and every
+ * byte read on the bus takes an I2C byte time. The tick source is a
+ * 32.768 kHz output with a configurable drift, counted by a 16-bit timer
+ * extended to 32 bits in software, or the 1 kHz HAL tick. The tick counter
+ * starts close to its 32-bit wrap. The interpolated time is checked at every
+ * step against the reference, and the bus must be touched only by resyncs.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "ds3231.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+#define SIM_NS_PER_S          (1000000000ULL)
+#define SIM_BYTE_NS           (25000U)        // one byte at 400 kHz with its acknowledge
+#define SIM_START_EPOCH       (1735689595LL)  // 2024-12-31 23:59:55
+#define SIM_WRAP_S            (5U)            // the 32-bit tick counter wraps after 5 s
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+static ds3231_clock_t rtc_clock;
+
+// steps of the last run and largest difference to the reference seen after it settled
+static uint32_t run_steps;
+static uint64_t run_worst_us;
+
+// simulated time and tick source
+static uint64_t sim_ns;
+static uint32_t sim_hz;
+static int32_t sim_drift_ppb;
+static bool sim_timer16;
+static uint32_t sim_tick_offset;
+static uint32_t sim_ticks_ext;
+static uint32_t sim_last_transfer;
+
+/*!
+ * \brief Returns the reference time in us.
+ */
+static uint64_t sim_now_us(void)
+{
+  return (uint64_t)SIM_START_EPOCH * 1000000U + sim_ns / 1000U;
+}
+
+/*!
+ * \brief Returns the ticks counted by the source since the start, with its drift.
+ */
+static uint64_t sim_source_ticks(void)
+{
+  unsigned __int128 scaled = (unsigned __int128)sim_ns * sim_hz * (uint64_t)( (int64_t)SIM_NS_PER_S + sim_drift_ppb );
+  return (uint64_t)( scaled / ( (unsigned __int128)SIM_NS_PER_S * SIM_NS_PER_S ) );
+}
+
+/*!
+ * \brief Tick counter given to the clock.
+ *
+ * The 16-bit timer is extended by the difference to the previous read, as
+ * done on a target without a 32-bit timer, so it must be read at least once
+ * per 65536 ticks.
+ */
+static uint32_t sim_get_ticks(void)
+{
+  uint32_t count = (uint32_t)sim_source_ticks() + sim_tick_offset;
+  if( !sim_timer16 ) {
+    return count;
+  }
+  uint16_t hw = (uint16_t)count;
+  sim_ticks_ext += (uint16_t)( hw - (uint16_t)sim_ticks_ext );
+  return sim_ticks_ext;
+}
+
+/*!
+ * \brief Loads the timekeeping registers at the start of a read, then lets a byte time pass.
+ */
+static void sim_on_read(uint8_t addr)
+{
+  if( sim_ds3231.transfers != sim_last_transfer ) {
+    sim_last_transfer = sim_ds3231.transfers;
+    ds3231_datetime_t datetime;
+    ds3231_time_regs_t regs;
+    ds3231_epoch_to_datetime( SIM_START_EPOCH + (int64_t)( sim_ns / SIM_NS_PER_S ), &datetime );
+    ds3231_datetime_to_regs( &datetime, &regs );
+    memcpy( sim_ds3231.regs, &regs, sizeof(regs) );
+  }
+  sim_ns += SIM_BYTE_NS;
+}
+
+static void sim_setup(uint32_t hz, int32_t drift_ppb, bool timer16)
+{
+  sim_ds3231_attach( &clock_chip );
+  sim_ds3231.on_read = sim_on_read;
+  // starts 0.4 s into a second
+  sim_ns = 400000000ULL;
+  sim_hz = hz;
+  sim_drift_ppb = drift_ppb;
+  sim_timer16 = timer16;
+  sim_last_transfer = 0;
+  sim_tick_offset = 0U - SIM_WRAP_S * hz;
+  sim_ticks_ext = sim_tick_offset + (uint32_t)sim_source_ticks();
+}
+
+/*!
+ * \brief Runs the clock for \a duration_ns in steps of \a step_ns, checking the interpolation at each step.
+ *
+ * The difference to the reference is checked against \a bound_us after \a settle_ns.
+ */
+static void run(uint64_t duration_ns, uint64_t step_ns, uint64_t settle_ns, uint64_t bound_us)
+{
+  uint64_t end = sim_ns + duration_ns;
+  uint64_t settle = sim_ns + settle_ns;
+  bool wrapped = false;
+  uint32_t prev_tick = sim_get_ticks();
+  run_steps = 0;
+  run_worst_us = 0;
+
+  while( sim_ns < end ) {
+    sim_ns += step_ns;
+    ++ run_steps;
+    uint32_t tick = sim_get_ticks();
+    wrapped |= ( tick < prev_tick );
+    prev_tick = tick;
+    CHECK( ds3231_clock_process( &rtc_clock ) == EMBEDD_RESULT_OK );
+
+    // the bus is not touched to answer the time
+    uint32_t transfers = sim_ds3231.transfers;
+    uint64_t reference = sim_now_us();
+    uint64_t now = ds3231_clock_now_us( &rtc_clock );
+    int64_t epoch;
+    ds3231_datetime_t datetime, expected;
+    CHECK( ds3231_clock_get_epoch( &rtc_clock, &epoch ) == EMBEDD_RESULT_OK );
+    CHECK( ds3231_clock_get_time( &rtc_clock, &datetime ) == EMBEDD_RESULT_OK );
+    CHECK( sim_ds3231.transfers == transfers );
+
+    CHECK( epoch == (int64_t)( now / 1000000U ) );
+    CHECK( ds3231_epoch_to_datetime( epoch, &expected ) == EMBEDD_RESULT_OK );
+    CHECK( memcmp( &datetime, &expected, sizeof(datetime) ) == 0 );
+    if( sim_ns >= settle ) {
+      uint64_t error = ( now > reference ) ? now - reference : reference - now;
+      run_worst_us = ( error > run_worst_us ) ? error : run_worst_us;
+    }
+  }
+  CHECK( wrapped );
+  CHECK( run_worst_us <= bound_us );
+}
+
+/*!
+ * \brief 32.768 kHz counted by a 16-bit timer, no drift.
+ */
+static void test_timer16(void)
+{
+  ds3231_clock_stats_t stats;
+  sim_setup( 32768U, 0, true );
+  CHECK( ds3231_clock_init( &rtc_clock, &clock_chip, sim_get_ticks, 32768U ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_clock_set_resync( &rtc_clock, 30U, 0U ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_clock_now_us( &rtc_clock ) == 0 );
+  CHECK( ds3231_clock_latch( &rtc_clock ) == EMBEDD_RESULT_OK );
+
+  // a resync latch is off by a step, a register read and a tick at most
+  run( 120 * SIM_NS_PER_S, 100000U, 0, 100U + 25U + 31U );
+  CHECK( ds3231_clock_get_stats( &rtc_clock, &stats ) == EMBEDD_RESULT_OK );
+  // every 30 s from the previous latch, which waits for a second boundary
+  CHECK( stats.resyncs == 3 && stats.errors == 0 );
+  CHECK( stats.max_divergence_us <= 100U + 25U + 31U );
+  CHECK( stats.reads_avoided == 3 * run_steps );
+}
+
+/*!
+ * \brief 32.768 kHz running 50 ppm fast, the resyncs keep the error within the tolerated one.
+ */
+static void test_drift(void)
+{
+  ds3231_clock_stats_t stats;
+  sim_setup( 32768U, 50000, true );
+  CHECK( ds3231_clock_init( &rtc_clock, &clock_chip, sim_get_ticks, 32768U ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_clock_set_resync( &rtc_clock, 60U, 1000U ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_clock_latch( &rtc_clock ) == EMBEDD_RESULT_OK );
+
+  // the drift is unknown until the first resync, 3 ms accumulate meanwhile
+  run( 300 * SIM_NS_PER_S, 100000U, 61 * SIM_NS_PER_S, 1000U + 100U + 25U + 31U );
+  CHECK( ds3231_clock_get_stats( &rtc_clock, &stats ) == EMBEDD_RESULT_OK );
+  CHECK( stats.drift_ppb > 40000 && stats.drift_ppb < 60000 );
+  CHECK( stats.max_divergence_us >= 2800U && stats.max_divergence_us <= 3200U );
+  // every 20 s after the first
+  CHECK( stats.resyncs >= 12 && stats.errors == 0 );
+}
+
+/*!
+ * \brief 1 kHz HAL tick on a 32-bit counter.
+ */
+static void test_hal_tick(void)
+{
+  ds3231_clock_stats_t stats;
+  sim_setup( 1000U, 0, false );
+  CHECK( ds3231_clock_init( &rtc_clock, &clock_chip, sim_get_ticks, 1000U ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_clock_set_resync( &rtc_clock, 20U, 0U ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_clock_latch( &rtc_clock ) == EMBEDD_RESULT_OK );
+
+  run( 60 * SIM_NS_PER_S, 250000U, 0, 250U + 25U + 1000U );
+  CHECK( ds3231_clock_get_stats( &rtc_clock, &stats ) == EMBEDD_RESULT_OK );
+  // every 20 s from the previous latch, the period may end on the boundary itself
+  CHECK( stats.resyncs >= 2 && stats.resyncs <= 3 && stats.errors == 0 );
+}
+
+/*!
+ * \brief Whole seconds of the elapsed ticks for frequencies across the supported range.
+ */
+static void test_ticks_to_seconds(void)
+{
+  static const uint32_t frequencies[] = {
+    DS3231_CLOCK_TICK_HZ_MIN, 1000U, 32768U, 48000U, 1000000U, 64000000U, 0x7FFFFFFFU, DS3231_CLOCK_TICK_HZ_MAX,
+  };
+  int64_t epoch;
+
+  sim_setup( 32768U, 0, false );
+  sim_tick_offset = 0;
+  for( uint32_t i = 0; i < CountOfArray(frequencies); ++i ) {
+    uint32_t hz = frequencies[i];
+    CHECK( ds3231_clock_init( &rtc_clock, &clock_chip, sim_get_ticks, hz ) == EMBEDD_RESULT_OK );
+    CHECK( ds3231_clock_set( &rtc_clock, SIM_START_EPOCH, 0 ) == EMBEDD_RESULT_OK );
+    // both sides of every whole second up to the end of the counter range
+    for( uint64_t second = 0; second * hz <= UINT32_MAX; second += 1 + second / 64 ) {
+      uint64_t boundary = second * hz;
+      for( int32_t delta = -2; delta <= 2; ++delta ) {
+        int64_t elapsed = (int64_t)boundary + delta;
+        if( elapsed < 0 || elapsed > UINT32_MAX ) {
+          continue;
+        }
+        sim_hz = hz;
+        sim_ns = 0;
+        sim_tick_offset = (uint32_t)elapsed;
+        CHECK( ds3231_clock_get_epoch( &rtc_clock, &epoch ) == EMBEDD_RESULT_OK );
+        CHECK( epoch == SIM_START_EPOCH + elapsed / hz );
+      }
+    }
+    sim_tick_offset = UINT32_MAX;
+    CHECK( ds3231_clock_get_epoch( &rtc_clock, &epoch ) == EMBEDD_RESULT_OK );
+    CHECK( epoch == SIM_START_EPOCH + UINT32_MAX / hz );
+  }
+  CHECK( ds3231_clock_init( &rtc_clock, &clock_chip, sim_get_ticks, DS3231_CLOCK_TICK_HZ_MIN - 1 ) == EMBEDD_RESULT_ERR );
+  CHECK( ds3231_clock_init( &rtc_clock, &clock_chip, sim_get_ticks, DS3231_CLOCK_TICK_HZ_MAX + 1 ) == EMBEDD_RESULT_ERR );
+}
+
+int main(void)
+{
+  test_ticks_to_seconds();
+  test_timer16();
+  test_drift();
+  test_hal_tick();
+  return TEST_RESULT();
+}
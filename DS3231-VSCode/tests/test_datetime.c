@@ -0,0 +1,163 @@
+/*!
+ * \file test_datetime.c
+ * \brief Host test of the date and time codec against libc
+ *
+ * Walks every day of the chip's range, 2000-01-01 to 2199-12-31, and for
+ * each date 0 - 32 of every month checks that ds3231_datetime_to_epoch()
+ * accepts exactly the dates timegm() keeps in place and returns the same
+ * seconds. Every day is converted back with ds3231_epoch_to_datetime() and
+ * compared with gmtime_r(), weekday included, and through the timekeeping
+ * registers to check the century bit. Every second of the first and last
+ * days is checked, as are the bounds of the epoch range.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <time.h>
+
+#include "ds3231_datetime.h"
+#include "ds3231_fields.h"
+#include "test_util.h"
+
+#define TEST_SECONDS_PER_DAY  (86400LL)
+
+/*!
+ * \brief Returns the timegm() seconds of the date, 0 - 23 rolling over into the next month.
+ */
+static int64_t test_timegm(uint32_t year, uint32_t month, uint32_t date, uint32_t seconds, struct tm *tm)
+{
+  *tm = (struct tm){
+    .tm_year = (int)year - 1900,
+    .tm_mon = (int)month - 1,
+    .tm_mday = (int)date,
+    .tm_sec = (int)seconds,
+  };
+  return (int64_t)timegm( tm );
+}
+
+/*!
+ * \brief Checks the conversion of \a epoch against gmtime_r().
+ */
+static void test_epoch(int64_t epoch)
+{
+  ds3231_datetime_t datetime;
+  struct tm tm;
+  time_t t = (time_t)epoch;
+
+  CHECK( ds3231_epoch_to_datetime( epoch, &datetime ) == EMBEDD_RESULT_OK );
+  CHECK( gmtime_r( &t, &tm ) != NULL );
+  CHECK( datetime.year == tm.tm_year + 1900 );
+  CHECK( datetime.month == tm.tm_mon + 1 );
+  CHECK( datetime.date == tm.tm_mday );
+  // day 1 is Monday
+  CHECK( datetime.day == ( tm.tm_wday + 6 ) % 7 + 1 );
+  CHECK( datetime.hour == tm.tm_hour );
+  CHECK( datetime.minutes == tm.tm_min );
+  CHECK( datetime.seconds == tm.tm_sec );
+
+  int64_t back;
+  CHECK( ds3231_datetime_to_epoch( &datetime, &back ) == EMBEDD_RESULT_OK );
+  CHECK( back == epoch );
+}
+
+/*!
+ * \brief Checks the validation and conversion of every date 0 - 32 of every month.
+ */
+static void test_dates(void)
+{
+  uint32_t days = 0;
+
+  for( uint32_t year = DS3231_DATETIME_YEAR_MIN; year <= DS3231_DATETIME_YEAR_MAX; ++year ) {
+    for( uint32_t month = 1; month <= 12; ++month ) {
+      for( uint32_t date = 0; date <= 32; ++date ) {
+        struct tm tm;
+        int64_t expected = test_timegm( year, month, date, 0, &tm );
+        bool valid = ( tm.tm_mon == (int)month - 1 ) && ( tm.tm_mday == (int)date );
+
+        ds3231_datetime_t datetime = { .year = year, .month = month, .date = date, .day = 1 };
+        int64_t epoch = -1;
+        EMBEDD_RESULT result = ds3231_datetime_to_epoch( &datetime, &epoch );
+        if( !valid ) {
+          CHECK( result == EMBEDD_RESULT_ERR );
+          continue;
+        }
+        CHECK( result == EMBEDD_RESULT_OK );
+        CHECK( epoch == expected );
+        ++days;
+
+        // a time of day varying with the date
+        test_epoch( epoch + ( epoch * 7919 ) % TEST_SECONDS_PER_DAY );
+
+        ds3231_time_regs_t regs;
+        ds3231_datetime_t decoded;
+        CHECK( ds3231_datetime_to_regs( &datetime, &regs ) == EMBEDD_RESULT_OK );
+        CHECK( ( regs.monthcentury.century != 0 ) == ( year >= 2100 ) );
+        CHECK( ds3231_datetime_from_regs( &regs, &decoded ) == EMBEDD_RESULT_OK );
+        CHECK( decoded.year == year && decoded.month == month && decoded.date == date );
+      }
+    }
+  }
+  // 200 years, 49 of them leap
+  CHECK( days == 200 * 365 + 49 );
+}
+
+/*!
+ * \brief Checks every second of the first and last days and the bounds of the range.
+ */
+static void test_bounds(void)
+{
+  for( int64_t second = 0; second < TEST_SECONDS_PER_DAY; ++second ) {
+    test_epoch( DS3231_EPOCH_MIN + second );
+    test_epoch( DS3231_EPOCH_MAX - second );
+  }
+
+  ds3231_datetime_t datetime;
+  CHECK( ds3231_epoch_to_datetime( DS3231_EPOCH_MIN - 1, &datetime ) == EMBEDD_RESULT_ERR );
+  CHECK( ds3231_epoch_to_datetime( DS3231_EPOCH_MAX + 1, &datetime ) == EMBEDD_RESULT_ERR );
+
+  int64_t epoch;
+  datetime = (ds3231_datetime_t){ .year = 1999, .month = 12, .date = 31, .day = 1 };
+  CHECK( ds3231_datetime_to_epoch( &datetime, &epoch ) == EMBEDD_RESULT_ERR );
+  datetime = (ds3231_datetime_t){ .year = 2200, .month = 1, .date = 1, .day = 1 };
+  CHECK( ds3231_datetime_to_epoch( &datetime, &epoch ) == EMBEDD_RESULT_ERR );
+  datetime = (ds3231_datetime_t){ .year = 2024, .month = 2, .date = 29, .day = 8 };
+  CHECK( ds3231_datetime_to_epoch( &datetime, &epoch ) == EMBEDD_RESULT_ERR );
+  datetime.day = 4;
+  datetime.hour = 24;
+  CHECK( ds3231_datetime_to_epoch( &datetime, &epoch ) == EMBEDD_RESULT_ERR );
+  datetime.hour = 23;
+  datetime.minutes = 60;
+  CHECK( ds3231_datetime_to_epoch( &datetime, &epoch ) == EMBEDD_RESULT_ERR );
+  datetime.minutes = 59;
+  datetime.seconds = 60;
+  CHECK( ds3231_datetime_to_epoch( &datetime, &epoch ) == EMBEDD_RESULT_ERR );
+  datetime.seconds = 59;
+  CHECK( ds3231_datetime_to_epoch( &datetime, &epoch ) == EMBEDD_RESULT_OK );
+}
+
+int main(void)
+{
+  test_dates();
+  test_bounds();
+  return TEST_RESULT();
+}
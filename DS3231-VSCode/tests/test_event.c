@@ -0,0 +1,277 @@
+/*!
+ * \file test_event.c
+ * \brief Host test of the event queue overflow policies, coalescing and counters
+ *
+ * Each case fills the queue, overflows it under one policy and checks the
+ * events dispatched, their order and the health counters, in a single
+ * thread so that the outcome is exact.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <stdbool.h>
+
+#include "embedd_event.h"
+#include "embedd_misc.h"
+#include "event_manager_cfg.h"
+#include "test_util.h"
+
+#define QUEUE_SIZE      (EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT)
+#define EVENT_A         (0x101)
+#define EVENT_B         (0x102)
+
+/*!
+ * \struct dispatched_t
+ * \brief Event seen by the callback
+ */
+typedef struct {
+  int event_id;
+  uintptr_t device;
+  uint32_t count;
+} dispatched_t;
+
+static dispatched_t dispatched[4 * QUEUE_SIZE];
+static uint32_t dispatched_count;
+
+static void on_event(struct EventSource *ev)
+{
+  if( dispatched_count < CountOfArray(dispatched) ) {
+    dispatched[dispatched_count] = (dispatched_t){ ev->event_id, (uintptr_t)ev->device, ev->count };
+  }
+  ++ dispatched_count;
+}
+
+static EMBEDD_RESULT trigger(int event_id, uintptr_t device)
+{
+  return embedd_event_manager_trigger( event_id, (void*)device );
+}
+
+/*!
+ * \brief Tells whether the event \a index dispatched is \a event_id of \a device merged from \a count triggers.
+ */
+static bool dispatched_is(uint32_t index, int event_id, uintptr_t device, uint32_t count)
+{
+  return ( index < dispatched_count ) && ( dispatched[index].event_id == event_id ) &&
+         ( dispatched[index].device == device ) && ( dispatched[index].count == count );
+}
+
+/*!
+ * \brief Returns the counters of the queue.
+ */
+static embedd_event_stats_t stats(void)
+{
+  embedd_event_stats_t s;
+  CHECK( embedd_event_manager_get_stats( &s ) == EMBEDD_RESULT_OK );
+  return s;
+}
+
+static void setup(embedd_event_overflow_t policy)
+{
+  embedd_event_manager_init();
+  CHECK( embedd_event_manager_set_overflow_policy( policy ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_register_callback( EVENT_A, on_event ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_register_callback( EVENT_B, on_event ) == EMBEDD_RESULT_OK );
+  dispatched_count = 0;
+}
+
+/*!
+ * \brief Fills the queue with EVENT_A of the devices 1 to QUEUE_SIZE.
+ */
+static void fill(void)
+{
+  for( uintptr_t device = 1; device <= QUEUE_SIZE; ++device ) {
+    CHECK( trigger( EVENT_A, device ) == EMBEDD_RESULT_OK );
+  }
+  CHECK( stats().high_water == QUEUE_SIZE );
+}
+
+static void test_reject(void)
+{
+  setup( EMBEDD_EVENT_OVERFLOW_REJECT );
+  fill();
+  CHECK( trigger( EVENT_A, QUEUE_SIZE + 1 ) == EMBEDD_RESULT_ERR );
+  CHECK( trigger( EVENT_B, 1 ) == EMBEDD_RESULT_ERR );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == QUEUE_SIZE );
+  for( uint32_t i = 0; i < QUEUE_SIZE; ++i ) {
+    CHECK( dispatched_is( i, EVENT_A, i + 1, 1 ) );
+  }
+  embedd_event_stats_t s = stats();
+  CHECK( s.enqueued == QUEUE_SIZE && s.dispatched == QUEUE_SIZE && s.dropped == 2 && s.coalesced == 0 && s.high_water == QUEUE_SIZE );
+
+  // there is room again once processed
+  CHECK( trigger( EVENT_B, 1 ) == EMBEDD_RESULT_OK );
+}
+
+static void test_drop_newest(void)
+{
+  setup( EMBEDD_EVENT_OVERFLOW_DROP_NEWEST );
+  fill();
+  // the trigger succeeds, the new events are lost
+  CHECK( trigger( EVENT_A, QUEUE_SIZE + 1 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_B, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == QUEUE_SIZE );
+  for( uint32_t i = 0; i < QUEUE_SIZE; ++i ) {
+    CHECK( dispatched_is( i, EVENT_A, i + 1, 1 ) );
+  }
+  embedd_event_stats_t s = stats();
+  CHECK( s.enqueued == QUEUE_SIZE && s.dispatched == QUEUE_SIZE && s.dropped == 2 && s.coalesced == 0 && s.high_water == QUEUE_SIZE );
+}
+
+static void test_drop_oldest(void)
+{
+  setup( EMBEDD_EVENT_OVERFLOW_DROP_OLDEST );
+  fill();
+  // the two oldest events make room for the new ones, which come last
+  CHECK( trigger( EVENT_A, QUEUE_SIZE + 1 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_B, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == QUEUE_SIZE );
+  for( uint32_t i = 0; i < QUEUE_SIZE - 1; ++i ) {
+    CHECK( dispatched_is( i, EVENT_A, i + 3, 1 ) );
+  }
+  CHECK( dispatched_is( QUEUE_SIZE - 1, EVENT_B, 1, 1 ) );
+  embedd_event_stats_t s = stats();
+  CHECK( s.enqueued == QUEUE_SIZE + 2 && s.dispatched == QUEUE_SIZE && s.dropped == 2 && s.coalesced == 0 && s.high_water == QUEUE_SIZE );
+}
+
+static void test_coalesce(void)
+{
+  setup( EMBEDD_EVENT_OVERFLOW_COALESCE );
+  // below the overflow every trigger is queued on its own
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == 2 && dispatched_is( 0, EVENT_A, 1, 1 ) && dispatched_is( 1, EVENT_A, 1, 1 ) );
+
+  // on overflow an event is merged into the queued one of the same id and device, or rejected
+  dispatched_count = 0;
+  fill();
+  CHECK( trigger( EVENT_A, 3 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_A, 3 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_A, QUEUE_SIZE ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_B, 3 ) == EMBEDD_RESULT_ERR );
+  CHECK( trigger( EVENT_A, QUEUE_SIZE + 1 ) == EMBEDD_RESULT_ERR );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == QUEUE_SIZE );
+  for( uint32_t i = 0; i < QUEUE_SIZE; ++i ) {
+    uint32_t count = ( i == 2 ) ? 3 : ( i == QUEUE_SIZE - 1 ) ? 2 : 1;
+    CHECK( dispatched_is( i, EVENT_A, i + 1, count ) );
+  }
+  embedd_event_stats_t s = stats();
+  CHECK( s.enqueued == QUEUE_SIZE + 2 && s.dispatched == QUEUE_SIZE + 2 && s.dropped == 2 && s.coalesced == 3 && s.high_water == QUEUE_SIZE );
+}
+
+static void test_counters(void)
+{
+  setup( EMBEDD_EVENT_OVERFLOW_REJECT );
+  // the high-water mark keeps the largest fill
+  for( uintptr_t device = 1; device <= 3; ++device ) {
+    CHECK( trigger( EVENT_A, device ) == EMBEDD_RESULT_OK );
+  }
+  CHECK( embedd_event_manager_process_budget( 2, 0 ) == 1 );
+  CHECK( trigger( EVENT_B, 4 ) == EMBEDD_RESULT_OK );
+  embedd_event_stats_t s = stats();
+  CHECK( s.enqueued == 4 && s.dispatched == 2 && s.dropped == 0 && s.high_water == 3 );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == 4 && dispatched_is( 2, EVENT_A, 3, 1 ) && dispatched_is( 3, EVENT_B, 4, 1 ) );
+
+  // not registered ids are not counted, init clears the counters
+  CHECK( trigger( 0x1ff, 1 ) == EMBEDD_RESULT_ERR );
+  CHECK( trigger( VOID_EVENT_ID, 1 ) == EMBEDD_RESULT_ERR );
+  s = stats();
+  CHECK( s.enqueued == 4 && s.dropped == 0 );
+  embedd_event_manager_init();
+  s = stats();
+  CHECK( s.enqueued == 0 && s.dispatched == 0 && s.dropped == 0 && s.coalesced == 0 && s.high_water == 0 );
+  CHECK( embedd_event_manager_set_overflow_policy( EMBEDD_EVENT_OVERFLOW_COALESCE + 1 ) == EMBEDD_RESULT_ERR );
+}
+
+static void test_coalescing_option(void)
+{
+  setup( EMBEDD_EVENT_OVERFLOW_REJECT );
+  CHECK( embedd_event_manager_set_coalescing( 0x1ff, 1 ) == EMBEDD_RESULT_ERR );
+  CHECK( embedd_event_manager_set_coalescing( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+
+  // repeated triggers of the opted-in id are dispatched once with their count,
+  // other devices and ids keep one event per trigger
+  for( int i = 0; i < 5; ++i ) {
+    CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+    CHECK( trigger( EVENT_B, 1 ) == EMBEDD_RESULT_OK );
+  }
+  CHECK( trigger( EVENT_A, 2 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == 7 );
+  CHECK( dispatched_is( 0, EVENT_A, 1, 6 ) );
+  for( uint32_t i = 1; i <= 5; ++i ) {
+    CHECK( dispatched_is( i, EVENT_B, 1, 1 ) );
+  }
+  CHECK( dispatched_is( 6, EVENT_A, 2, 1 ) );
+  embedd_event_stats_t s = stats();
+  CHECK( s.enqueued == 7 && s.dispatched == 7 && s.coalesced == 5 && s.dropped == 0 && s.high_water == 7 );
+
+  // the count starts again once the event is dispatched
+  dispatched_count = 0;
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == 2 && dispatched_is( 0, EVENT_A, 1, 2 ) && dispatched_is( 1, EVENT_A, 1, 1 ) );
+
+  // a full queue still takes the triggers of a queued event
+  dispatched_count = 0;
+  fill();
+  CHECK( trigger( EVENT_A, 4 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_B, 4 ) == EMBEDD_RESULT_ERR );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == QUEUE_SIZE && dispatched_is( 3, EVENT_A, 4, 2 ) );
+
+  // disabled, each trigger is queued again
+  dispatched_count = 0;
+  CHECK( embedd_event_manager_set_coalescing( EVENT_A, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_A, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == 2 && dispatched_is( 0, EVENT_A, 1, 1 ) && dispatched_is( 1, EVENT_A, 1, 1 ) );
+
+  // the option goes with the last callback of the id
+  dispatched_count = 0;
+  CHECK( embedd_event_manager_set_coalescing( EVENT_B, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_unregister_callback( EVENT_B, on_event ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_register_callback( EVENT_B, on_event ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_B, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( trigger( EVENT_B, 1 ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_process_budget( 0, 0 ) == 0 );
+  CHECK( dispatched_count == 2 && dispatched_is( 0, EVENT_B, 1, 1 ) && dispatched_is( 1, EVENT_B, 1, 1 ) );
+}
+
+int main(void)
+{
+  test_reject();
+  test_drop_newest();
+  test_drop_oldest();
+  test_coalesce();
+  test_counters();
+  test_coalescing_option();
+  return TEST_RESULT();
+}
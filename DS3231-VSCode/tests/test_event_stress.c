@@ -0,0 +1,226 @@
+/*!
+ * \file test_event_stress.c
+ * \brief Host stress test of the event queue with a producer and a consumer thread
+ *
+ * A producer thread triggers numbered events while the main thread processes
+ * them, the events must arrive in order and none may be lost or duplicated,
+ * with the lock-free queue and with the guarded drop oldest policy, the guard
+ * being a mutex here. The second test completes the asynchronous transfers of
+ * the device from a thread standing for the bus interrupt while the main
+ * thread triggers its own events, embedd_event_manager_trigger() is wrapped at
+ * link time to check that the queue keeps the main thread as single producer.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "ds3231.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+#define STRESS_EVENTS       (200000U)
+#define STRESS_TRANSFERS    (20000U)
+#define SEQ_EVENT_ID        (0x51)
+#define ASYNC_EVENT_ID      (0x52)
+#define MAIN_EVENT_ID       (0x53)
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+// thread expected to trigger the events, triggers from any other are counted
+static pthread_t producer;
+static uint32_t foreign_triggers;
+
+static pthread_mutex_t guard = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t stop;
+
+static uint32_t received;
+static uint32_t last_seq;
+static uint32_t out_of_order;
+static uint32_t completed;
+static uint32_t async_events;
+static uint32_t async_errors;
+
+EMBEDD_RESULT __real_embedd_event_manager_trigger(int event_id, void *device);
+
+EMBEDD_RESULT __wrap_embedd_event_manager_trigger(int event_id, void *device)
+{
+  if( !pthread_equal( pthread_self(), producer ) ) {
+    __atomic_add_fetch( &foreign_triggers, 1, __ATOMIC_RELAXED );
+  }
+  return __real_embedd_event_manager_trigger( event_id, device );
+}
+
+void engage_guard()
+{
+  pthread_mutex_lock( &guard );
+}
+
+void disengage_guard()
+{
+  pthread_mutex_unlock( &guard );
+}
+
+static void on_seq(struct EventSource *ev)
+{
+  uint32_t seq = (uint32_t)(uintptr_t)ev->device;
+  if( seq <= last_seq || ev->count != 1 ) {
+    ++ out_of_order;
+  }
+  last_seq = seq;
+  ++ received;
+}
+
+static void on_async(struct EventSource *ev)
+{
+  if( ev->device != &clock_chip || ds3231_async_result( &clock_chip ) != EMBEDD_RESULT_OK ) {
+    ++ async_errors;
+  }
+  ++ async_events;
+}
+
+/*!
+ * \brief Triggers the numbered events, retrying those rejected by a full queue.
+ */
+static void* produce(void *arg)
+{
+  producer = pthread_self();
+  for( uint32_t seq = 1; seq <= STRESS_EVENTS; ++seq ) {
+    while( embedd_event_manager_trigger( SEQ_EVENT_ID, (void*)(uintptr_t)seq ) != EMBEDD_RESULT_OK ) {
+      sched_yield();
+    }
+  }
+  __atomic_store_n( &stop, 1, __ATOMIC_RELEASE );
+  return NULL;
+}
+
+/*!
+ * \brief Completes the transfers started by the main thread, as the bus interrupt would.
+ */
+static void* interrupt(void *arg)
+{
+  while( !__atomic_load_n( &stop, __ATOMIC_ACQUIRE ) ) {
+    if( sim_ds3231_complete() ) {
+      __atomic_add_fetch( &completed, 1, __ATOMIC_RELAXED );
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+/*!
+ * \brief Processes the events of the producer thread until it is done and the queue is empty.
+ */
+static void consume(embedd_event_overflow_t policy)
+{
+  pthread_t thread;
+  embedd_event_stats_t stats;
+
+  embedd_event_manager_init();
+  CHECK( embedd_event_manager_set_overflow_policy( policy ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_register_callback( SEQ_EVENT_ID, on_seq ) == EMBEDD_RESULT_OK );
+  received = 0;
+  last_seq = 0;
+  out_of_order = 0;
+  stop = 0;
+  CHECK( pthread_create( &thread, NULL, produce, NULL ) == 0 );
+  // the queue is checked empty after the producer is seen done, so no event is left behind
+  for( uint32_t done = 0; !done; ) {
+    done = __atomic_load_n( &stop, __ATOMIC_ACQUIRE );
+    if( embedd_event_manager_process_budget( 0, 0 ) != 0 || !done ) {
+      done = 0;
+      sched_yield();
+    }
+  }
+  pthread_join( thread, NULL );
+  CHECK( embedd_event_manager_get_stats( &stats ) == EMBEDD_RESULT_OK );
+  CHECK( out_of_order == 0 );
+  CHECK( last_seq == STRESS_EVENTS );
+  CHECK( stats.high_water <= EMBEDD_EVENT_MGR_MAX_QUEUE_ITEMS_COUNT );
+  if( policy == EMBEDD_EVENT_OVERFLOW_DROP_OLDEST ) {
+    // the newest event is never the one dropped
+    CHECK( received + stats.dropped == STRESS_EVENTS );
+    CHECK( stats.enqueued == STRESS_EVENTS );
+  } else {
+    CHECK( received == STRESS_EVENTS );
+    CHECK( stats.enqueued == STRESS_EVENTS && stats.dispatched == STRESS_EVENTS );
+  }
+  CHECK( stats.dispatched == received );
+  CHECK( foreign_triggers == 0 );
+}
+
+static void test_spsc(void)
+{
+  consume( EMBEDD_EVENT_OVERFLOW_REJECT );
+  consume( EMBEDD_EVENT_OVERFLOW_DROP_OLDEST );
+}
+
+static void test_async_deferred(void)
+{
+  pthread_t thread;
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+  uint32_t started = 0;
+  uint32_t sent = 0;
+
+  embedd_event_manager_init();
+  CHECK( embedd_event_manager_register_callback( ASYNC_EVENT_ID, on_async ) == EMBEDD_RESULT_OK );
+  CHECK( embedd_event_manager_register_callback( MAIN_EVENT_ID, on_seq ) == EMBEDD_RESULT_OK );
+  for( uint32_t i = 0; i < DS3231_REGISTER_MAP_SIZE; ++i ) {
+    sim_ds3231.regs[i] = (uint8_t)( 0x40 + i );
+  }
+  received = 0;
+  last_seq = 0;
+  out_of_order = 0;
+  producer = pthread_self();
+  stop = 0;
+  CHECK( pthread_create( &thread, NULL, interrupt, NULL ) == 0 );
+  while( async_events < STRESS_TRANSFERS ) {
+    if( started < STRESS_TRANSFERS && !ds3231_async_busy( &clock_chip ) ) {
+      CHECK( ds3231_read_regs_async( &clock_chip, ds3231_seconds_read_reg_addr, DS3231_REGISTER_MAP_SIZE, regs, ASYNC_EVENT_ID ) == EMBEDD_RESULT_OK );
+      ++ started;
+    }
+    if( embedd_event_manager_trigger( MAIN_EVENT_ID, (void*)(uintptr_t)( sent + 1 ) ) == EMBEDD_RESULT_OK ) {
+      ++ sent;
+    }
+    ds3231_async_process( &clock_chip );
+    embedd_event_manager_process_budget( 0, 0 );
+    // let the interrupt thread run on a single core
+    sched_yield();
+  }
+  __atomic_store_n( &stop, 1, __ATOMIC_RELEASE );
+  pthread_join( thread, NULL );
+  embedd_event_manager_process_budget( 0, 0 );
+
+  CHECK( foreign_triggers == 0 );
+  CHECK( completed == STRESS_TRANSFERS && async_events == STRESS_TRANSFERS && async_errors == 0 );
+  CHECK( received == sent && last_seq == sent && out_of_order == 0 );
+  CHECK( !ds3231_async_busy( &clock_chip ) );
+  CHECK( regs[0] == 0x40 && regs[DS3231_REGISTER_MAP_SIZE - 1] == 0x40 + DS3231_REGISTER_MAP_SIZE - 1 );
+}
+
+int main(void)
+{
+  sim_ds3231_attach( &clock_chip );
+  test_spsc();
+  test_async_deferred();
+  return TEST_RESULT();
+}
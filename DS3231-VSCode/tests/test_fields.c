@@ -0,0 +1,152 @@
+/*!
+ * \file test_fields.c
+ * \brief Host test of the register field descriptors
+ *
+ * Sets every field through its bitfield structure and checks that exactly
+ * the bits of DS3231_FIELD_MASK change, so the shift and width descriptors
+ * of ds3231_fields.h cannot drift from the structures of ds3231_data_types.h.
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "ds3231.h"
+#include "test_util.h"
+
+/*!
+ * \macro DS3231_TEST_FIELDS
+ * \brief Every field of every register as X(typename, data type, field)
+ */
+#define DS3231_TEST_FIELDS(X) \
+  X(ds3231_seconds, ds3231_seconds_t, seconds) \
+  X(ds3231_seconds, ds3231_seconds_t, _10_seconds) \
+  X(ds3231_seconds, ds3231_seconds_t, reserved) \
+  X(ds3231_minutes, ds3231_minutes_t, minutes) \
+  X(ds3231_minutes, ds3231_minutes_t, _10_minutes) \
+  X(ds3231_minutes, ds3231_minutes_t, reserved) \
+  X(ds3231_hour, ds3231_hour_t, hour) \
+  X(ds3231_hour, ds3231_hour_t, _10_hour) \
+  X(ds3231_hour, ds3231_hour_t, ampm20hour) \
+  X(ds3231_hour, ds3231_hour_t, _1224) \
+  X(ds3231_hour, ds3231_hour_t, reserved) \
+  X(ds3231_day, ds3231_day_t, day) \
+  X(ds3231_day, ds3231_day_t, reserved) \
+  X(ds3231_date, ds3231_date_t, date) \
+  X(ds3231_date, ds3231_date_t, _10_date) \
+  X(ds3231_date, ds3231_date_t, rsv_1) \
+  X(ds3231_monthcentury, ds3231_monthcentury_t, month) \
+  X(ds3231_monthcentury, ds3231_monthcentury_t, _10_month) \
+  X(ds3231_monthcentury, ds3231_monthcentury_t, rsv) \
+  X(ds3231_monthcentury, ds3231_monthcentury_t, century) \
+  X(ds3231_year, ds3231_year_t, year) \
+  X(ds3231_year, ds3231_year_t, _10_year) \
+  X(ds3231_alarm_1_seconds, ds3231_alarm_1_seconds_t, seconds) \
+  X(ds3231_alarm_1_seconds, ds3231_alarm_1_seconds_t, _10_seconds) \
+  X(ds3231_alarm_1_seconds, ds3231_alarm_1_seconds_t, a1m1) \
+  X(ds3231_alarm_1_minutes, ds3231_alarm_1_minutes_t, minutes) \
+  X(ds3231_alarm_1_minutes, ds3231_alarm_1_minutes_t, _10_minutes) \
+  X(ds3231_alarm_1_minutes, ds3231_alarm_1_minutes_t, a1m2) \
+  X(ds3231_alarm_1_hour, ds3231_alarm_1_hour_t, hour) \
+  X(ds3231_alarm_1_hour, ds3231_alarm_1_hour_t, _10_hour) \
+  X(ds3231_alarm_1_hour, ds3231_alarm_1_hour_t, ampm20hour) \
+  X(ds3231_alarm_1_hour, ds3231_alarm_1_hour_t, _1224) \
+  X(ds3231_alarm_1_hour, ds3231_alarm_1_hour_t, a1m3) \
+  X(ds3231_alarm_1_daydate, ds3231_alarm_1_daydate_t, daydate) \
+  X(ds3231_alarm_1_daydate, ds3231_alarm_1_daydate_t, _10_date) \
+  X(ds3231_alarm_1_daydate, ds3231_alarm_1_daydate_t, dydt) \
+  X(ds3231_alarm_1_daydate, ds3231_alarm_1_daydate_t, a1m4) \
+  X(ds3231_alarm_2_minutes, ds3231_alarm_2_minutes_t, minutes) \
+  X(ds3231_alarm_2_minutes, ds3231_alarm_2_minutes_t, _10_minutes) \
+  X(ds3231_alarm_2_minutes, ds3231_alarm_2_minutes_t, a2m2) \
+  X(ds3231_alarm_2_hour, ds3231_alarm_2_hour_t, hour) \
+  X(ds3231_alarm_2_hour, ds3231_alarm_2_hour_t, _10_hour) \
+  X(ds3231_alarm_2_hour, ds3231_alarm_2_hour_t, ampm20hour) \
+  X(ds3231_alarm_2_hour, ds3231_alarm_2_hour_t, _1224) \
+  X(ds3231_alarm_2_hour, ds3231_alarm_2_hour_t, a2m3) \
+  X(ds3231_alarm_2_daydate, ds3231_alarm_2_daydate_t, daydate) \
+  X(ds3231_alarm_2_daydate, ds3231_alarm_2_daydate_t, _10_date) \
+  X(ds3231_alarm_2_daydate, ds3231_alarm_2_daydate_t, dydt) \
+  X(ds3231_alarm_2_daydate, ds3231_alarm_2_daydate_t, a2m4) \
+  X(ds3231_control, ds3231_control_t, a1ie) \
+  X(ds3231_control, ds3231_control_t, a2ie) \
+  X(ds3231_control, ds3231_control_t, intcn) \
+  X(ds3231_control, ds3231_control_t, rs1) \
+  X(ds3231_control, ds3231_control_t, rs2) \
+  X(ds3231_control, ds3231_control_t, conv) \
+  X(ds3231_control, ds3231_control_t, bbsqw) \
+  X(ds3231_control, ds3231_control_t, eosc) \
+  X(ds3231_status, ds3231_controlstatus_t, a1f) \
+  X(ds3231_status, ds3231_controlstatus_t, a2f) \
+  X(ds3231_status, ds3231_controlstatus_t, bsy) \
+  X(ds3231_status, ds3231_controlstatus_t, en32khz) \
+  X(ds3231_status, ds3231_controlstatus_t, reserved) \
+  X(ds3231_status, ds3231_controlstatus_t, ocf) \
+  X(ds3231_aging_offset, ds3231_aging_offset_t, data) \
+  X(ds3231_aging_offset, ds3231_aging_offset_t, sign) \
+  X(ds3231_msb_of_temp, ds3231_msb_of_temp_t, data) \
+  X(ds3231_msb_of_temp, ds3231_msb_of_temp_t, sign) \
+  X(ds3231_lsb_of_temp, ds3231_lsb_of_temp_t, rsvd) \
+  X(ds3231_lsb_of_temp, ds3231_lsb_of_temp_t, tmplsb)
+
+/*!
+ * \brief Value of \a _field with all its bits set.
+ */
+#define FIELD_ONES(_typename, _field) ( ( 1U << _typename##_##_field##_width ) - 1U )
+
+/*!
+ * \brief Byte of a register with only \a _field set to all ones through its bitfield structure.
+ */
+#define FIELD_BITS(_typename, _type, _field) \
+  ( (union { _type reg; uint8_t byte; }){ .reg = { ._field = FIELD_ONES(_typename, _field) } }.byte )
+
+/*!
+ * \brief Byte of a register with all fields set to ones except \a _field.
+ */
+#define FIELD_CLEARED(_type, _field, var) do { \
+  union { _type reg; uint8_t byte; } u = { .byte = 0xFF }; \
+  u.reg._field = 0; \
+  var = u.byte; \
+} while( 0 )
+
+static void check_field(const char *name, uint8_t mask, uint8_t set, uint8_t cleared, uint8_t value)
+{
+  uint8_t cleared_bits = (uint8_t)~cleared;
+  if( set != mask || cleared_bits != mask || value != mask ) {
+    fprintf( stderr, "%s: mask 0x%02x, set through structure 0x%02x, cleared through structure 0x%02x, value 0x%02x\n",
+             name, mask, set, cleared_bits, value );
+    ++ test_failures;
+  }
+}
+
+#define CHECK_FIELD(_typename, _type, _field) do { \
+  uint8_t cleared; \
+  FIELD_CLEARED(_type, _field, cleared); \
+  check_field( #_typename "." #_field, DS3231_FIELD_MASK(_typename, _field), FIELD_BITS(_typename, _type, _field), cleared, \
+               DS3231_FIELD_VALUE(_typename, _field, FIELD_ONES(_typename, _field)) ); \
+} while( 0 );
+
+#define CHECK_SIZE(_typename, _type, _field) CHECK( sizeof(_type) == 1 );
+
+int main(void)
+{
+  DS3231_TEST_FIELDS(CHECK_FIELD)
+  DS3231_TEST_FIELDS(CHECK_SIZE)
+  return TEST_RESULT();
+}
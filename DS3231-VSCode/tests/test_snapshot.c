@@ -0,0 +1,205 @@
+/*!
+ * \file test_snapshot.c
+ * \brief Host test of the register map snapshot engine
+ *
+ * Drives the engine over the simulated device and checks the transfer
+ * period, error handling and the sequence counter. embedd_copy() is wrapped
+ * at link time, so snapshots can be published while a reader is copying
+ * the map, as an interrupt would do, to check that torn copies are retried.
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "ds3231.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+#define SNAPSHOT_PERIOD_MS  (100U)
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+static ds3231_snapshot_t snap;
+static uint32_t now_ms;
+static uint32_t updates;
+
+// publishing done by the wrapped copy, after the first half of the map is copied
+static uint32_t copy_calls;
+static uint32_t copy_publishes;
+static uint32_t copy_publish_calls;
+
+size_t __real_embedd_copy(void* dst, void* src, size_t Size);
+
+static void on_snapshot_updated(struct EventSource *ev)
+{
+  ++ updates;
+}
+
+/*!
+ * \brief Fills the register map of the simulated device with \a value.
+ */
+static void fill_regs(uint8_t value)
+{
+  memset( sim_ds3231.regs, value, sizeof(sim_ds3231.regs) );
+}
+
+/*!
+ * \brief Completes the transfer in flight with the map filled with \a value and runs the engine after a period.
+ */
+static void publish(uint8_t value)
+{
+  fill_regs( value );
+  sim_ds3231_complete();
+  now_ms += SNAPSHOT_PERIOD_MS;
+  ds3231_snapshot_process( &snap, now_ms );
+}
+
+size_t __wrap_embedd_copy(void* dst, void* src, size_t Size)
+{
+  ++ copy_calls;
+  if( copy_calls > copy_publish_calls || Size < 2 ) {
+    return __real_embedd_copy( dst, src, Size );
+  }
+  size_t half = Size / 2;
+  __real_embedd_copy( dst, src, half );
+  for( uint32_t i = 0; i < copy_publishes; ++i ) {
+    publish( (uint8_t)( 0x80 + copy_calls * 4 + i ) );
+  }
+  __real_embedd_copy( (uint8_t*)dst + half, (uint8_t*)src + half, Size - half );
+  return Size;
+}
+
+static bool regs_uniform(const uint8_t regs[DS3231_REGISTER_MAP_SIZE], uint8_t *value)
+{
+  for( uint32_t i = 1; i < DS3231_REGISTER_MAP_SIZE; ++i ) {
+    if( regs[i] != regs[0] ) {
+      return false;
+    }
+  }
+  *value = regs[0];
+  return true;
+}
+
+static void test_period(void)
+{
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+  uint32_t seq = 0;
+
+  CHECK( ds3231_snapshot_process( &snap, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.pending );
+  CHECK( ds3231_snapshot_latest( &snap, NULL ) == NULL );
+  CHECK( ds3231_snapshot_read( &snap, regs, NULL ) == EMBEDD_RESULT_ERR );
+
+  // the transfer completes, nothing is started before the period has elapsed
+  fill_regs( 0x11 );
+  CHECK( sim_ds3231_complete() );
+  CHECK( ds3231_snapshot_process( &snap, now_ms + 1 ) == EMBEDD_RESULT_OK );
+  CHECK( !sim_ds3231.pending );
+  CHECK( ds3231_snapshot_read( &snap, regs, &seq ) == EMBEDD_RESULT_OK );
+  CHECK( seq == 2 && regs[0] == 0x11 && regs[DS3231_REGISTER_MAP_SIZE - 1] == 0x11 );
+  CHECK( ds3231_snapshot_process( &snap, now_ms + SNAPSHOT_PERIOD_MS - 1 ) == EMBEDD_RESULT_OK );
+  CHECK( !sim_ds3231.pending );
+  embedd_event_manager_process_budget( 0, 0 );
+  CHECK( updates == 1 );
+
+  // the next one starts once the period has elapsed
+  now_ms += SNAPSHOT_PERIOD_MS;
+  CHECK( ds3231_snapshot_process( &snap, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.pending );
+  publish( 0x22 );
+  CHECK( ds3231_snapshot_latest( &snap, &seq ) != NULL && seq == 4 );
+  CHECK( ds3231_snapshot_latest( &snap, NULL )[0] == 0x22 );
+  embedd_event_manager_process_budget( 0, 0 );
+  CHECK( updates == 2 );
+}
+
+static void test_errors(void)
+{
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+  uint32_t seq = 0;
+  uint32_t seq_before = snap.seq;
+
+  // a failed transfer is counted and does not publish
+  sim_ds3231.result = EMBEDD_RESULT_ERR;
+  fill_regs( 0x33 );
+  CHECK( sim_ds3231_complete() );
+  now_ms += SNAPSHOT_PERIOD_MS;
+  CHECK( ds3231_snapshot_process( &snap, now_ms ) == EMBEDD_RESULT_ERR );
+  CHECK( snap.errors == 1 && snap.seq == seq_before );
+  CHECK( ds3231_snapshot_read( &snap, regs, &seq ) == EMBEDD_RESULT_OK && regs[0] == 0x22 );
+  sim_ds3231.result = EMBEDD_RESULT_OK;
+
+  // a period is skipped while another transfer of the device is in flight
+  publish( 0x44 );
+  uint8_t seconds;
+  sim_ds3231_complete();
+  CHECK( ds3231_snapshot_process( &snap, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( snap.pending == 0 && !sim_ds3231.pending );
+  CHECK( ds3231_read_reg_async( &clock_chip, ds3231_seconds_read_reg_addr, &seconds, 1, VOID_EVENT_ID ) == EMBEDD_RESULT_OK );
+  now_ms += SNAPSHOT_PERIOD_MS;
+  CHECK( ds3231_snapshot_process( &snap, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.pending && snap.pending == 0 );
+  sim_ds3231_complete();
+  now_ms += SNAPSHOT_PERIOD_MS;
+  CHECK( ds3231_snapshot_process( &snap, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( snap.pending == 1 );
+}
+
+static void test_torn_read(void)
+{
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+  uint8_t value = 0;
+  uint32_t seq = 0;
+
+  // two snapshots are published during the first copy, so the buffer being copied is overwritten
+  publish( 0x55 );
+  copy_calls = 0;
+  copy_publish_calls = 1;
+  copy_publishes = 2;
+  uint32_t seq_before = snap.seq;
+  CHECK( ds3231_snapshot_read( &snap, regs, &seq ) == EMBEDD_RESULT_OK );
+  CHECK( copy_calls == 2 );
+  CHECK( regs_uniform( regs, &value ) );
+  CHECK( value == 0x85 );
+  CHECK( seq == seq_before + 4 && seq == snap.seq );
+
+  // a snapshot is published during every copy, the read gives up after the retries
+  copy_calls = 0;
+  copy_publish_calls = DS3231_SNAPSHOT_READ_RETRIES;
+  copy_publishes = 1;
+  CHECK( ds3231_snapshot_read( &snap, regs, &seq ) == EMBEDD_RESULT_ERR );
+  CHECK( copy_calls == DS3231_SNAPSHOT_READ_RETRIES );
+  copy_publish_calls = 0;
+}
+
+int main(void)
+{
+  sim_ds3231_attach( &clock_chip );
+  embedd_event_manager_init();
+  embedd_event_manager_register_callback( DS3231_SNAPSHOT_UPDATED_EVENT_ID, on_snapshot_updated );
+  CHECK( ds3231_snapshot_init( &snap, &clock_chip, SNAPSHOT_PERIOD_MS ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_snapshot_init( &snap, NULL, SNAPSHOT_PERIOD_MS ) == EMBEDD_RESULT_ERR );
+  CHECK( ds3231_snapshot_init( &snap, &clock_chip, SNAPSHOT_PERIOD_MS ) == EMBEDD_RESULT_OK );
+
+  test_period();
+  test_errors();
+  test_torn_read();
+  return TEST_RESULT();
+}
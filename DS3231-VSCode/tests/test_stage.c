@@ -0,0 +1,198 @@
+/*!
+ * \file test_stage.c
+ * \brief Host test of the staged writes and of their flush
+ *
+ * Counts the transfers and the registers written on the simulated device to
+ * check how ds3231_flush() groups the dirty registers into bursts, that a
+ * failed flush leaves the registers dirty for the next one, and that reads
+ * of staged registers return the staged values.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include "ds3231.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+static uint32_t transfers;
+static uint32_t writes;
+
+/*!
+ * \brief Stages a register, nothing goes to the bus.
+ */
+static void stage(uint32_t addr, uint8_t value)
+{
+  uint32_t before = sim_ds3231.transfers;
+  CHECK( ds3231_write_reg( &clock_chip, addr, &value, 1, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.transfers == before );
+}
+
+/*!
+ * \brief Starts counting the transfers and the registers written.
+ */
+static void mark(void)
+{
+  transfers = sim_ds3231.transfers;
+  writes = sim_ds3231.writes;
+}
+
+/*!
+ * \brief Tells whether the bus took \a count_transfers transfers writing \a count_writes registers since mark().
+ */
+static bool sent(uint32_t count_transfers, uint32_t count_writes)
+{
+  return ( sim_ds3231.transfers - transfers == count_transfers ) && ( sim_ds3231.writes - writes == count_writes );
+}
+
+static void setup(void)
+{
+  sim_ds3231_attach( &clock_chip );
+  ds3231_cache_invalidate( &clock_chip );
+  for( uint32_t i = 0; i < DS3231_REGISTER_MAP_SIZE; ++i ) {
+    sim_ds3231.regs[i] = (uint8_t)( 0x10 + i );
+  }
+  CHECK( ds3231_stage_begin( &clock_chip ) == EMBEDD_RESULT_OK );
+}
+
+static void test_bursts(void)
+{
+  uint8_t value;
+
+  // adjacent registers go in one burst
+  setup();
+  stage( ds3231_alarm_1_seconds_write_reg_addr, 0x01 );
+  stage( ds3231_alarm_1_minutes_write_reg_addr, 0x02 );
+  stage( ds3231_alarm_1_hour_write_reg_addr, 0x03 );
+  CHECK( sim_ds3231.regs[ds3231_alarm_1_seconds_read_reg_addr] == 0x17 );
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 1, 3 ) );
+  CHECK( sim_ds3231.regs[0x07] == 0x01 && sim_ds3231.regs[0x08] == 0x02 && sim_ds3231.regs[0x09] == 0x03 && sim_ds3231.regs[0x0a] == 0x1a );
+
+  // out of the staged mode, writes go to the bus again
+  mark();
+  value = 0x04;
+  CHECK( ds3231_write_reg( &clock_chip, ds3231_alarm_1_seconds_write_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 1, 1 ) );
+
+  // a register not known in between splits the burst
+  setup();
+  stage( ds3231_alarm_2_minutes_write_reg_addr, 0x05 );
+  stage( ds3231_alarm_2_daydate_write_reg_addr, 0x06 );
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 2, 2 ) );
+  CHECK( sim_ds3231.regs[0x0b] == 0x05 && sim_ds3231.regs[0x0c] == 0x1c && sim_ds3231.regs[0x0d] == 0x06 );
+
+  // a cached register known in between is written with its value, the burst is not split
+  setup();
+  CHECK( ds3231_read_reg( &clock_chip, ds3231_alarm_2_hour_read_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_OK );
+  stage( ds3231_alarm_2_minutes_write_reg_addr, 0x07 );
+  stage( ds3231_alarm_2_daydate_write_reg_addr, 0x08 );
+  sim_ds3231.regs[0x0c] = 0x1c;
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 1, 3 ) );
+  CHECK( sim_ds3231.regs[0x0b] == 0x07 && sim_ds3231.regs[0x0c] == 0x1c && sim_ds3231.regs[0x0d] == 0x08 );
+
+  // a volatile register in between splits the burst even when it was read
+  setup();
+  CHECK( ds3231_read_reg( &clock_chip, ds3231_status_read_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_OK );
+  stage( ds3231_control_write_reg_addr, 0x1c );
+  stage( ds3231_aging_offset_write_reg_addr, 0x09 );
+  sim_ds3231.regs[ds3231_status_read_reg_addr] = 0x8b;
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 2, 2 ) );
+  CHECK( sim_ds3231.regs[0x0e] == 0x1c && sim_ds3231.regs[0x0f] == 0x8b && sim_ds3231.regs[0x10] == 0x09 );
+
+  // nothing staged, nothing sent
+  setup();
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 0, 0 ) );
+}
+
+static void test_failed_flush(void)
+{
+  // the whole flush fails, the registers stay dirty and the staged mode enabled
+  setup();
+  stage( ds3231_alarm_2_minutes_write_reg_addr, 0x0a );
+  stage( ds3231_alarm_2_hour_write_reg_addr, 0x0b );
+  sim_ds3231.result = EMBEDD_RESULT_ERR;
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_ERR );
+  CHECK( sim_ds3231.regs[0x0b] == 0x1b && sim_ds3231.regs[0x0c] == 0x1c );
+  sim_ds3231.result = EMBEDD_RESULT_OK;
+  stage( ds3231_alarm_2_daydate_write_reg_addr, 0x0c );
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 1, 3 ) );
+  CHECK( sim_ds3231.regs[0x0b] == 0x0a && sim_ds3231.regs[0x0c] == 0x0b && sim_ds3231.regs[0x0d] == 0x0c );
+
+  // the second burst fails, only its registers are sent again
+  setup();
+  stage( ds3231_seconds_write_reg_addr, 0x11 );
+  stage( ds3231_aging_offset_write_reg_addr, 0x12 );
+  sim_ds3231.fail_from = sim_ds3231.transfers + 2;
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_ERR );
+  CHECK( sent( 2, 1 ) );
+  CHECK( sim_ds3231.regs[0x00] == 0x11 && sim_ds3231.regs[0x10] == 0x20 );
+  sim_ds3231.fail_from = 0;
+  mark();
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 1, 1 ) );
+  CHECK( sim_ds3231.regs[0x10] == 0x12 );
+}
+
+static void test_staged_reads(void)
+{
+  uint8_t value = 0;
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+
+  // staged registers are read from the shadow, cached or volatile
+  setup();
+  stage( ds3231_aging_offset_write_reg_addr, 0x42 );
+  stage( ds3231_seconds_write_reg_addr, 0x59 );
+  mark();
+  CHECK( ds3231_read_reg( &clock_chip, ds3231_aging_offset_read_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_OK && value == 0x42 );
+  CHECK( ds3231_read_reg( &clock_chip, ds3231_seconds_read_reg_addr, &value, 1, 0 ) == EMBEDD_RESULT_OK && value == 0x59 );
+  CHECK( sent( 0, 0 ) );
+
+  // a range partly staged is read from the device with the staged values put in
+  CHECK( ds3231_read_regs( &clock_chip, ds3231_seconds_read_reg_addr, 7, regs ) == EMBEDD_RESULT_OK );
+  CHECK( sent( 1, 0 ) );
+  CHECK( regs[0] == 0x59 && regs[1] == 0x11 && regs[6] == 0x16 );
+
+  // the read does not flush the staged register
+  CHECK( sim_ds3231.regs[0x00] == 0x10 );
+  CHECK( ds3231_flush( &clock_chip ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.regs[0x00] == 0x59 && sim_ds3231.regs[0x10] == 0x42 );
+}
+
+int main(void)
+{
+  test_bursts();
+  test_failed_flush();
+  test_staged_reads();
+  return TEST_RESULT();
+}
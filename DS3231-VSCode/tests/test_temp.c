@@ -0,0 +1,258 @@
+/*!
+ * \file test_temp.c
+ * \brief Host test of the temperature conversion against a timed device model
+ *
+ * The simulated device keeps CONV and BSY in time: a conversion forced by
+ * CONV sets both for DS3231 conversion time, and the device may run its own
+ * conversion with BSY alone. The registers are brought up to date at every
+ * read, so the state machine sees them change between its polls. The model
+ * records when CONV is written and whether BSY was set then.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include "ds3231.h"
+#include "ds3231_fields.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+#define CONV_MS       (150U)
+#define POLL_MS       (10U)
+#define TEMP_MSB      (0xF3U)   // -12.25 °C
+#define TEMP_LSB      (0xC0U)
+#define TEMP_QUARTERS (-49)
+
+#define CONV_MASK     DS3231_FIELD_MASK(ds3231_control, conv)
+#define BSY_MASK      DS3231_FIELD_MASK(ds3231_status, bsy)
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+static ds3231_temp_t temp;
+static uint32_t now_ms;
+static uint32_t ready_events;
+
+// device model
+static bool converting;
+static bool conv_stuck;
+static uint32_t conv_start_ms;
+static uint32_t own_busy_until_ms;
+static uint32_t conv_writes;
+static uint32_t conv_writes_while_busy;
+
+static void on_temperature_ready(struct EventSource *ev)
+{
+  ++ ready_events;
+}
+
+static bool model_busy(void)
+{
+  return converting || (int32_t)( now_ms - own_busy_until_ms ) < 0;
+}
+
+/*!
+ * \brief Brings CONV, BSY and the temperature up to date before a read.
+ */
+static void model_on_read(uint8_t addr)
+{
+  if( converting && !conv_stuck && (uint32_t)( now_ms - conv_start_ms ) >= CONV_MS ) {
+    converting = false;
+    sim_ds3231.regs[ds3231_control_read_reg_addr] &= ~CONV_MASK;
+    sim_ds3231.regs[ds3231_msb_of_temp_read_reg_addr] = TEMP_MSB;
+    sim_ds3231.regs[ds3231_lsb_of_temp_read_reg_addr] = TEMP_LSB;
+  }
+  if( model_busy() ) {
+    sim_ds3231.regs[ds3231_status_read_reg_addr] |= BSY_MASK;
+  } else {
+    sim_ds3231.regs[ds3231_status_read_reg_addr] &= ~BSY_MASK;
+  }
+}
+
+/*!
+ * \brief Starts a conversion when CONV is written.
+ */
+static void model_on_write(uint8_t addr, uint8_t value)
+{
+  if( addr != ds3231_control_write_reg_addr || !( value & CONV_MASK ) || converting ) {
+    return;
+  }
+  ++ conv_writes;
+  if( model_busy() ) {
+    ++ conv_writes_while_busy;
+  }
+  converting = true;
+  conv_start_ms = now_ms;
+}
+
+static void model_reset(void)
+{
+  sim_ds3231_attach( &clock_chip );
+  sim_ds3231.on_read = model_on_read;
+  sim_ds3231.on_write = model_on_write;
+  converting = false;
+  conv_stuck = false;
+  own_busy_until_ms = now_ms;
+  conv_writes = 0;
+  conv_writes_while_busy = 0;
+  ready_events = 0;
+  CHECK( ds3231_temp_init( &temp, &clock_chip, POLL_MS ) == EMBEDD_RESULT_OK );
+}
+
+/*!
+ * \brief Runs the conversion every ms until it ends or for \a max_ms, checking the poll interval.
+ *
+ * \return Result of the call that ended the conversion.
+ */
+static EMBEDD_RESULT run(uint32_t max_ms, uint32_t poll_ms)
+{
+  EMBEDD_RESULT result = EMBEDD_RESULT_OK;
+  uint32_t last_poll_ms = 0;
+  bool polled = false;
+  for( uint32_t end = now_ms + max_ms; now_ms != end && ds3231_temp_busy( &temp ); ++ now_ms ) {
+    uint32_t transfers = sim_ds3231.transfers;
+    result = ds3231_temp_process( &temp, now_ms );
+    if( sim_ds3231.transfers != transfers ) {
+      CHECK( !polled || now_ms - last_poll_ms >= poll_ms );
+      polled = true;
+      last_poll_ms = now_ms;
+    }
+    embedd_event_manager_process_budget( 0, 0 );
+  }
+  return result;
+}
+
+static void test_poll_interval(void)
+{
+  int16_t quarters;
+  model_reset();
+  CHECK( ds3231_temp_get( &temp, &quarters ) == EMBEDD_RESULT_ERR );
+
+  uint32_t start_ms = now_ms;
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_ERR );
+  // the first poll is at once, CONV is set by it
+  CHECK( ds3231_temp_process( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( conv_writes == 1 && conv_start_ms == start_ms && temp.state == DS3231_TEMP_STATE_CONVERTING );
+
+  uint32_t transfers = sim_ds3231.transfers;
+  CHECK( run( 1000U, POLL_MS ) == EMBEDD_RESULT_OK );
+  // completion is seen by the first poll after the conversion time
+  CHECK( now_ms - start_ms > CONV_MS && now_ms - start_ms <= CONV_MS + POLL_MS + 1 );
+  CHECK( sim_ds3231.transfers - transfers <= 2 * ( CONV_MS / POLL_MS + 1 ) );
+  CHECK( ready_events == 1 && conv_writes_while_busy == 0 );
+  CHECK( ds3231_temp_get( &temp, &quarters ) == EMBEDD_RESULT_OK && quarters == TEMP_QUARTERS );
+  CHECK( temp.errors == 0 );
+
+  // idle, the bus is not touched
+  transfers = sim_ds3231.transfers;
+  for( uint32_t i = 0; i < 100; ++i, ++now_ms ) {
+    CHECK( ds3231_temp_process( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  }
+  CHECK( sim_ds3231.transfers == transfers );
+}
+
+static void test_poll_every_call(void)
+{
+  model_reset();
+  CHECK( ds3231_temp_init( &temp, &clock_chip, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  uint32_t start_ms = now_ms;
+  uint32_t transfers = sim_ds3231.transfers;
+  CHECK( run( 1000U, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( now_ms - start_ms == CONV_MS + 1 );
+  CHECK( sim_ds3231.transfers - transfers >= CONV_MS );
+  CHECK( ready_events == 1 );
+}
+
+static void test_busy_at_request(void)
+{
+  // the device is running its own conversion when the request comes
+  model_reset();
+  own_busy_until_ms = now_ms + 55U;
+  uint32_t start_ms = now_ms;
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_temp_process( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( conv_writes == 0 && temp.state == DS3231_TEMP_STATE_START );
+
+  CHECK( run( 1000U, POLL_MS ) == EMBEDD_RESULT_OK );
+  // CONV is set by the first poll after BSY cleared, never while it was set
+  CHECK( conv_writes == 1 && conv_writes_while_busy == 0 );
+  CHECK( conv_start_ms - start_ms >= 55U && conv_start_ms - start_ms < 55U + POLL_MS );
+  CHECK( ready_events == 1 && temp.errors == 0 );
+}
+
+static void test_timeout(void)
+{
+  int16_t quarters;
+
+  // CONV is never cleared
+  model_reset();
+  conv_stuck = true;
+  uint32_t start_ms = now_ms;
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( run( 1000U, POLL_MS ) == EMBEDD_RESULT_ERR );
+  CHECK( now_ms - start_ms > DS3231_TEMP_TIMEOUT_MS && now_ms - start_ms <= DS3231_TEMP_TIMEOUT_MS + POLL_MS + 1 );
+  CHECK( !ds3231_temp_busy( &temp ) && temp.errors == 1 && ready_events == 0 );
+  CHECK( ds3231_temp_get( &temp, &quarters ) == EMBEDD_RESULT_ERR );
+
+  // BSY is never cleared, CONV is never set
+  model_reset();
+  own_busy_until_ms = now_ms + 10000U;
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( run( 1000U, POLL_MS ) == EMBEDD_RESULT_ERR );
+  CHECK( conv_writes == 0 && temp.errors == 1 && ready_events == 0 );
+
+  // a new request after a timeout completes
+  own_busy_until_ms = now_ms;
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( run( 1000U, POLL_MS ) == EMBEDD_RESULT_OK );
+  CHECK( ready_events == 1 );
+}
+
+static void test_async_busy(void)
+{
+  uint8_t seconds;
+
+  // a transfer in flight defers the poll
+  model_reset();
+  CHECK( ds3231_read_reg_async( &clock_chip, ds3231_seconds_read_reg_addr, &seconds, 1, VOID_EVENT_ID ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_temp_start( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  uint32_t transfers = sim_ds3231.transfers;
+  CHECK( ds3231_temp_process( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.transfers == transfers && conv_writes == 0 );
+  CHECK( sim_ds3231_complete() );
+  CHECK( ds3231_temp_process( &temp, now_ms ) == EMBEDD_RESULT_OK );
+  CHECK( conv_writes == 1 );
+  CHECK( run( 1000U, POLL_MS ) == EMBEDD_RESULT_OK );
+  CHECK( ready_events == 1 );
+}
+
+int main(void)
+{
+  embedd_event_manager_init();
+  embedd_event_manager_register_callback( DS3231_TEMPERATURE_READY_EVENT_ID, on_temperature_ready );
+  now_ms = 0xFFFFFF00U; // the ms counter wraps during the first conversion
+
+  test_poll_interval();
+  test_poll_every_call();
+  test_busy_at_request();
+  test_timeout();
+  test_async_busy();
+  return TEST_RESULT();
+}
@@ -0,0 +1,114 @@
+/*!
+ * \file test_temp_stream.c
+ * \brief Host test of the statistics of the temperature stream
+ *
+ * Feeds windows of known temperatures and checks the mean, and the variance
+ * in m°C² against the variance of the filtered window computed in double.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "ds3231_temp_stream.h"
+#include "embedd_misc.h"
+#include "test_util.h"
+
+static ds3231_temp_stream_t stream;
+
+/*!
+ * \brief Returns the variance of the last filtered window in °C², as arm_var_q15() with N - 1.
+ */
+static double filtered_var(void)
+{
+  const q15_t *filtered = ds3231_temp_stream_filtered( &stream );
+  double sum = 0, sum_sq = 0;
+  for( uint32_t i = 0; i < DS3231_TEMP_STREAM_WINDOW; ++i ) {
+    double value = filtered[i] * 128.0 / 32768.0;
+    sum += value;
+    sum_sq += value * value;
+  }
+  double mean = sum / DS3231_TEMP_STREAM_WINDOW;
+  return ( sum_sq - mean * sum ) / ( DS3231_TEMP_STREAM_WINDOW - 1 );
+}
+
+/*!
+ * \brief Adds a window of a sine around 25 °C with \a amplitude_q quarters, one period per window.
+ */
+static void add_sine_window(double amplitude_q)
+{
+  for( uint32_t i = 0; i < DS3231_TEMP_STREAM_WINDOW; ++i ) {
+    double phase = 2.0 * M_PI * i / DS3231_TEMP_STREAM_WINDOW;
+    CHECK( ds3231_temp_stream_add( &stream, (int16_t)lround( 100.0 + amplitude_q * sin( phase ) ) ) == EMBEDD_RESULT_OK );
+  }
+}
+
+static void test_constant(void)
+{
+  CHECK( ds3231_temp_stream_init( &stream, NULL, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_temp_stream_stats( &stream ) == NULL );
+  for( uint32_t i = 0; i < 2 * DS3231_TEMP_STREAM_WINDOW; ++i ) {
+    CHECK( ds3231_temp_stream_add( &stream, -37 ) == EMBEDD_RESULT_OK );
+  }
+  const ds3231_temp_stream_stats_t *stats = ds3231_temp_stream_stats( &stream );
+  CHECK( stats != NULL && stats->window == 2 );
+  CHECK( ds3231_temp_stream_to_quarters( stats->mean ) == -37 );
+  CHECK( stats->var == 0 );
+}
+
+static void test_variance(void)
+{
+  static const double amplitudes[] = { 1.0, 2.0, 4.0, 8.0 };
+
+  for( uint32_t i = 0; i < CountOfArray(amplitudes); ++i ) {
+    CHECK( ds3231_temp_stream_init( &stream, NULL, 0 ) == EMBEDD_RESULT_OK );
+    add_sine_window( amplitudes[i] );
+    add_sine_window( amplitudes[i] );
+    const ds3231_temp_stream_stats_t *stats = ds3231_temp_stream_stats( &stream );
+    double expected = filtered_var() * 1000.0;
+    uint32_t mdeg2 = ds3231_temp_stream_var_to_mdeg2( stats->var );
+    // a few tenths of a degree no longer round to 0, within 1 % and the rounding of the conversion
+    CHECK( expected > 10.0 );
+    CHECK( fabs( mdeg2 - expected ) <= expected * 0.01 + 1.0 );
+    CHECK( abs( ds3231_temp_stream_to_quarters( stats->mean ) - 100 ) <= 1 );
+  }
+}
+
+static void test_saturation(void)
+{
+  // deviations beyond the full scale saturate instead of wrapping
+  uint32_t full_scale_mdeg2 = ds3231_temp_stream_var_to_mdeg2( INT16_MAX );
+  CHECK( ds3231_temp_stream_init( &stream, NULL, 0 ) == EMBEDD_RESULT_OK );
+  add_sine_window( 4.0 * 40 );
+  add_sine_window( 4.0 * 40 );
+  const ds3231_temp_stream_stats_t *stats = ds3231_temp_stream_stats( &stream );
+  CHECK( stats->var > 0 );
+  CHECK( ds3231_temp_stream_var_to_mdeg2( stats->var ) <= full_scale_mdeg2 );
+  CHECK( filtered_var() * 1000.0 > full_scale_mdeg2 );
+}
+
+int main(void)
+{
+  test_constant();
+  test_variance();
+  test_saturation();
+  return TEST_RESULT();
+}
@@ -0,0 +1,337 @@
+/*!
+ * \file test_timer.c
+ * \brief Host test of the timer service on Alarm 1
+ *
+ * The simulated device sets A1F when the time set by the test matches the
+ * alarm registers, and A1F and A2F are only cleared by writing 0, as on the
+ * device. The test checks the order the timers fire in, the periodic timers
+ * and their skipped periods, the overdue deadline, the registers written to
+ * program the alarm, and that a match or a rearm is not lost when a transfer
+ * fails or another transfer of the device is in flight.
+ *
+ *
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "ds3231.h"
+#include "sim_ds3231.h"
+#include "test_util.h"
+
+#define T0                  (1710072000LL)      // 2024-03-10 12:00:00
+#define FLAGS_MASK          (DS3231_FIELD_MASK(ds3231_status, a1f) | DS3231_FIELD_MASK(ds3231_status, a2f))
+#define A1F                 (DS3231_FIELD_MASK(ds3231_status, a1f))
+
+DS3231_I2C_DEVICE_DEFINE(clock_chip, "sim")
+
+static ds3231_timer_service_t svc;
+static ds3231_timer_t timers[4];
+static ds3231_timer_t *fired[16];
+static uint32_t fired_count;
+static uint8_t sim_flags;                       // A1F and A2F of the simulated device
+
+static void on_fired(ds3231_timer_t *timer)
+{
+  if( fired_count < CountOfArray(fired) ) {
+    fired[fired_count] = timer;
+  }
+  ++ fired_count;
+}
+
+static void sim_on_read(uint8_t addr)
+{
+  if( addr == ds3231_status_read_reg_addr ) {
+    sim_ds3231.regs[addr] = (uint8_t)( ( sim_ds3231.regs[addr] & ~FLAGS_MASK ) | sim_flags );
+  }
+}
+
+static void sim_on_write(uint8_t addr, uint8_t value)
+{
+  if( addr == ds3231_status_write_reg_addr ) {
+    // a flag is cleared by writing 0, writing 1 leaves it
+    sim_flags &= value;
+    sim_ds3231.regs[addr] = (uint8_t)( ( value & ~FLAGS_MASK ) | sim_flags );
+  }
+}
+
+/*!
+ * \brief Compiles the image of Alarm 1 the service programs for \a deadline.
+ */
+static void alarm_image(int64_t deadline, ds3231_alarm_image_t *image)
+{
+  ds3231_datetime_t datetime;
+  CHECK( ds3231_epoch_to_datetime( deadline, &datetime ) == EMBEDD_RESULT_OK );
+  ds3231_alarm_spec_t spec = { DS3231_ALARM_MODE_DATE, datetime.date, datetime.hour, datetime.minutes, datetime.seconds };
+  CHECK( ds3231_alarm_compile( DS3231_ALARM_1, &spec, image ) == EMBEDD_RESULT_OK );
+}
+
+/*!
+ * \brief Tells whether Alarm 1 of the simulated device holds \a deadline.
+ */
+static bool alarm_is(int64_t deadline)
+{
+  ds3231_alarm_image_t image;
+  alarm_image( deadline, &image );
+  return memcmp( &sim_ds3231.regs[ds3231_alarm_1_seconds_read_reg_addr], image.regs, image.size ) == 0;
+}
+
+/*!
+ * \brief Sets the time of the simulated device, A1F is set if it matches Alarm 1.
+ */
+static void set_time(int64_t epoch)
+{
+  ds3231_datetime_t datetime;
+  ds3231_time_regs_t regs;
+  CHECK( ds3231_epoch_to_datetime( epoch, &datetime ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_datetime_to_regs( &datetime, &regs ) == EMBEDD_RESULT_OK );
+  memcpy( &sim_ds3231.regs[ds3231_seconds_read_reg_addr], &regs, sizeof(regs) );
+  if( alarm_is( epoch ) ) {
+    sim_flags |= A1F;
+  }
+}
+
+/*!
+ * \brief Sets the time and runs the service as the interrupt of the pin would.
+ */
+static EMBEDD_RESULT tick(int64_t epoch)
+{
+  set_time( epoch );
+  ds3231_timer_signal( &svc );
+  return ds3231_timer_process( &svc );
+}
+
+static void setup(void)
+{
+  sim_ds3231_attach( &clock_chip );
+  sim_ds3231.on_read = sim_on_read;
+  sim_ds3231.on_write = sim_on_write;
+  sim_flags = 0;
+  ds3231_cache_invalidate( &clock_chip );
+  embedd_event_manager_init();
+  set_time( T0 );
+  CHECK( ds3231_timer_service_init( &svc, &clock_chip ) == EMBEDD_RESULT_OK );
+  for( uint32_t i = 0; i < CountOfArray(timers); ++i ) {
+    ds3231_timer_init( &timers[i], on_fired, NULL );
+  }
+  fired_count = 0;
+}
+
+static void test_order(void)
+{
+  setup();
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 30, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( alarm_is( T0 + 30 ) );
+  CHECK( ds3231_timer_start( &svc, &timers[1], T0 + 10, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_start( &svc, &timers[2], T0 + 20, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_start( &svc, &timers[3], T0 + 20, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( alarm_is( T0 + 10 ) );
+
+  // a signal without a match fires nothing
+  CHECK( tick( T0 + 5 ) == EMBEDD_RESULT_OK && fired_count == 0 );
+
+  CHECK( tick( T0 + 10 ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 1 && fired[0] == &timers[1] );
+  CHECK( !( sim_flags & A1F ) && alarm_is( T0 + 20 ) );
+
+  // both timers of the same deadline fire on its match
+  CHECK( tick( T0 + 20 ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 3 && fired[1] != fired[2] );
+  CHECK( ( fired[1] == &timers[2] || fired[1] == &timers[3] ) && ( fired[2] == &timers[2] || fired[2] == &timers[3] ) );
+  CHECK( alarm_is( T0 + 30 ) );
+
+  CHECK( tick( T0 + 30 ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 4 && fired[3] == &timers[0] );
+  CHECK( svc.count == 0 && !ds3231_timer_active( &timers[0] ) );
+  CHECK( svc.stats.matches == 3 && svc.stats.fired == 4 && svc.stats.errors == 0 );
+}
+
+static void test_periodic(void)
+{
+  setup();
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 60, 60 ) == EMBEDD_RESULT_OK );
+  CHECK( tick( T0 + 60 ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 1 && timers[0].deadline == T0 + 120 && alarm_is( T0 + 120 ) );
+
+  // the match is served late, the periods passed meanwhile are skipped and it fires once
+  set_time( T0 + 120 );
+  CHECK( sim_flags & A1F );
+  CHECK( tick( T0 + 330 ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 2 && timers[0].deadline == T0 + 360 && alarm_is( T0 + 360 ) );
+  CHECK( ds3231_timer_active( &timers[0] ) );
+
+  // served exactly at a later deadline, the next one is a whole period away
+  set_time( T0 + 360 );
+  CHECK( tick( T0 + 420 ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 3 && timers[0].deadline == T0 + 480 && alarm_is( T0 + 480 ) );
+}
+
+static void test_overdue(void)
+{
+  setup();
+  // a passed deadline would match a month later, it fires on the next process without A1F
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 - 5, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_start( &svc, &timers[1], T0 + 100, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( svc.overdue && svc.pending && !( sim_flags & A1F ) );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 1 && fired[0] == &timers[0] );
+  CHECK( svc.stats.matches == 0 && !svc.overdue && alarm_is( T0 + 100 ) );
+
+  // the deadline of now is overdue as well
+  CHECK( ds3231_timer_start( &svc, &timers[2], T0, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 2 && fired[1] == &timers[2] && alarm_is( T0 + 100 ) );
+}
+
+static void test_registers(void)
+{
+  setup();
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 10, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_start( &svc, &timers[1], T0 + 50, 0 ) == EMBEDD_RESULT_OK );
+  uint32_t writes = sim_ds3231.writes;
+  uint32_t regs_written = svc.stats.regs_written;
+
+  // the deadlines differ in the seconds only, a single register is written
+  CHECK( ds3231_timer_stop( &svc, &timers[0] ) == EMBEDD_RESULT_OK );
+  CHECK( alarm_is( T0 + 50 ) );
+  CHECK( sim_ds3231.writes == writes + 1 && svc.stats.regs_written == regs_written + 1 );
+
+  // the stopped timer does not fire at its deadline, the next one does
+  CHECK( tick( T0 + 10 ) == EMBEDD_RESULT_OK && fired_count == 0 );
+  CHECK( tick( T0 + 50 ) == EMBEDD_RESULT_OK && fired_count == 1 && fired[0] == &timers[1] );
+
+  // another day and hour, the minutes and the seconds stay
+  writes = sim_ds3231.writes;
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 86400 + 3600 + 50, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( alarm_is( T0 + 86400 + 3600 + 50 ) );
+  CHECK( sim_ds3231.writes == writes + 2 );
+
+  // the same deadline again writes nothing
+  writes = sim_ds3231.writes;
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 86400 + 3600 + 50, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( sim_ds3231.writes == writes );
+  CHECK( ds3231_timer_stop( &svc, &timers[0] ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_stop( &svc, &timers[0] ) == EMBEDD_RESULT_ERR );
+}
+
+static void test_busy(void)
+{
+  uint8_t regs[DS3231_REGISTER_MAP_SIZE];
+
+  setup();
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 10, 0 ) == EMBEDD_RESULT_OK );
+  set_time( T0 + 10 );
+  CHECK( ds3231_read_regs_async( &clock_chip, ds3231_seconds_read_reg_addr, DS3231_REGISTER_MAP_SIZE, regs, VOID_EVENT_ID ) == EMBEDD_RESULT_OK );
+
+  // the signal is kept while the transfer is in flight
+  ds3231_timer_signal( &svc );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( svc.pending && fired_count == 0 && svc.stats.errors == 0 );
+  CHECK( sim_ds3231_complete() );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 1 && !( sim_flags & A1F ) && !svc.pending );
+}
+
+static void test_match_failures(void)
+{
+  setup();
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 10, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_start( &svc, &timers[1], T0 + 20, 0 ) == EMBEDD_RESULT_OK );
+
+  // the status read fails, the match is checked again by the next process
+  set_time( T0 + 10 );
+  sim_ds3231.result = EMBEDD_RESULT_ERR;
+  ds3231_timer_signal( &svc );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_ERR );
+  CHECK( svc.pending && fired_count == 0 );
+  sim_ds3231.result = EMBEDD_RESULT_OK;
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 1 && !( sim_flags & A1F ) );
+
+  // the write clearing A1F fails, nothing fires until it is cleared
+  set_time( T0 + 20 );
+  sim_ds3231.fail_from = sim_ds3231.transfers + 2;
+  ds3231_timer_signal( &svc );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_ERR );
+  CHECK( svc.pending && fired_count == 1 && ( sim_flags & A1F ) );
+  sim_ds3231.fail_from = 0;
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 2 && !( sim_flags & A1F ) );
+
+  // the time read after A1F is cleared fails, the expired timer fires on the next process
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 30, 0 ) == EMBEDD_RESULT_OK );
+  set_time( T0 + 30 );
+  sim_ds3231.fail_from = sim_ds3231.transfers + 3;
+  ds3231_timer_signal( &svc );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_ERR );
+  CHECK( svc.pending && fired_count == 2 && !( sim_flags & A1F ) );
+  sim_ds3231.fail_from = 0;
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( fired_count == 3 && fired[2] == &timers[0] );
+  CHECK( svc.stats.errors == 3 && svc.stats.matches == 3 );
+}
+
+static void test_rearm_failure(void)
+{
+  setup();
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 10, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( tick( T0 + 10 ) == EMBEDD_RESULT_OK && fired_count == 1 );
+
+  // the alarm cannot be programmed, it keeps the deadline that matched
+  sim_ds3231.result = EMBEDD_RESULT_ERR;
+  CHECK( ds3231_timer_start( &svc, &timers[1], T0 + 40, 0 ) == EMBEDD_RESULT_ERR );
+  CHECK( ds3231_timer_active( &timers[1] ) && alarm_is( T0 + 10 ) );
+  CHECK( svc.pending && !svc.is_armed );
+
+  // still failing, it is retried by every process
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_ERR );
+  CHECK( svc.pending && alarm_is( T0 + 10 ) );
+  sim_ds3231.result = EMBEDD_RESULT_OK;
+  set_time( T0 + 15 );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( alarm_is( T0 + 40 ) && svc.is_armed && !svc.pending );
+  CHECK( tick( T0 + 40 ) == EMBEDD_RESULT_OK && fired_count == 2 && fired[1] == &timers[1] );
+
+  // the rearm after the timers are fired fails, the next process programs the alarm
+  CHECK( ds3231_timer_start( &svc, &timers[0], T0 + 50, 0 ) == EMBEDD_RESULT_OK );
+  CHECK( ds3231_timer_start( &svc, &timers[1], T0 + 70, 0 ) == EMBEDD_RESULT_OK );
+  set_time( T0 + 50 );
+  // status read, status write and time read succeed
+  sim_ds3231.fail_from = sim_ds3231.transfers + 4;
+  ds3231_timer_signal( &svc );
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_ERR );
+  CHECK( fired_count == 3 && fired[2] == &timers[0] );
+  CHECK( alarm_is( T0 + 50 ) && svc.pending && !svc.is_armed );
+  sim_ds3231.fail_from = 0;
+  CHECK( ds3231_timer_process( &svc ) == EMBEDD_RESULT_OK );
+  CHECK( alarm_is( T0 + 70 ) && svc.is_armed && !svc.pending );
+  CHECK( tick( T0 + 70 ) == EMBEDD_RESULT_OK && fired_count == 4 && fired[3] == &timers[1] );
+}
+
+int main(void)
+{
+  test_order();
+  test_periodic();
+  test_overdue();
+  test_registers();
+  test_busy();
+  test_match_failures();
+  test_rearm_failure();
+  return TEST_RESULT();
+}
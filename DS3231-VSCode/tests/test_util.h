@@ -0,0 +1,74 @@
+/*!
+ * \file test_util.h
+ * \brief Checks and timing shared by the host tests and benchmarks
+ *
+ * Software License Agreement:
+ *
+ * This code is proprietary to Embedd Limited and may not be distributed
+ * or copied without the express permission of Embedd Limited. This code
+ * is provided "as is" without warranty of any kind, either expressed or
+ * implied, including but not limited to the implied warranties of
+ * merchantability and fitness for a particular purpose. This code is intended
+ * for use only by the employees and authorized agents of Embedd Limited
+ * and its affiliates, and may not be disclosed or used for any other purpose
+ * without prior written consent from Embedd Limited.
+ *
+ * Unauthorized distribution or use of this code, or any portion of it, may
+ * result in severe civil and criminal penalties, and will be prosecuted to
+ * the maximum extent possible under the law.
+ *
+ * © 2024 Embedd Limited. All Rights Reserved.
+ */
+
+#ifndef _TESTS_TEST_UTIL_H
+#define _TESTS_TEST_UTIL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/*!
+ * \var test_failures
+ * \brief Count of failed checks of the test
+ */
+static int test_failures __attribute__((unused));
+
+/*!
+ * \macro CHECK
+ * \brief Reports a failed check with its location, the test goes on
+ *
+ * \param cond condition expected to be true
+ */
+#define CHECK(cond) do { \
+  if( !(cond) ) { \
+    fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+    ++ test_failures; \
+  } \
+} while( 0 )
+
+/*!
+ * \macro TEST_RESULT
+ * \brief Prints the summary of the test and evaluates to its exit code
+ */
+#define TEST_RESULT() \
+  ( printf( "%s: %s\n", __FILE__, test_failures ? "FAILED" : "passed" ), test_failures ? 1 : 0 )
+
+/*!
+ * \brief Returns a monotonic time in ns for the benchmarks.
+ */
+static inline uint64_t test_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * \brief Keeps the compiler from optimizing away a value computed by a benchmark.
+ */
+static inline void test_keep(uint32_t value)
+{
+  __asm__ volatile( "" : : "r"(value) : "memory" );
+}
+
+#endif//_TESTS_TEST_UTIL_H